@@ -1,6 +1,7 @@
 #include "avcodec/IAVPacket.h"
 #include "avformat/IDemuxer.h"
 #include "avformat/IMuxer.h"
+#include "avformat/IRemuxer.h"
 #include "time/Timestamp.h"
 #include "utils/Logger.h"
 
@@ -67,18 +68,21 @@ int main() {
   info.format = "mpegts";
 
   auto muxer = libffmpegxx::avformat::MuxerFactory::create(info);
-  muxer->open({});
-
-  // then, start reading packets
-  libffmpegxx::avcodec::IAVPacket *packet =
-      libffmpegxx::avcodec::AVPacketFactory::create();
-  int error;
-  do {
-    error = demuxer->read(packet);
-    muxer->write(packet);
-  } while (error >= 0);
-
-  delete packet;
+
+  // The remuxer opens the muxer, inserts the bitstream filters needed by
+  // the output format and copies the packets on its own thread.
+  auto remuxer = libffmpegxx::avformat::RemuxerFactory::create(demuxer, muxer);
+  remuxer->start();
+
+  int const error = remuxer->wait();
+  auto const stats = remuxer->getStatistics();
+  std::cout << "Remuxing finished: "
+            << libffmpegxx::utils::Logger::avErrorToStr(error) << std::endl;
+  std::cout << "Written " << stats.packets << " packets (" << stats.bytes
+            << " bytes) in " << stats.elapsed.count() << " seconds, "
+            << stats.throughput << " MB/s" << std::endl;
+
+  delete remuxer;
   delete demuxer;
   delete muxer;
 }
@@ -0,0 +1,126 @@
+#include "analysis/FrameAnalyzerImpl.h"
+
+#include "analysis/kernels.h"
+#include "avutil/AVFrameImpl.h"
+#include "utils/LoggerApi.h"
+#include "utils/exception.h"
+
+#include <algorithm>
+#include <cmath>
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+namespace libffmpegxx {
+namespace analysis {
+extern bool hasPlanarLuma8(int format);
+
+IFrameAnalyzer *
+FrameAnalyzerFactory::create(FrameAnalyzerConfig const &config) {
+  return new FrameAnalyzerImpl(config);
+}
+
+FrameAnalyzerImpl::FrameAnalyzerImpl(FrameAnalyzerConfig const &config)
+    : m_config(config), m_previous(av_frame_alloc()) {
+  if (!m_previous) {
+    LOG_FATAL("Could not allocate the frame analyzer");
+  }
+}
+
+FrameAnalyzerImpl::~FrameAnalyzerImpl() { av_frame_free(&m_previous); }
+
+FrameAnalysis FrameAnalyzerImpl::analyze(avutil::IAVFrame *frame) {
+  auto const impl = dynamic_cast<avutil::AVFrameImpl *>(frame);
+  if (!impl) {
+    LOG_FATAL("Error handling frame while analyzing");
+  }
+
+  auto const current = impl->getWrappedFrame();
+  checkFormat(current->format);
+
+  auto const &kernels = kernels::getKernels();
+  auto const width = current->width;
+  auto const height = current->height;
+  auto const lineSize = current->linesize[0];
+
+  FrameAnalysis analysis;
+  kernels::histogramPlane(current->data[0], lineSize, width, height,
+                          analysis.histogram.data());
+
+  uint64_t sum = 0;
+  uint64_t sumSq = 0;
+  for (int y = 0; y < height; ++y) {
+    kernels.sumRow(current->data[0] + static_cast<ptrdiff_t>(y) * lineSize,
+                   width, &sum, &sumSq);
+  }
+
+  auto const count = static_cast<double>(width) * height;
+  if (count > 0) {
+    analysis.mean = sum / count;
+    analysis.variance =
+        std::max(0.0, sumSq / count - analysis.mean * analysis.mean);
+  }
+
+  analysis.hasPrevious = m_previous->data[0] && m_previous->width == width &&
+                         m_previous->height == height &&
+                         m_previous->format == current->format;
+  if (analysis.hasPrevious) {
+    auto const block = kernels::BLOCK_SIZE;
+    analysis.blockColumns = (width + block - 1) / block;
+    analysis.blockSad.assign(
+        static_cast<size_t>(analysis.blockColumns) *
+            ((height + block - 1) / block),
+        0);
+
+    auto const previousLineSize = m_previous->linesize[0];
+    uint64_t sad = 0;
+    for (int y = 0; y < height; ++y) {
+      sad += kernels.sadRow(
+          current->data[0] + static_cast<ptrdiff_t>(y) * lineSize,
+          m_previous->data[0] + static_cast<ptrdiff_t>(y) * previousLineSize,
+          width,
+          analysis.blockSad.data() +
+              static_cast<size_t>(y / block) * analysis.blockColumns);
+    }
+
+    analysis.meanAbsDiff = count > 0 ? sad * 100.0 / count / 256.0 : 0.0;
+    auto const change = std::fabs(analysis.meanAbsDiff - m_previousMad);
+    analysis.sceneScore =
+        std::clamp(std::min(analysis.meanAbsDiff, change), 0.0, 100.0);
+    analysis.sceneChange = analysis.sceneScore >= m_config.sceneThreshold;
+  }
+  m_previousMad = analysis.meanAbsDiff;
+
+  av_frame_unref(m_previous);
+  if (auto const err = av_frame_ref(m_previous, current); err < 0) {
+    LOG_FATAL_FFMPEG_ERR("Could not reference the analyzed frame", err);
+  }
+
+  return analysis;
+}
+
+void FrameAnalyzerImpl::reset() {
+  av_frame_unref(m_previous);
+  m_previousMad = 0.0;
+}
+
+std::string FrameAnalyzerImpl::getKernelName() const {
+  return kernels::getKernels().name;
+}
+
+void FrameAnalyzerImpl::checkFormat(int format) {
+  if (format == m_checkedFormat) {
+    return;
+  }
+
+  if (!hasPlanarLuma8(format)) {
+    auto const name = av_get_pix_fmt_name(static_cast<AVPixelFormat>(format));
+    LOG_FATAL(std::string("Unsupported pixel format for analysis: ") +
+              (name ? name : std::to_string(format)));
+  }
+
+  m_checkedFormat = format;
+}
+}; // namespace analysis
+}; // namespace libffmpegxx
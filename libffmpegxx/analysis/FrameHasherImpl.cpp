@@ -0,0 +1,179 @@
+#include "analysis/FrameHasherImpl.h"
+
+#include "public/time/Timestamp.h"
+
+#include "analysis/kernels.h"
+#include "avutil/AVFrameImpl.h"
+#include "utils/LoggerApi.h"
+#include "utils/exception.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+namespace libffmpegxx {
+namespace analysis {
+extern bool hasPlanarLuma8(int format);
+
+namespace {
+constexpr double PI = 3.14159265358979323846;
+
+// The luma is reduced to GRID x GRID cells, of which the FREQUENCIES x
+// FREQUENCIES lowest frequencies but the DC terms are kept
+constexpr int GRID = 32;
+constexpr int FREQUENCIES = 8;
+
+using DctTable = std::array<std::array<double, GRID>, FREQUENCIES + 1>;
+
+/**
+ * @return the DCT-II basis of the kept frequencies.
+ */
+DctTable const &dctTable() {
+  static DctTable const table = [] {
+    DctTable t;
+    for (int u = 0; u <= FREQUENCIES; ++u) {
+      for (int x = 0; x < GRID; ++x) {
+        t[u][x] = std::cos((2 * x + 1) * u * PI / (2 * GRID));
+      }
+    }
+    return t;
+  }();
+  return table;
+}
+} // namespace
+
+IFrameHasher *FrameHasherFactory::create(FrameHasherConfig const &config) {
+  return new FrameHasherImpl(config);
+}
+
+FrameHasherImpl::FrameHasherImpl(FrameHasherConfig const &config)
+    : m_config(config) {
+  m_fingerprint.interval = m_config.interval;
+}
+
+FrameHash FrameHasherImpl::hash(avutil::IAVFrame *frame) {
+  auto const impl = dynamic_cast<avutil::AVFrameImpl *>(frame);
+  if (!impl) {
+    LOG_FATAL("Error handling frame while hashing");
+  }
+
+  auto const avframe = impl->getWrappedFrame();
+  checkFormat(avframe->format);
+
+  auto const width = avframe->width;
+  auto const height = avframe->height;
+  auto const lineSize = avframe->linesize[0];
+  if (width <= 0 || height <= 0) {
+    LOG_FATAL("Cannot hash an empty frame");
+  }
+
+  // Box filter: each cell is the mean of its samples. Frames smaller than
+  // the grid repeat samples.
+  auto const &kernels = kernels::getKernels();
+  m_columnSums.resize(width);
+  double cells[GRID][GRID];
+  for (int r = 0; r < GRID; ++r) {
+    auto const y0 = std::min(r * height / GRID, height - 1);
+    auto const y1 = std::max(y0 + 1, (r + 1) * height / GRID);
+
+    std::fill(m_columnSums.begin(), m_columnSums.end(), 0);
+    for (int y = y0; y < y1; ++y) {
+      kernels.accumulateRow(avframe->data[0] +
+                                static_cast<ptrdiff_t>(y) * lineSize,
+                            width, m_columnSums.data());
+    }
+
+    for (int c = 0; c < GRID; ++c) {
+      auto const x0 = std::min(c * width / GRID, width - 1);
+      auto const x1 = std::max(x0 + 1, (c + 1) * width / GRID);
+      uint64_t sum = 0;
+      for (int x = x0; x < x1; ++x) {
+        sum += m_columnSums[x];
+      }
+      cells[r][c] = static_cast<double>(sum) / ((y1 - y0) * (x1 - x0));
+    }
+  }
+
+  // Separable DCT, only for the kept frequencies
+  auto const &dct = dctTable();
+  double rows[FREQUENCIES + 1][GRID];
+  for (int u = 1; u <= FREQUENCIES; ++u) {
+    for (int c = 0; c < GRID; ++c) {
+      double sum = 0.0;
+      for (int r = 0; r < GRID; ++r) {
+        sum += dct[u][r] * cells[r][c];
+      }
+      rows[u][c] = sum;
+    }
+  }
+
+  std::array<double, FREQUENCIES * FREQUENCIES> coefficients;
+  for (int u = 1; u <= FREQUENCIES; ++u) {
+    for (int v = 1; v <= FREQUENCIES; ++v) {
+      double sum = 0.0;
+      for (int c = 0; c < GRID; ++c) {
+        sum += rows[u][c] * dct[v][c];
+      }
+      coefficients[(u - 1) * FREQUENCIES + (v - 1)] = sum;
+    }
+  }
+
+  auto sorted = coefficients;
+  auto const middle = sorted.begin() + sorted.size() / 2;
+  std::nth_element(sorted.begin(), middle, sorted.end());
+  auto const upper = *middle;
+  auto const lower = *std::max_element(sorted.begin(), middle);
+  auto const median = (lower + upper) / 2.0;
+
+  FrameHash result = 0;
+  for (size_t i = 0; i < coefficients.size(); ++i) {
+    if (coefficients[i] > median) {
+      result |= FrameHash{1} << i;
+    }
+  }
+  return result;
+}
+
+bool FrameHasherImpl::addFrame(avutil::IAVFrame *frame) {
+  auto const pts = frame->getPts();
+
+  // Frames without timestamp are always added
+  if (pts.value() != AV_NOPTS_VALUE) {
+    auto const time = pts.toSeconds();
+    if (m_lastTime && time - *m_lastTime < m_config.interval) {
+      return false;
+    }
+    m_lastTime = time;
+  }
+
+  m_fingerprint.hashes.push_back(hash(frame));
+  return true;
+}
+
+Fingerprint FrameHasherImpl::getFingerprint() const { return m_fingerprint; }
+
+void FrameHasherImpl::reset() {
+  m_fingerprint.hashes.clear();
+  m_lastTime.reset();
+}
+
+void FrameHasherImpl::checkFormat(int format) {
+  if (format == m_checkedFormat) {
+    return;
+  }
+
+  if (!hasPlanarLuma8(format)) {
+    auto const name = av_get_pix_fmt_name(static_cast<AVPixelFormat>(format));
+    LOG_FATAL(std::string("Unsupported pixel format for hashing: ") +
+              (name ? name : std::to_string(format)));
+  }
+
+  m_checkedFormat = format;
+}
+}; // namespace analysis
+}; // namespace libffmpegxx
@@ -0,0 +1,135 @@
+#include "analysis/HashMatcherImpl.h"
+
+#include "utils/LoggerApi.h"
+#include "utils/exception.h"
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
+namespace libffmpegxx {
+namespace analysis {
+IHashMatcher *HashMatcherFactory::create() { return new HashMatcherImpl(); }
+
+size_t HashMatcherImpl::add(Fingerprint const &fingerprint) {
+  auto const first = m_hashes.size();
+  if (first + fingerprint.hashes.size() >
+      std::numeric_limits<uint32_t>::max()) {
+    LOG_FATAL("Too many hashes in the matcher");
+  }
+
+  auto const id = m_fingerprintCount++;
+  for (size_t i = 0; i < fingerprint.hashes.size(); ++i) {
+    m_hashes.push_back(fingerprint.hashes[i]);
+    m_owners.push_back(static_cast<uint32_t>(id));
+    m_positions.push_back(static_cast<uint32_t>(i));
+  }
+
+  // Sorting only the new entries keeps adding linear in the stored hashes
+  for (int part = 0; part < PARTS; ++part) {
+    auto &index = m_index[part];
+    auto const middle = index.size();
+    for (auto i = first; i < m_hashes.size(); ++i) {
+      index.emplace_back(partOf(m_hashes[i], part), static_cast<uint32_t>(i));
+    }
+    std::sort(index.begin() + middle, index.end());
+    std::inplace_merge(index.begin(), index.begin() + middle, index.end());
+  }
+
+  return id;
+}
+
+std::vector<HashMatch> HashMatcherImpl::find(FrameHash hash,
+                                             int maxDistance) const {
+  std::vector<HashMatch> matches;
+  auto const addMatch = [this, &matches, hash, maxDistance](size_t i) {
+    auto const distance = hammingDistance(hash, m_hashes[i]);
+    if (distance <= maxDistance) {
+      matches.push_back({m_owners[i], m_positions[i], distance});
+    }
+  };
+
+  if (maxDistance < 0) {
+    return matches;
+  } else if (maxDistance < PARTS) {
+    // A hash within PARTS - 1 bits equals this one in at least one part
+    for (int part = 0; part < PARTS; ++part) {
+      auto const value = partOf(hash, part);
+      auto const &index = m_index[part];
+      auto it = std::lower_bound(
+          index.begin(), index.end(),
+          std::make_pair(value, uint32_t{0}));
+      for (; it != index.end() && it->first == value; ++it) {
+        // Each hash is only taken from the first part it shares
+        bool seen = false;
+        for (int previous = 0; previous < part && !seen; ++previous) {
+          seen = partOf(m_hashes[it->second], previous) ==
+                 partOf(hash, previous);
+        }
+        if (!seen) {
+          addMatch(it->second);
+        }
+      }
+    }
+  } else {
+    for (size_t i = 0; i < m_hashes.size(); ++i) {
+      addMatch(i);
+    }
+  }
+
+  std::sort(matches.begin(), matches.end(),
+            [](HashMatch const &a, HashMatch const &b) {
+              return std::tie(a.distance, a.fingerprint, a.index) <
+                     std::tie(b.distance, b.fingerprint, b.index);
+            });
+  return matches;
+}
+
+std::vector<FingerprintMatch>
+HashMatcherImpl::match(Fingerprint const &fingerprint, int maxDistance,
+                       double minRatio) const {
+  std::vector<size_t> counts(m_fingerprintCount, 0);
+  std::vector<size_t> lastQuery(m_fingerprintCount,
+                                std::numeric_limits<size_t>::max());
+
+  for (size_t q = 0; q < fingerprint.hashes.size(); ++q) {
+    for (auto const &found : find(fingerprint.hashes[q], maxDistance)) {
+      // A query hash counts once per fingerprint
+      if (lastQuery[found.fingerprint] != q) {
+        lastQuery[found.fingerprint] = q;
+        ++counts[found.fingerprint];
+      }
+    }
+  }
+
+  std::vector<FingerprintMatch> matches;
+  if (fingerprint.hashes.empty()) {
+    return matches;
+  }
+  for (size_t id = 0; id < counts.size(); ++id) {
+    auto const ratio =
+        static_cast<double>(counts[id]) / fingerprint.hashes.size();
+    if (counts[id] > 0 && ratio >= minRatio) {
+      matches.push_back({id, counts[id], ratio});
+    }
+  }
+
+  std::sort(matches.begin(), matches.end(),
+            [](FingerprintMatch const &a, FingerprintMatch const &b) {
+              return a.ratio != b.ratio ? a.ratio > b.ratio
+                                        : a.fingerprint < b.fingerprint;
+            });
+  return matches;
+}
+
+size_t HashMatcherImpl::getFingerprintCount() const {
+  return m_fingerprintCount;
+}
+
+size_t HashMatcherImpl::getHashCount() const { return m_hashes.size(); }
+
+uint16_t HashMatcherImpl::partOf(FrameHash hash, int part) {
+  return static_cast<uint16_t>(hash >> (16 * part));
+}
+}; // namespace analysis
+}; // namespace libffmpegxx
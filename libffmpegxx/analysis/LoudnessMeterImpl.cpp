@@ -0,0 +1,422 @@
+#include "analysis/LoudnessMeterImpl.h"
+
+#include "avutil/AVFrameImpl.h"
+#include "avutil/ChannelLayout.h"
+#include "utils/LoggerApi.h"
+#include "utils/exception.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace libffmpegxx {
+namespace analysis {
+namespace {
+constexpr double NO_LOUDNESS = -std::numeric_limits<double>::infinity();
+constexpr double PI = 3.14159265358979323846;
+
+// Histogram range and absolute gate, in LUFS
+constexpr double MIN_LOUDNESS = -70.0;
+constexpr double BIN_WIDTH = 0.1;
+
+double toLoudness(double energy) {
+  return energy > 0.0 ? -0.691 + 10.0 * std::log10(energy) : NO_LOUDNESS;
+}
+
+double toEnergy(double loudness) {
+  return std::pow(10.0, (loudness + 0.691) / 10.0);
+}
+
+double toDecibels(double peak) {
+  return peak > 0.0 ? 20.0 * std::log10(peak) : NO_LOUDNESS;
+}
+
+/**
+ * @return the loudness of the center of a histogram bin.
+ */
+double binLoudness(int bin) { return MIN_LOUDNESS + (bin + 0.5) * BIN_WIDTH; }
+
+double binEnergy(int bin) { return toEnergy(binLoudness(bin)); }
+
+/**
+ * @return the BS.1770 weight of a channel: surround channels count 1.5 dB
+ * more and LFE channels are left out.
+ */
+double channelWeight(uint64_t channel) {
+  if (channel & (AV_CH_LOW_FREQUENCY | AV_CH_LOW_FREQUENCY_2)) {
+    return 0.0;
+  }
+  if (channel & (AV_CH_SIDE_LEFT | AV_CH_SIDE_RIGHT | AV_CH_BACK_LEFT |
+                 AV_CH_BACK_RIGHT)) {
+    return 1.41;
+  }
+  return 1.0;
+}
+} // namespace
+
+ILoudnessMeter *
+LoudnessMeterFactory::create(LoudnessMeterConfig const &config) {
+  return new LoudnessMeterImpl(config);
+}
+
+LoudnessMeterImpl::LoudnessMeterImpl(LoudnessMeterConfig const &config)
+    : m_config(config) {
+  swresample::AudioFormat planarFloat;
+  planarFloat.sampleFormat = AV_SAMPLE_FMT_FLTP;
+  m_resampler = std::make_unique<swresample::ResamplerImpl>(planarFloat, 0);
+
+  reset();
+}
+
+void LoudnessMeterImpl::addFrame(avutil::IAVFrame *frame) {
+  auto const impl = dynamic_cast<avutil::AVFrameImpl *>(frame);
+  if (!impl) {
+    LOG_FATAL("Error handling frame while measuring loudness");
+  }
+
+  auto const input = impl->getWrappedFrame();
+  configure(input->sample_rate, avutil::getChannelMask(input));
+
+  if (input->format == AV_SAMPLE_FMT_FLTP) {
+    process(reinterpret_cast<float const *const *>(input->extended_data),
+            input->nb_samples);
+    return;
+  }
+
+  // Keeps rate and layout, so nothing is buffered between frames
+  m_resampler->resample(frame, [this](auto const &converted) {
+    auto const planar =
+        static_cast<avutil::AVFrameImpl *>(converted.get())->getWrappedFrame();
+    process(reinterpret_cast<float const *const *>(planar->extended_data),
+            planar->nb_samples);
+  });
+}
+
+Loudness LoudnessMeterImpl::getLoudness() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto loudness = m_loudness;
+  loudness.integrated = integratedOf(m_gatingBlocks);
+  loudness.range = rangeOf(m_shortTermBlocks);
+  loudness.truePeak = std::max(loudness.truePeak, loudness.samplePeak);
+  return loudness;
+}
+
+void LoudnessMeterImpl::reset() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_loudness.momentary = NO_LOUDNESS;
+    m_loudness.shortTerm = NO_LOUDNESS;
+    m_loudness.integrated = NO_LOUDNESS;
+    m_loudness.range = 0.0;
+    m_loudness.maxMomentary = NO_LOUDNESS;
+    m_loudness.maxShortTerm = NO_LOUDNESS;
+    m_loudness.samplePeak = NO_LOUDNESS;
+    m_loudness.truePeak = NO_LOUDNESS;
+    m_gatingBlocks.fill(0);
+    m_shortTermBlocks.fill(0);
+  }
+
+  // Filters are set up again for the next frame
+  m_sampleRate = 0;
+  m_channelLayout = 0;
+  m_resampler->reset();
+}
+
+void LoudnessMeterImpl::configure(int sampleRate, uint64_t channelLayout) {
+  if (sampleRate == m_sampleRate && channelLayout == m_channelLayout) {
+    return;
+  }
+  if (sampleRate <= 0 || !channelLayout) {
+    LOG_FATAL("Audio frames without sample rate or channels can not be "
+              "measured");
+  }
+  if (m_sampleRate) {
+    LOG_WARN("Audio format changed, restarting the loudness filters");
+  }
+
+  m_sampleRate = sampleRate;
+  m_channelLayout = channelLayout;
+  m_channels = avutil::getChannelCount(channelLayout);
+
+  m_weights.resize(m_channels);
+  for (int c = 0; c < m_channels; ++c) {
+    m_weights[c] =
+        channelWeight(avutil::getChannel(channelLayout, c));
+  }
+
+  // K-weighting: high shelf then high pass, designed for the sample rate as
+  // in ITU-R BS.1770-4 reference implementations
+  auto f0 = 1681.974450955533;
+  auto const gain = 3.999843853973347;
+  auto q = 0.7071752369554196;
+  auto k = std::tan(PI * f0 / sampleRate);
+  auto const vh = std::pow(10.0, gain / 20.0);
+  auto const vb = std::pow(vh, 0.4996667741545416);
+  auto a0 = 1.0 + k / q + k * k;
+  double const shelfB[3] = {(vh + vb * k / q + k * k) / a0,
+                            2.0 * (k * k - vh) / a0,
+                            (vh - vb * k / q + k * k) / a0};
+  double const shelfA[3] = {1.0, 2.0 * (k * k - 1.0) / a0,
+                            (1.0 - k / q + k * k) / a0};
+
+  f0 = 38.13547087602444;
+  q = 0.5003270373238773;
+  k = std::tan(PI * f0 / sampleRate);
+  a0 = 1.0 + k / q + k * k;
+  double const passB[3] = {1.0, -2.0, 1.0};
+  double const passA[3] = {1.0, 2.0 * (k * k - 1.0) / a0,
+                           (1.0 - k / q + k * k) / a0};
+
+  m_b.fill(0.0);
+  m_a.fill(0.0);
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      m_b[i + j] += shelfB[i] * passB[j];
+      m_a[i + j] += shelfA[i] * passA[j];
+    }
+  }
+  m_filterState.assign(m_channels, {});
+
+  m_blockSamples = (sampleRate + 5) / 10;
+  m_blockFill = 0;
+  m_blockEnergy.assign(m_channels, 0.0);
+  m_blockCount = 0;
+
+  // Oversampling up to at least 192 kHz, with a windowed sinc interpolator
+  m_oversampling = sampleRate < 96000 ? 4 : sampleRate < 192000 ? 2 : 1;
+  m_truePeakTaps = 0;
+  m_truePeakCoeffs.clear();
+  m_truePeakHistory.clear();
+  m_truePeakPos.clear();
+  if (!m_config.truePeak || m_oversampling == 1) {
+    return;
+  }
+
+  constexpr int order = 48;
+  m_truePeakTaps = (order + 1 + m_oversampling - 1) / m_oversampling;
+  m_truePeakCoeffs.assign(
+      static_cast<size_t>(m_truePeakTaps) * m_oversampling, 0.0f);
+  for (int j = 0; j <= order; ++j) {
+    auto const m = j - order / 2.0;
+    auto const x = m * PI / m_oversampling;
+    auto c = std::fabs(m) > 1e-6 ? std::sin(x) / x : 1.0;
+    c *= 0.5 * (1.0 - std::cos(2.0 * PI * j / order));
+    // Tap j / factor of phase j % factor, phases interleaved per tap
+    m_truePeakCoeffs[j] = static_cast<float>(c);
+  }
+
+  m_truePeakHistory.assign(
+      m_channels, std::vector<float>(2 * static_cast<size_t>(m_truePeakTaps)));
+  m_truePeakPos.assign(m_channels, 0);
+}
+
+void LoudnessMeterImpl::process(float const *const *data, int samples) {
+  float samplePeak = 0.0f;
+  for (int c = 0; c < m_channels; ++c) {
+    auto const channel = data[c];
+    for (int i = 0; i < samples; ++i) {
+      samplePeak = std::max(samplePeak, std::fabs(channel[i]));
+    }
+
+    if (m_oversampling == 4 && m_truePeakTaps) {
+      measureTruePeak<4>(c, channel, samples);
+    } else if (m_oversampling == 2 && m_truePeakTaps) {
+      measureTruePeak<2>(c, channel, samples);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_loudness.samplePeak =
+        std::max(m_loudness.samplePeak, toDecibels(samplePeak));
+  }
+
+  int offset = 0;
+  while (offset < samples) {
+    auto const count = std::min(samples - offset, m_blockSamples - m_blockFill);
+
+    for (int c = 0; c < m_channels; ++c) {
+      if (m_weights[c] == 0.0) {
+        continue;
+      }
+
+      // The filter recursion runs along time, so channels are filtered one
+      // after the other with the state kept in registers
+      auto const input = data[c] + offset;
+      auto state = m_filterState[c];
+      double energy = 0.0;
+      for (int i = 0; i < count; ++i) {
+        auto const v0 = input[i] - m_a[1] * state[0] - m_a[2] * state[1] -
+                        m_a[3] * state[2] - m_a[4] * state[3];
+        auto const y = m_b[0] * v0 + m_b[1] * state[0] + m_b[2] * state[1] +
+                       m_b[3] * state[2] + m_b[4] * state[3];
+        state[3] = state[2];
+        state[2] = state[1];
+        state[1] = state[0];
+        state[0] = v0;
+        energy += y * y;
+      }
+
+      // Flush denormals, as silence decays towards them
+      for (auto &&v : state) {
+        if (std::fabs(v) < std::numeric_limits<float>::min()) {
+          v = 0.0;
+        }
+      }
+      m_filterState[c] = state;
+      m_blockEnergy[c] += energy;
+    }
+
+    offset += count;
+    m_blockFill += count;
+    if (m_blockFill == m_blockSamples) {
+      endBlock();
+    }
+  }
+}
+
+void LoudnessMeterImpl::endBlock() {
+  double energy = 0.0;
+  for (int c = 0; c < m_channels; ++c) {
+    energy += m_weights[c] * m_blockEnergy[c] / m_blockSamples;
+    m_blockEnergy[c] = 0.0;
+  }
+  m_blockFill = 0;
+
+  m_blocks[m_blockCount % SHORT_TERM_BLOCKS] = energy;
+  ++m_blockCount;
+
+  // Mean energy of the last blocks
+  auto const meanOf = [this](int count) {
+    double sum = 0.0;
+    for (int i = 1; i <= count; ++i) {
+      sum += m_blocks[(m_blockCount - i) % SHORT_TERM_BLOCKS];
+    }
+    return sum / count;
+  };
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  // 400 ms gating blocks overlap by 75%, i.e. one every 100 ms
+  if (m_blockCount >= MOMENTARY_BLOCKS) {
+    auto const loudness = toLoudness(meanOf(MOMENTARY_BLOCKS));
+    m_loudness.momentary = loudness;
+    m_loudness.maxMomentary = std::max(m_loudness.maxMomentary, loudness);
+    if (loudness >= MIN_LOUDNESS) {
+      ++m_gatingBlocks[binOf(loudness)];
+    }
+  }
+
+  if (m_blockCount >= SHORT_TERM_BLOCKS) {
+    auto const loudness = toLoudness(meanOf(SHORT_TERM_BLOCKS));
+    m_loudness.shortTerm = loudness;
+    m_loudness.maxShortTerm = std::max(m_loudness.maxShortTerm, loudness);
+    if (loudness >= MIN_LOUDNESS) {
+      ++m_shortTermBlocks[binOf(loudness)];
+    }
+  }
+}
+
+template <int Factor>
+void LoudnessMeterImpl::measureTruePeak(int channel, float const *samples,
+                                        int count) {
+  auto const taps = m_truePeakTaps;
+  auto const coeffs = m_truePeakCoeffs.data();
+  auto const history = m_truePeakHistory[channel].data();
+  auto pos = m_truePeakPos[channel];
+
+  float peak = 0.0f;
+  for (int i = 0; i < count; ++i) {
+    // Newest sample first, stored twice so the taps are contiguous
+    pos = pos == 0 ? taps - 1 : pos - 1;
+    history[pos] = history[pos + taps] = samples[i];
+
+    // The phases are independent lanes, so this loop vectorizes without
+    // reordering any sum
+    float out[Factor] = {};
+    for (int t = 0; t < taps; ++t) {
+      auto const x = history[pos + t];
+      for (int p = 0; p < Factor; ++p) {
+        out[p] += coeffs[t * Factor + p] * x;
+      }
+    }
+    for (int p = 0; p < Factor; ++p) {
+      peak = std::max(peak, std::fabs(out[p]));
+    }
+  }
+  m_truePeakPos[channel] = pos;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_loudness.truePeak = std::max(m_loudness.truePeak, toDecibels(peak));
+}
+
+int LoudnessMeterImpl::binOf(double loudness) {
+  auto const bin =
+      static_cast<int>(std::floor((loudness - MIN_LOUDNESS) / BIN_WIDTH));
+  return std::clamp(bin, 0, HISTOGRAM_BINS - 1);
+}
+
+double LoudnessMeterImpl::integratedOf(Histogram const &histogram) {
+  double energy = 0.0;
+  uint64_t count = 0;
+  for (int i = 0; i < HISTOGRAM_BINS; ++i) {
+    energy += histogram[i] * binEnergy(i);
+    count += histogram[i];
+  }
+  if (count == 0) {
+    return NO_LOUDNESS;
+  }
+
+  // Relative gate, 10 LU below the absolute gated loudness
+  auto const gate = toLoudness(energy / count) - 10.0;
+  energy = 0.0;
+  count = 0;
+  for (int i = gate < MIN_LOUDNESS ? 0 : binOf(gate); i < HISTOGRAM_BINS;
+       ++i) {
+    energy += histogram[i] * binEnergy(i);
+    count += histogram[i];
+  }
+
+  return count ? toLoudness(energy / count) : NO_LOUDNESS;
+}
+
+double LoudnessMeterImpl::rangeOf(Histogram const &histogram) {
+  double energy = 0.0;
+  uint64_t count = 0;
+  for (int i = 0; i < HISTOGRAM_BINS; ++i) {
+    energy += histogram[i] * binEnergy(i);
+    count += histogram[i];
+  }
+  if (count == 0) {
+    return 0.0;
+  }
+
+  // Relative gate 20 LU below, then the 10th to 95th percentile spread
+  auto const gate = toLoudness(energy / count) - 20.0;
+  auto const first = gate < MIN_LOUDNESS ? 0 : binOf(gate);
+  count = 0;
+  for (int i = first; i < HISTOGRAM_BINS; ++i) {
+    count += histogram[i];
+  }
+  if (count == 0) {
+    return 0.0;
+  }
+
+  // Loudness of the bin holding the block of a given rank
+  auto const percentile = [&histogram, first](uint64_t rank) {
+    uint64_t seen = 0;
+    for (int i = first; i < HISTOGRAM_BINS; ++i) {
+      seen += histogram[i];
+      if (seen > rank) {
+        return binLoudness(i);
+      }
+    }
+    return binLoudness(HISTOGRAM_BINS - 1);
+  };
+
+  return percentile(static_cast<uint64_t>((count - 1) * 0.95 + 0.5)) -
+         percentile(static_cast<uint64_t>((count - 1) * 0.1 + 0.5));
+}
+}; // namespace analysis
+}; // namespace libffmpegxx
@@ -0,0 +1,300 @@
+#include "analysis/QualityMeterImpl.h"
+
+#include "analysis/kernels.h"
+#include "avutil/AVFrameImpl.h"
+#include "utils/LoggerApi.h"
+#include "utils/exception.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+extern "C" {
+#include <libavutil/common.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace libffmpegxx {
+namespace analysis {
+namespace {
+// Bands shorter than this cost more to hand out than to compare
+constexpr int MIN_BAND_ROWS = 32;
+
+/**
+ * @return the PSNR of an 8 bit MSE.
+ */
+double toPsnr(double mse) {
+  if (mse <= 0.0) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+/**
+ * @return the SSIM of an 8x8 window from its sums, as in FFmpeg's ssim
+ * filter.
+ */
+double windowSsim(int64_t s1, int64_t s2, int64_t ss, int64_t s12) {
+  constexpr double c1 = .01 * .01 * 255 * 255 * 64;
+  constexpr double c2 = .03 * .03 * 255 * 255 * 64 * 63;
+
+  auto const vars = ss * 64 - s1 * s1 - s2 * s2;
+  auto const covar = s12 * 64 - s1 * s2;
+  return (2.0 * s1 * s2 + c1) * (2.0 * covar + c2) /
+         ((static_cast<double>(s1 * s1 + s2 * s2) + c1) * (vars + c2));
+}
+
+/**
+ * @return the frame wrapped by a frame interface.
+ */
+AVFrame *unwrap(avutil::IAVFrame *frame) {
+  auto const impl = dynamic_cast<avutil::AVFrameImpl *>(frame);
+  if (!impl) {
+    LOG_FATAL("Error handling frame while measuring quality");
+  }
+  return impl->getWrappedFrame();
+}
+} // namespace
+
+IQualityMeter *QualityMeterFactory::create(QualityMeterConfig const &config) {
+  return new QualityMeterImpl(config);
+}
+
+QualityMeterImpl::QualityMeterImpl(QualityMeterConfig const &config)
+    : m_config(config),
+      m_threads(utils::ThreadPool::resolveThreads(config.threads)),
+      m_threadPool(utils::ThreadPool::createForCaller(m_threads)) {}
+
+FrameQuality QualityMeterImpl::compare(avutil::IAVFrame *reference,
+                                       avutil::IAVFrame *distorted) {
+  auto const ref = unwrap(reference);
+  auto const dist = unwrap(distorted);
+  if (ref->width != dist->width || ref->height != dist->height ||
+      ref->format != dist->format) {
+    LOG_FATAL("Frames compared for quality differ in size or format");
+  }
+
+  prepareBands(ref);
+
+  if (m_threadPool && m_bands.size() > 1) {
+    m_threadPool->parallelFor(m_bands.size(), [&](size_t i) {
+      compareBand(m_bands[i], ref, dist);
+    });
+  } else {
+    for (auto &&band : m_bands) {
+      compareBand(band, ref, dist);
+    }
+  }
+
+  auto const planeCount = m_planeWidths.size();
+  std::vector<uint64_t> sse(planeCount, 0);
+  std::vector<double> ssim(planeCount, 0.0);
+  for (auto const &band : m_bands) {
+    sse[band.plane] += band.sse;
+    ssim[band.plane] += band.ssim;
+  }
+
+  FrameQuality quality;
+  quality.planes.resize(planeCount);
+
+  double totalSse = 0.0;
+  double totalSamples = 0.0;
+  double weightedSsim = 0.0;
+  for (size_t p = 0; p < planeCount; ++p) {
+    auto const width = m_planeWidths[p];
+    auto const height = m_planeHeights[p];
+    auto const samples = static_cast<double>(width) * height;
+
+    auto &plane = quality.planes[p];
+    plane.mse = samples > 0 ? sse[p] / samples : 0.0;
+    plane.psnr = toPsnr(plane.mse);
+
+    auto const windows =
+        static_cast<double>((width >> 2) - 1) * ((height >> 2) - 1);
+    if (m_config.ssim && width >= 8 && height >= 8) {
+      plane.ssim = ssim[p] / windows;
+    }
+
+    totalSse += sse[p];
+    totalSamples += samples;
+    weightedSsim += plane.ssim * samples;
+  }
+
+  if (totalSamples > 0) {
+    quality.mse = totalSse / totalSamples;
+    quality.psnr = toPsnr(quality.mse);
+    quality.ssim = weightedSsim / totalSamples;
+  }
+
+  accumulate(quality);
+  return quality;
+}
+
+StreamQuality QualityMeterImpl::getStreamQuality() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  StreamQuality quality;
+  quality.frameCount = m_frameCount;
+  if (m_frameCount == 0) {
+    return quality;
+  }
+
+  quality.planes.resize(m_planeMseSum.size());
+  for (size_t p = 0; p < m_planeMseSum.size(); ++p) {
+    auto &plane = quality.planes[p];
+    plane.mse = m_planeMseSum[p] / m_frameCount;
+    plane.psnr = toPsnr(plane.mse);
+    plane.ssim = m_planeSsimSum[p] / m_frameCount;
+  }
+
+  quality.mse = m_mseSum / m_frameCount;
+  quality.psnr = toPsnr(quality.mse);
+  quality.ssim = m_ssimSum / m_frameCount;
+  quality.minPsnr = m_minPsnr;
+  quality.minSsim = m_minSsim;
+  return quality;
+}
+
+void QualityMeterImpl::reset() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_frameCount = 0;
+  m_planeMseSum.clear();
+  m_planeSsimSum.clear();
+  m_mseSum = 0.0;
+  m_ssimSum = 0.0;
+  m_minPsnr = 0.0;
+  m_minSsim = 1.0;
+}
+
+std::string QualityMeterImpl::getKernelName() const {
+  return kernels::getKernels().name;
+}
+
+void QualityMeterImpl::prepareBands(AVFrame const *frame) {
+  if (frame->width == m_width && frame->height == m_height &&
+      frame->format == m_format) {
+    return;
+  }
+
+  auto const format = static_cast<AVPixelFormat>(frame->format);
+  auto const desc = av_pix_fmt_desc_get(format);
+  auto supported =
+      desc && !(desc->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_HWACCEL |
+                               AV_PIX_FMT_FLAG_BITSTREAM));
+  for (int c = 0; supported && c < desc->nb_components; ++c) {
+    // One 8 bit sample per byte, each component on its own plane
+    supported = desc->comp[c].depth == 8 && desc->comp[c].step == 1 &&
+                desc->comp[c].shift == 0;
+  }
+  if (!supported) {
+    LOG_FATAL(std::string("Unsupported pixel format for quality metrics: ") +
+              (desc ? desc->name : std::to_string(frame->format)));
+  }
+
+  auto const planeCount = av_pix_fmt_count_planes(format);
+  m_planeWidths.assign(planeCount, frame->width);
+  m_planeHeights.assign(planeCount, frame->height);
+  for (int p = 1; p < std::min(planeCount, 3); ++p) {
+    m_planeWidths[p] = AV_CEIL_RSHIFT(frame->width, desc->log2_chroma_w);
+    m_planeHeights[p] = AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h);
+  }
+
+  m_bands.clear();
+  for (int p = 0; p < planeCount; ++p) {
+    auto const height = m_planeHeights[p];
+    auto const windows = std::max(0, (height >> 2) - 1);
+    auto const count = static_cast<int>(
+        std::clamp<size_t>(height / MIN_BAND_ROWS, 1, m_threads));
+
+    for (int i = 0; i < count; ++i) {
+      Band band;
+      band.plane = p;
+      band.firstRow = height * i / count;
+      band.lastRow = height * (i + 1) / count;
+      band.firstWindow = windows * i / count;
+      band.lastWindow = windows * (i + 1) / count;
+      band.sums.resize(2 * 4 * static_cast<size_t>(m_planeWidths[p] >> 2));
+      m_bands.push_back(std::move(band));
+    }
+  }
+
+  m_width = frame->width;
+  m_height = frame->height;
+  m_format = frame->format;
+}
+
+void QualityMeterImpl::compareBand(Band &band, AVFrame const *reference,
+                                   AVFrame const *distorted) const {
+  auto const &kernels = kernels::getKernels();
+  auto const width = m_planeWidths[band.plane];
+  auto const refData = reference->data[band.plane];
+  auto const distData = distorted->data[band.plane];
+  auto const refLineSize = reference->linesize[band.plane];
+  auto const distLineSize = distorted->linesize[band.plane];
+
+  auto const refRow = [&](int y) {
+    return refData + static_cast<ptrdiff_t>(y) * refLineSize;
+  };
+  auto const distRow = [&](int y) {
+    return distData + static_cast<ptrdiff_t>(y) * distLineSize;
+  };
+
+  band.sse = 0;
+  for (int y = band.firstRow; y < band.lastRow; ++y) {
+    band.sse += kernels.sseRow(refRow(y), distRow(y), width);
+  }
+
+  band.ssim = 0.0;
+  if (!m_config.ssim || band.firstWindow >= band.lastWindow) {
+    return;
+  }
+
+  // Window j covers the 4x4 block rows j and j + 1
+  auto const blocks = width >> 2;
+  auto current = reinterpret_cast<int32_t(*)[4]>(band.sums.data());
+  auto next = current + blocks;
+  kernels.ssimRow(refRow(4 * band.firstWindow), refLineSize,
+                  distRow(4 * band.firstWindow), distLineSize, blocks,
+                  current);
+
+  for (int j = band.firstWindow; j < band.lastWindow; ++j) {
+    kernels.ssimRow(refRow(4 * (j + 1)), refLineSize, distRow(4 * (j + 1)),
+                    distLineSize, blocks, next);
+    for (int x = 0; x + 1 < blocks; ++x) {
+      int64_t s[4];
+      for (int i = 0; i < 4; ++i) {
+        s[i] = int64_t{current[x][i]} + current[x + 1][i] + next[x][i] +
+               next[x + 1][i];
+      }
+      band.ssim += windowSsim(s[0], s[1], s[2], s[3]);
+    }
+    std::swap(current, next);
+  }
+}
+
+void QualityMeterImpl::accumulate(FrameQuality const &quality) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_planeMseSum.size() != quality.planes.size()) {
+    if (m_frameCount > 0) {
+      LOG_WARN("Plane count changed, restarting the per-plane quality");
+    }
+    m_planeMseSum.assign(quality.planes.size(), 0.0);
+    m_planeSsimSum.assign(quality.planes.size(), 0.0);
+  }
+
+  for (size_t p = 0; p < quality.planes.size(); ++p) {
+    m_planeMseSum[p] += quality.planes[p].mse;
+    m_planeSsimSum[p] += quality.planes[p].ssim;
+  }
+
+  m_mseSum += quality.mse;
+  m_ssimSum += quality.ssim;
+  m_minPsnr = m_frameCount == 0 ? quality.psnr
+                                : std::min(m_minPsnr, quality.psnr);
+  m_minSsim = std::min(m_minSsim, quality.ssim);
+  ++m_frameCount;
+}
+}; // namespace analysis
+}; // namespace libffmpegxx
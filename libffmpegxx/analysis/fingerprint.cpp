@@ -0,0 +1,79 @@
+#include "public/analysis/IFrameHasher.h"
+
+#include "utils/LoggerApi.h"
+#include "utils/exception.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace libffmpegxx {
+namespace analysis {
+namespace {
+constexpr char MAGIC[4] = {'F', 'X', 'F', 'P'};
+constexpr uint8_t VERSION = 1;
+constexpr size_t HEADER_SIZE = 16;
+
+void writeLE(std::vector<uint8_t> &out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i) {
+    out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+uint64_t readLE(uint8_t const *in, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; ++i) {
+    value |= uint64_t{in[i]} << (8 * i);
+  }
+  return value;
+}
+} // namespace
+
+std::vector<uint8_t> serializeFingerprint(Fingerprint const &fingerprint) {
+  auto const intervalMs = std::llround(fingerprint.interval.count() * 1000.);
+  if (intervalMs < 0 || intervalMs > std::numeric_limits<uint32_t>::max() ||
+      fingerprint.hashes.size() > std::numeric_limits<uint32_t>::max()) {
+    LOG_FATAL("Fingerprint too large to serialize");
+  }
+
+  std::vector<uint8_t> out;
+  out.reserve(HEADER_SIZE + 8 * fingerprint.hashes.size());
+  out.insert(out.end(), MAGIC, MAGIC + sizeof(MAGIC));
+  out.push_back(VERSION);
+  // Hash size in bits, then 2 reserved bytes
+  out.push_back(64);
+  writeLE(out, 0, 2);
+  writeLE(out, static_cast<uint64_t>(intervalMs), 4);
+  writeLE(out, fingerprint.hashes.size(), 4);
+
+  for (auto const hash : fingerprint.hashes) {
+    writeLE(out, hash, 8);
+  }
+  return out;
+}
+
+Fingerprint deserializeFingerprint(std::vector<uint8_t> const &data) {
+  if (data.size() < HEADER_SIZE ||
+      std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) {
+    LOG_FATAL("Not a fingerprint");
+  }
+  if (data[4] != VERSION || data[5] != 64) {
+    LOG_FATAL("Unsupported fingerprint version " + std::to_string(data[4]));
+  }
+
+  auto const count = readLE(data.data() + 12, 4);
+  if (data.size() != HEADER_SIZE + 8 * count) {
+    LOG_FATAL("Truncated fingerprint");
+  }
+
+  Fingerprint fingerprint;
+  fingerprint.interval =
+      time::Seconds(static_cast<double>(readLE(data.data() + 8, 4)) / 1000.);
+  fingerprint.hashes.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    fingerprint.hashes.push_back(readLE(data.data() + HEADER_SIZE + 8 * i, 8));
+  }
+  return fingerprint;
+}
+}; // namespace analysis
+}; // namespace libffmpegxx
@@ -0,0 +1,17 @@
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+namespace libffmpegxx {
+namespace analysis {
+bool hasPlanarLuma8(int format) {
+  auto const desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(format));
+  return desc &&
+         !(desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL |
+                          AV_PIX_FMT_FLAG_HWACCEL |
+                          AV_PIX_FMT_FLAG_BITSTREAM)) &&
+         desc->comp[0].plane == 0 && desc->comp[0].step == 1 &&
+         desc->comp[0].depth == 8 && desc->comp[0].shift == 0;
+}
+}; // namespace analysis
+}; // namespace libffmpegxx
@@ -0,0 +1,67 @@
+#include "analysis/kernels.h"
+
+#include "utils/LoggerApi.h"
+
+#include <cstring>
+#include <string>
+
+namespace libffmpegxx {
+namespace analysis {
+namespace kernels {
+namespace {
+KernelSet const &detectKernels() {
+#if ANALYSIS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return getAvx2Kernels();
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return getSse2Kernels();
+  }
+#endif
+
+#if ANALYSIS_NEON
+  return getNeonKernels();
+#else
+  return getScalarKernels();
+#endif
+}
+} // namespace
+
+KernelSet const &getKernels() {
+  static KernelSet const &kernels = []() -> KernelSet const & {
+    auto const &detected = detectKernels();
+    LOG_DEBUG(std::string("Frame analysis kernels: ") + detected.name);
+    return detected;
+  }();
+  return kernels;
+}
+
+void histogramPlane(uint8_t const *data, int lineSize, int width, int height,
+                    uint32_t *hist) {
+  // Separate sub-histograms so runs of equal samples do not serialize on
+  // the same counter
+  uint32_t partial[4][256];
+  std::memset(partial, 0, sizeof(partial));
+
+  for (int y = 0; y < height; ++y) {
+    auto const row = data + static_cast<ptrdiff_t>(y) * lineSize;
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+      ++partial[0][row[x]];
+      ++partial[1][row[x + 1]];
+      ++partial[2][row[x + 2]];
+      ++partial[3][row[x + 3]];
+    }
+    for (; x < width; ++x) {
+      ++partial[0][row[x]];
+    }
+  }
+
+  for (int i = 0; i < 256; ++i) {
+    hist[i] += partial[0][i] + partial[1][i] + partial[2][i] + partial[3][i];
+  }
+}
+}; // namespace kernels
+}; // namespace analysis
+}; // namespace libffmpegxx
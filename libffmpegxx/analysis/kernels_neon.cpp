@@ -0,0 +1,122 @@
+#include "analysis/kernels.h"
+
+#if ANALYSIS_NEON
+
+#include <arm_neon.h>
+
+#include <cstdlib>
+
+namespace libffmpegxx {
+namespace analysis {
+namespace kernels {
+namespace {
+uint64_t sumLanes(uint64x2_t v) {
+  return vgetq_lane_u64(v, 0) + vgetq_lane_u64(v, 1);
+}
+
+void sumRowNeon(uint8_t const *row, int width, uint64_t *sum,
+                uint64_t *sumSq) {
+  auto s = vdupq_n_u64(0);
+  auto sq = vdupq_n_u64(0);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    auto const v = vld1q_u8(row + x);
+    s = vpadalq_u32(s, vpaddlq_u16(vpaddlq_u8(v)));
+
+    // 255 * 255 still fits the 16 bit products
+    auto const lo = vmull_u8(vget_low_u8(v), vget_low_u8(v));
+    auto const hi = vmull_u8(vget_high_u8(v), vget_high_u8(v));
+    sq = vpadalq_u32(sq, vaddq_u32(vpaddlq_u16(lo), vpaddlq_u16(hi)));
+  }
+  *sum += sumLanes(s);
+  *sumSq += sumLanes(sq);
+
+  for (; x < width; ++x) {
+    uint32_t const v = row[x];
+    *sum += v;
+    *sumSq += v * v;
+  }
+}
+
+uint64_t sadRowNeon(uint8_t const *a, uint8_t const *b, int width,
+                    uint32_t *blocks) {
+  uint64_t total = 0;
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    auto const diff = vabdq_u8(vld1q_u8(a + x), vld1q_u8(b + x));
+    auto const sad = static_cast<uint32_t>(
+        sumLanes(vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(diff)))));
+    blocks[x / BLOCK_SIZE] += sad;
+    total += sad;
+  }
+  for (; x < width; ++x) {
+    auto const sad = static_cast<uint32_t>(std::abs(a[x] - b[x]));
+    blocks[x / BLOCK_SIZE] += sad;
+    total += sad;
+  }
+  return total;
+}
+
+uint64_t sseRowNeon(uint8_t const *a, uint8_t const *b, int width) {
+  auto acc = vdupq_n_u64(0);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    auto const diff = vabdq_u8(vld1q_u8(a + x), vld1q_u8(b + x));
+    auto const lo = vmull_u8(vget_low_u8(diff), vget_low_u8(diff));
+    auto const hi = vmull_u8(vget_high_u8(diff), vget_high_u8(diff));
+    acc = vpadalq_u32(acc, vaddq_u32(vpaddlq_u16(lo), vpaddlq_u16(hi)));
+  }
+  return sumLanes(acc) +
+         getScalarKernels().sseRow(a + x, b + x, width - x);
+}
+
+void ssimRowNeon(uint8_t const *a, int aLineSize, uint8_t const *b,
+                 int bLineSize, int blocks, int32_t (*sums)[4]) {
+  int z = 0;
+  for (; z + 2 <= blocks; z += 2) {
+    // Sums of sample pairs, reduced to the two blocks at the end
+    uint32x4_t acc[4] = {vdupq_n_u32(0), vdupq_n_u32(0), vdupq_n_u32(0),
+                         vdupq_n_u32(0)};
+    for (int y = 0; y < 4; ++y) {
+      auto const va = vld1_u8(a + y * aLineSize + 4 * z);
+      auto const vb = vld1_u8(b + y * bLineSize + 4 * z);
+      acc[0] = vaddq_u32(acc[0], vpaddlq_u16(vmovl_u8(va)));
+      acc[1] = vaddq_u32(acc[1], vpaddlq_u16(vmovl_u8(vb)));
+      acc[2] = vaddq_u32(acc[2], vaddq_u32(vpaddlq_u16(vmull_u8(va, va)),
+                                           vpaddlq_u16(vmull_u8(vb, vb))));
+      acc[3] = vaddq_u32(acc[3], vpaddlq_u16(vmull_u8(va, vb)));
+    }
+    for (int i = 0; i < 4; ++i) {
+      auto const blockSums =
+          vpadd_u32(vget_low_u32(acc[i]), vget_high_u32(acc[i]));
+      sums[z][i] = static_cast<int32_t>(vget_lane_u32(blockSums, 0));
+      sums[z + 1][i] = static_cast<int32_t>(vget_lane_u32(blockSums, 1));
+    }
+  }
+  getScalarKernels().ssimRow(a + 4 * z, aLineSize, b + 4 * z, bLineSize,
+                             blocks - z, sums + z);
+}
+
+void accumulateRowNeon(uint8_t const *row, int width, uint32_t *sums) {
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    auto const v = vmovl_u8(vld1_u8(row + x));
+    vst1q_u32(sums + x, vaddw_u16(vld1q_u32(sums + x), vget_low_u16(v)));
+    vst1q_u32(sums + x + 4,
+              vaddw_u16(vld1q_u32(sums + x + 4), vget_high_u16(v)));
+  }
+  getScalarKernels().accumulateRow(row + x, width - x, sums + x);
+}
+} // namespace
+
+KernelSet const &getNeonKernels() {
+  static KernelSet const kernels{"neon", sumRowNeon, sadRowNeon,
+                                  sseRowNeon, ssimRowNeon,
+                                  accumulateRowNeon};
+  return kernels;
+}
+}; // namespace kernels
+}; // namespace analysis
+}; // namespace libffmpegxx
+
+#endif
@@ -0,0 +1,85 @@
+#include "analysis/kernels.h"
+
+#include <cstdlib>
+
+namespace libffmpegxx {
+namespace analysis {
+namespace kernels {
+namespace {
+void sumRowScalar(uint8_t const *row, int width, uint64_t *sum,
+                  uint64_t *sumSq) {
+  uint64_t s = 0;
+  uint64_t sq = 0;
+  for (int x = 0; x < width; ++x) {
+    uint32_t const v = row[x];
+    s += v;
+    sq += v * v;
+  }
+  *sum += s;
+  *sumSq += sq;
+}
+
+uint64_t sadRowScalar(uint8_t const *a, uint8_t const *b, int width,
+                      uint32_t *blocks) {
+  uint64_t total = 0;
+  for (int x = 0; x < width; x += BLOCK_SIZE) {
+    auto const end = x + BLOCK_SIZE < width ? x + BLOCK_SIZE : width;
+    uint32_t sad = 0;
+    for (int i = x; i < end; ++i) {
+      sad += static_cast<uint32_t>(std::abs(a[i] - b[i]));
+    }
+    blocks[x / BLOCK_SIZE] += sad;
+    total += sad;
+  }
+  return total;
+}
+
+uint64_t sseRowScalar(uint8_t const *a, uint8_t const *b, int width) {
+  uint64_t sse = 0;
+  for (int x = 0; x < width; ++x) {
+    int32_t const diff = a[x] - b[x];
+    sse += static_cast<uint32_t>(diff * diff);
+  }
+  return sse;
+}
+
+void ssimRowScalar(uint8_t const *a, int aLineSize, uint8_t const *b,
+                   int bLineSize, int blocks, int32_t (*sums)[4]) {
+  for (int z = 0; z < blocks; ++z) {
+    int32_t s1 = 0;
+    int32_t s2 = 0;
+    int32_t ss = 0;
+    int32_t s12 = 0;
+    for (int y = 0; y < 4; ++y) {
+      for (int x = 0; x < 4; ++x) {
+        int32_t const va = a[y * aLineSize + 4 * z + x];
+        int32_t const vb = b[y * bLineSize + 4 * z + x];
+        s1 += va;
+        s2 += vb;
+        ss += va * va + vb * vb;
+        s12 += va * vb;
+      }
+    }
+    sums[z][0] = s1;
+    sums[z][1] = s2;
+    sums[z][2] = ss;
+    sums[z][3] = s12;
+  }
+}
+
+void accumulateRowScalar(uint8_t const *row, int width, uint32_t *sums) {
+  for (int x = 0; x < width; ++x) {
+    sums[x] += row[x];
+  }
+}
+} // namespace
+
+KernelSet const &getScalarKernels() {
+  static KernelSet const kernels{"scalar", sumRowScalar, sadRowScalar,
+                                  sseRowScalar, ssimRowScalar,
+                                  accumulateRowScalar};
+  return kernels;
+}
+}; // namespace kernels
+}; // namespace analysis
+}; // namespace libffmpegxx
@@ -0,0 +1,345 @@
+#include "analysis/kernels.h"
+
+#if ANALYSIS_X86
+
+#include <immintrin.h>
+
+#include <cstdlib>
+
+namespace libffmpegxx {
+namespace analysis {
+namespace kernels {
+namespace {
+// Iterations before the 32 bit sums of squares are widened, well below
+// their overflow
+constexpr int SQ_FLUSH_ITERATIONS = 4096;
+
+__attribute__((target("sse2"))) uint64_t sumLanes(__m128i v) {
+  alignas(16) uint64_t lanes[2];
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes), v);
+  return lanes[0] + lanes[1];
+}
+
+__attribute__((target("sse2"))) uint64_t widenSq(__m128i sq) {
+  auto const zero = _mm_setzero_si128();
+  return sumLanes(_mm_add_epi64(_mm_unpacklo_epi32(sq, zero),
+                                _mm_unpackhi_epi32(sq, zero)));
+}
+
+void sumTail(uint8_t const *row, int x, int width, uint64_t *sum,
+             uint64_t *sumSq) {
+  for (; x < width; ++x) {
+    uint32_t const v = row[x];
+    *sum += v;
+    *sumSq += v * v;
+  }
+}
+
+uint32_t sadTail(uint8_t const *a, uint8_t const *b, int x, int width,
+                 uint32_t *blocks) {
+  uint32_t total = 0;
+  for (; x < width; ++x) {
+    auto const sad = static_cast<uint32_t>(std::abs(a[x] - b[x]));
+    blocks[x / BLOCK_SIZE] += sad;
+    total += sad;
+  }
+  return total;
+}
+
+__attribute__((target("sse2"))) void
+sumRowSse2(uint8_t const *row, int width, uint64_t *sum, uint64_t *sumSq) {
+  auto const zero = _mm_setzero_si128();
+  auto s = zero;
+  auto sq = zero;
+  int x = 0;
+  int pending = 0;
+  for (; x + 16 <= width; x += 16) {
+    auto const v =
+        _mm_loadu_si128(reinterpret_cast<__m128i const *>(row + x));
+    s = _mm_add_epi64(s, _mm_sad_epu8(v, zero));
+
+    auto const lo = _mm_unpacklo_epi8(v, zero);
+    auto const hi = _mm_unpackhi_epi8(v, zero);
+    sq = _mm_add_epi32(sq, _mm_add_epi32(_mm_madd_epi16(lo, lo),
+                                         _mm_madd_epi16(hi, hi)));
+    if (++pending == SQ_FLUSH_ITERATIONS) {
+      *sumSq += widenSq(sq);
+      sq = zero;
+      pending = 0;
+    }
+  }
+  *sum += sumLanes(s);
+  *sumSq += widenSq(sq);
+  sumTail(row, x, width, sum, sumSq);
+}
+
+__attribute__((target("sse2"))) uint64_t sadRowSse2(uint8_t const *a,
+                                                     uint8_t const *b,
+                                                     int width,
+                                                     uint32_t *blocks) {
+  uint64_t total = 0;
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    auto const sad = _mm_sad_epu8(
+        _mm_loadu_si128(reinterpret_cast<__m128i const *>(a + x)),
+        _mm_loadu_si128(reinterpret_cast<__m128i const *>(b + x)));
+    auto const blockSad = static_cast<uint32_t>(sumLanes(sad));
+    blocks[x / BLOCK_SIZE] += blockSad;
+    total += blockSad;
+  }
+  return total + sadTail(a, b, x, width, blocks);
+}
+
+__attribute__((target("sse2"))) uint64_t sseRowSse2(uint8_t const *a,
+                                                     uint8_t const *b,
+                                                     int width) {
+  auto const zero = _mm_setzero_si128();
+  auto acc = zero;
+  uint64_t sse = 0;
+  int x = 0;
+  int pending = 0;
+  for (; x + 16 <= width; x += 16) {
+    auto const va = _mm_loadu_si128(reinterpret_cast<__m128i const *>(a + x));
+    auto const vb = _mm_loadu_si128(reinterpret_cast<__m128i const *>(b + x));
+    auto const lo = _mm_sub_epi16(_mm_unpacklo_epi8(va, zero),
+                                  _mm_unpacklo_epi8(vb, zero));
+    auto const hi = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero),
+                                  _mm_unpackhi_epi8(vb, zero));
+    acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_madd_epi16(lo, lo),
+                                           _mm_madd_epi16(hi, hi)));
+    if (++pending == SQ_FLUSH_ITERATIONS) {
+      sse += widenSq(acc);
+      acc = zero;
+      pending = 0;
+    }
+  }
+  sse += widenSq(acc);
+  return sse + getScalarKernels().sseRow(a + x, b + x, width - x);
+}
+
+/**
+ * @brief Stores the sums of lanes 0-1 and 2-3 of two vectors of 32 bit pair
+ * sums, i.e. the sums of four 4 sample blocks.
+ */
+__attribute__((target("sse2"))) void storeBlockSums(__m128i lo, __m128i hi,
+                                                    int32_t (*sums)[4],
+                                                    int index) {
+  alignas(16) int32_t lanes[8];
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes),
+                  _mm_add_epi32(lo, _mm_srli_epi64(lo, 32)));
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes + 4),
+                  _mm_add_epi32(hi, _mm_srli_epi64(hi, 32)));
+  sums[0][index] = lanes[0];
+  sums[1][index] = lanes[2];
+  sums[2][index] = lanes[4];
+  sums[3][index] = lanes[6];
+}
+
+__attribute__((target("sse2"))) void
+ssimRowSse2(uint8_t const *a, int aLineSize, uint8_t const *b, int bLineSize,
+            int blocks, int32_t (*sums)[4]) {
+  auto const zero = _mm_setzero_si128();
+  auto const ones = _mm_set1_epi16(1);
+  int z = 0;
+  for (; z + 4 <= blocks; z += 4) {
+    // Pair sums of samples 0-7 (blocks z, z + 1) and 8-15 (z + 2, z + 3)
+    __m128i lo[4] = {zero, zero, zero, zero};
+    __m128i hi[4] = {zero, zero, zero, zero};
+    for (int y = 0; y < 4; ++y) {
+      auto const va = _mm_loadu_si128(
+          reinterpret_cast<__m128i const *>(a + y * aLineSize + 4 * z));
+      auto const vb = _mm_loadu_si128(
+          reinterpret_cast<__m128i const *>(b + y * bLineSize + 4 * z));
+      __m128i const halves[2][2] = {
+          {_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero)},
+          {_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero)}};
+      __m128i *accs[2] = {lo, hi};
+      for (int h = 0; h < 2; ++h) {
+        auto const &pa = halves[h][0];
+        auto const &pb = halves[h][1];
+        auto acc = accs[h];
+        acc[0] = _mm_add_epi32(acc[0], _mm_madd_epi16(pa, ones));
+        acc[1] = _mm_add_epi32(acc[1], _mm_madd_epi16(pb, ones));
+        acc[2] = _mm_add_epi32(acc[2], _mm_add_epi32(_mm_madd_epi16(pa, pa),
+                                                     _mm_madd_epi16(pb, pb)));
+        acc[3] = _mm_add_epi32(acc[3], _mm_madd_epi16(pa, pb));
+      }
+    }
+    for (int i = 0; i < 4; ++i) {
+      storeBlockSums(lo[i], hi[i], sums + z, i);
+    }
+  }
+  getScalarKernels().ssimRow(a + 4 * z, aLineSize, b + 4 * z, bLineSize,
+                             blocks - z, sums + z);
+}
+
+__attribute__((target("sse2"))) void
+accumulateRowSse2(uint8_t const *row, int width, uint32_t *sums) {
+  auto const zero = _mm_setzero_si128();
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(row + x));
+    __m128i const halves[2] = {_mm_unpacklo_epi8(v, zero),
+                               _mm_unpackhi_epi8(v, zero)};
+    for (int h = 0; h < 2; ++h) {
+      __m128i const words[2] = {_mm_unpacklo_epi16(halves[h], zero),
+                                _mm_unpackhi_epi16(halves[h], zero)};
+      for (int w = 0; w < 2; ++w) {
+        auto const dst = reinterpret_cast<__m128i *>(sums + x + 8 * h + 4 * w);
+        _mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), words[w]));
+      }
+    }
+  }
+  getScalarKernels().accumulateRow(row + x, width - x, sums + x);
+}
+
+__attribute__((target("avx2"))) void
+sumRowAvx2(uint8_t const *row, int width, uint64_t *sum, uint64_t *sumSq) {
+  auto const zero = _mm256_setzero_si256();
+  auto s = zero;
+  auto sq = zero;
+  int x = 0;
+  int pending = 0;
+  for (; x + 32 <= width; x += 32) {
+    auto const v =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(row + x));
+    s = _mm256_add_epi64(s, _mm256_sad_epu8(v, zero));
+
+    auto const lo = _mm256_unpacklo_epi8(v, zero);
+    auto const hi = _mm256_unpackhi_epi8(v, zero);
+    sq = _mm256_add_epi32(sq, _mm256_add_epi32(_mm256_madd_epi16(lo, lo),
+                                               _mm256_madd_epi16(hi, hi)));
+    if (++pending == SQ_FLUSH_ITERATIONS) {
+      *sumSq += widenSq(_mm_add_epi32(_mm256_castsi256_si128(sq),
+                                      _mm256_extracti128_si256(sq, 1)));
+      sq = zero;
+      pending = 0;
+    }
+  }
+  *sum += sumLanes(_mm_add_epi64(_mm256_castsi256_si128(s),
+                                 _mm256_extracti128_si256(s, 1)));
+  *sumSq += widenSq(_mm_add_epi32(_mm256_castsi256_si128(sq),
+                                  _mm256_extracti128_si256(sq, 1)));
+  sumTail(row, x, width, sum, sumSq);
+}
+
+__attribute__((target("avx2"))) uint64_t sadRowAvx2(uint8_t const *a,
+                                                     uint8_t const *b,
+                                                     int width,
+                                                     uint32_t *blocks) {
+  uint64_t total = 0;
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    // Lanes 0-1 hold the SAD of the first block, lanes 2-3 of the second
+    auto const sad = _mm256_sad_epu8(
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + x)),
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(b + x)));
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), sad);
+
+    auto const first = static_cast<uint32_t>(lanes[0] + lanes[1]);
+    auto const second = static_cast<uint32_t>(lanes[2] + lanes[3]);
+    blocks[x / BLOCK_SIZE] += first;
+    blocks[x / BLOCK_SIZE + 1] += second;
+    total += first + second;
+  }
+  if (x + 16 <= width) {
+    auto const sad = _mm_sad_epu8(
+        _mm_loadu_si128(reinterpret_cast<__m128i const *>(a + x)),
+        _mm_loadu_si128(reinterpret_cast<__m128i const *>(b + x)));
+    auto const blockSad = static_cast<uint32_t>(sumLanes(sad));
+    blocks[x / BLOCK_SIZE] += blockSad;
+    total += blockSad;
+    x += 16;
+  }
+  return total + sadTail(a, b, x, width, blocks);
+}
+
+__attribute__((target("avx2"))) uint64_t sseRowAvx2(uint8_t const *a,
+                                                     uint8_t const *b,
+                                                     int width) {
+  auto const zero = _mm256_setzero_si256();
+  auto acc = zero;
+  uint64_t sse = 0;
+  int x = 0;
+  int pending = 0;
+  for (; x + 16 <= width; x += 16) {
+    auto const diff = _mm256_sub_epi16(
+        _mm256_cvtepu8_epi16(
+            _mm_loadu_si128(reinterpret_cast<__m128i const *>(a + x))),
+        _mm256_cvtepu8_epi16(
+            _mm_loadu_si128(reinterpret_cast<__m128i const *>(b + x))));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(diff, diff));
+    if (++pending == SQ_FLUSH_ITERATIONS) {
+      sse += widenSq(_mm_add_epi32(_mm256_castsi256_si128(acc),
+                                   _mm256_extracti128_si256(acc, 1)));
+      acc = zero;
+      pending = 0;
+    }
+  }
+  sse += widenSq(_mm_add_epi32(_mm256_castsi256_si128(acc),
+                               _mm256_extracti128_si256(acc, 1)));
+  return sse + getScalarKernels().sseRow(a + x, b + x, width - x);
+}
+
+__attribute__((target("avx2"))) void
+ssimRowAvx2(uint8_t const *a, int aLineSize, uint8_t const *b, int bLineSize,
+            int blocks, int32_t (*sums)[4]) {
+  auto const ones = _mm256_set1_epi16(1);
+  int z = 0;
+  for (; z + 4 <= blocks; z += 4) {
+    // 32 bit sums of sample pairs, in order
+    __m256i acc[4] = {_mm256_setzero_si256(), _mm256_setzero_si256(),
+                      _mm256_setzero_si256(), _mm256_setzero_si256()};
+    for (int y = 0; y < 4; ++y) {
+      auto const va = _mm256_cvtepu8_epi16(_mm_loadu_si128(
+          reinterpret_cast<__m128i const *>(a + y * aLineSize + 4 * z)));
+      auto const vb = _mm256_cvtepu8_epi16(_mm_loadu_si128(
+          reinterpret_cast<__m128i const *>(b + y * bLineSize + 4 * z)));
+      acc[0] = _mm256_add_epi32(acc[0], _mm256_madd_epi16(va, ones));
+      acc[1] = _mm256_add_epi32(acc[1], _mm256_madd_epi16(vb, ones));
+      acc[2] = _mm256_add_epi32(acc[2],
+                                _mm256_add_epi32(_mm256_madd_epi16(va, va),
+                                                 _mm256_madd_epi16(vb, vb)));
+      acc[3] = _mm256_add_epi32(acc[3], _mm256_madd_epi16(va, vb));
+    }
+    for (int i = 0; i < 4; ++i) {
+      storeBlockSums(_mm256_castsi256_si128(acc[i]),
+                     _mm256_extracti128_si256(acc[i], 1), sums + z, i);
+    }
+  }
+  getScalarKernels().ssimRow(a + 4 * z, aLineSize, b + 4 * z, bLineSize,
+                             blocks - z, sums + z);
+}
+
+__attribute__((target("avx2"))) void
+accumulateRowAvx2(uint8_t const *row, int width, uint32_t *sums) {
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    auto const v = _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<__m128i const *>(row + x)));
+    auto const dst = reinterpret_cast<__m256i *>(sums + x);
+    _mm256_storeu_si256(dst, _mm256_add_epi32(_mm256_loadu_si256(dst), v));
+  }
+  getScalarKernels().accumulateRow(row + x, width - x, sums + x);
+}
+} // namespace
+
+KernelSet const &getSse2Kernels() {
+  static KernelSet const kernels{"sse2", sumRowSse2, sadRowSse2,
+                                  sseRowSse2, ssimRowSse2,
+                                  accumulateRowSse2};
+  return kernels;
+}
+
+KernelSet const &getAvx2Kernels() {
+  static KernelSet const kernels{"avx2", sumRowAvx2, sadRowAvx2,
+                                  sseRowAvx2, ssimRowAvx2,
+                                  accumulateRowAvx2};
+  return kernels;
+}
+}; // namespace kernels
+}; // namespace analysis
+}; // namespace libffmpegxx
+
+#endif
@@ -182,8 +182,8 @@ void AVPacketImpl::setDuration(int duration) {
 }
 
 void AVPacketImpl::setStreamIndex(int index) {
-  if (index <= 0) {
-    LOG_FATAL("AVPacket stream index must be a positive number");
+  if (index < 0) {
+    LOG_FATAL("AVPacket stream index cannot be negative");
   }
 
   m_avPacket->stream_index = index;
@@ -0,0 +1,21 @@
+#include "avcodec/AVPacketPool.h"
+
+namespace libffmpegxx {
+namespace avcodec {
+AVPacketPool::AVPacketPool(size_t maxIdle)
+    : m_pool(maxIdle, [](AVPacketImpl &packet) {
+        packet.clear();
+        return true;
+      }) {}
+
+std::shared_ptr<AVPacketImpl> AVPacketPool::acquire() {
+  auto packet = m_pool.take();
+  if (!packet) {
+    packet = std::make_unique<AVPacketImpl>();
+  }
+  return m_pool.share(std::move(packet));
+}
+
+size_t AVPacketPool::getIdleCount() const { return m_pool.getIdleCount(); }
+}; // namespace avcodec
+}; // namespace libffmpegxx
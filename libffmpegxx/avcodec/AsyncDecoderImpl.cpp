@@ -0,0 +1,124 @@
+#include "avcodec/AsyncDecoderImpl.h"
+
+#include "public/avcodec/IDecoder.h"
+
+#include "utils/LoggerApi.h"
+
+namespace libffmpegxx {
+namespace avcodec {
+IAsyncDecoder *AsyncDecoderFactory::create(IDecoder *decoder,
+                                           size_t inputCapacity,
+                                           size_t outputCapacity) {
+  return new AsyncDecoderImpl(decoder, inputCapacity, outputCapacity);
+}
+
+AsyncDecoderImpl::AsyncDecoderImpl(IDecoder *decoder, size_t inputCapacity,
+                                   size_t outputCapacity)
+    : m_decoder(decoder), m_input(inputCapacity), m_output(outputCapacity) {
+  if (!m_decoder) {
+    LOG_FATAL("Decoder cannot be null when creating an asynchronous decoder");
+  }
+
+  m_thread = std::thread(&AsyncDecoderImpl::run, this);
+}
+
+AsyncDecoderImpl::~AsyncDecoderImpl() {
+  m_input.close();
+  m_output.close();
+  m_thread.join();
+}
+
+bool AsyncDecoderImpl::push(IAVPacket const *packet) {
+  if (!packet) {
+    LOG_FATAL("Cannot queue a null packet for decoding. Use flush()");
+  }
+
+  auto const packetImpl = dynamic_cast<AVPacketImpl const *>(packet);
+  if (!packetImpl) {
+    LOG_FATAL("Error handling packet while queueing it for decoding");
+  }
+
+  return m_input.push({std::make_unique<AVPacketImpl>(packetImpl),
+                       utils::LatencyStats::Clock::now()});
+}
+
+void AsyncDecoderImpl::flush() {
+  m_input.push({nullptr, utils::LatencyStats::Clock::now()});
+  m_input.close();
+}
+
+bool AsyncDecoderImpl::pop(std::shared_ptr<avutil::IAVFrame> &frame) {
+  FrameItem item;
+  if (!m_output.pop(item)) {
+    return false;
+  }
+
+  m_outputLatency.addSince(item.queued);
+  frame = std::move(item.frame);
+  return true;
+}
+
+bool AsyncDecoderImpl::tryPop(std::shared_ptr<avutil::IAVFrame> &frame) {
+  FrameItem item;
+  if (!m_output.tryPop(item)) {
+    return false;
+  }
+
+  m_outputLatency.addSince(item.queued);
+  frame = std::move(item.frame);
+  return true;
+}
+
+int AsyncDecoderImpl::getError() const { return m_error; }
+
+AsyncDecoderStatistics AsyncDecoderImpl::getStatistics() const {
+  AsyncDecoderStatistics stats;
+  stats.packets = m_packets;
+  stats.frames = m_frames;
+  stats.inputQueue = m_inputLatency.get();
+  stats.decode = m_decodeLatency.get();
+  stats.outputQueue = m_outputLatency.get();
+  return stats;
+}
+
+void AsyncDecoderImpl::run() {
+  auto const sink = [this](std::shared_ptr<avutil::IAVFrame> const &frame) {
+    ++m_frames;
+    // Blocks while the consumer is behind
+    m_output.push({frame, utils::LatencyStats::Clock::now()});
+  };
+
+  try {
+    PacketItem item;
+    while (m_input.pop(item)) {
+      m_inputLatency.addSince(item.queued);
+
+      auto const start = utils::LatencyStats::Clock::now();
+      int const error = m_decoder->decode(item.packet.get(), sink);
+      m_decodeLatency.addSince(start);
+
+      if (!item.packet) {
+        if (error < 0 && error != AVERROR_EOF) {
+          m_error = error;
+        }
+        break;
+      }
+
+      ++m_packets;
+      // Corrupted packets are skipped, as a synchronous decode loop would do
+      if (error < 0 && error != AVERROR_INVALIDDATA) {
+        m_error = error;
+        break;
+      }
+    }
+  } catch (std::exception const &e) {
+    LOG_ERROR(std::string("Asynchronous decoding failed: ") + e.what());
+    m_error = AVERROR_UNKNOWN;
+  }
+
+  // Unblocks both the producer and the consumer
+  m_input.close();
+  m_output.close();
+}
+}; // namespace avcodec
+}; // namespace libffmpegxx
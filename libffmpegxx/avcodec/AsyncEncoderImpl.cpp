@@ -0,0 +1,161 @@
+#include "avcodec/AsyncEncoderImpl.h"
+
+#include "public/avcodec/IAVPacket.h"
+
+#include "utils/LoggerApi.h"
+
+namespace libffmpegxx {
+namespace avcodec {
+IAsyncEncoder *AsyncEncoderFactory::create(IEncoder *encoder,
+                                           size_t inputCapacity,
+                                           size_t outputCapacity) {
+  return new AsyncEncoderImpl(encoder, {}, inputCapacity, outputCapacity);
+}
+
+IAsyncEncoder *AsyncEncoderFactory::create(IEncoder *encoder,
+                                           PacketSink const &sink,
+                                           size_t inputCapacity) {
+  if (!sink) {
+    LOG_FATAL("Packet sink cannot be empty when creating an asynchronous "
+              "encoder");
+  }
+  return new AsyncEncoderImpl(encoder, sink, inputCapacity, 1);
+}
+
+AsyncEncoderImpl::AsyncEncoderImpl(IEncoder *encoder, PacketSink const &sink,
+                                   size_t inputCapacity, size_t outputCapacity)
+    : m_encoder(encoder), m_sink(sink), m_input(inputCapacity),
+      m_output(outputCapacity) {
+  if (!m_encoder) {
+    LOG_FATAL("Encoder cannot be null when creating an asynchronous encoder");
+  }
+
+  m_thread = std::thread(&AsyncEncoderImpl::run, this);
+}
+
+AsyncEncoderImpl::~AsyncEncoderImpl() {
+  m_input.close();
+  m_output.close();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+AsyncEncoderImpl::FrameItem
+AsyncEncoderImpl::toItem(avutil::IAVFrame const *frame) const {
+  if (!frame) {
+    LOG_FATAL("Cannot queue a null frame for encoding. Use flush()");
+  }
+
+  auto const frameImpl = dynamic_cast<avutil::AVFrameImpl const *>(frame);
+  if (!frameImpl) {
+    LOG_FATAL("Error handling frame while queueing it for encoding");
+  }
+
+  return {std::make_unique<avutil::AVFrameImpl>(frameImpl),
+          utils::LatencyStats::Clock::now()};
+}
+
+bool AsyncEncoderImpl::push(avutil::IAVFrame const *frame) {
+  return m_input.push(toItem(frame));
+}
+
+bool AsyncEncoderImpl::tryPush(avutil::IAVFrame const *frame) {
+  if (m_input.isClosed() || m_input.size() >= m_input.capacity()) {
+    return false;
+  }
+
+  // Single producer: the room seen above cannot be taken by anyone else
+  return m_input.tryPush(toItem(frame));
+}
+
+void AsyncEncoderImpl::flush() {
+  m_input.push({nullptr, utils::LatencyStats::Clock::now()});
+  m_input.close();
+}
+
+int AsyncEncoderImpl::wait() {
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+  return m_error;
+}
+
+bool AsyncEncoderImpl::pop(std::shared_ptr<IAVPacket> &packet) {
+  PacketItem item;
+  if (!m_output.pop(item)) {
+    return false;
+  }
+
+  m_outputLatency.addSince(item.queued);
+  packet = std::move(item.packet);
+  return true;
+}
+
+bool AsyncEncoderImpl::tryPop(std::shared_ptr<IAVPacket> &packet) {
+  PacketItem item;
+  if (!m_output.tryPop(item)) {
+    return false;
+  }
+
+  m_outputLatency.addSince(item.queued);
+  packet = std::move(item.packet);
+  return true;
+}
+
+int AsyncEncoderImpl::getError() const { return m_error; }
+
+AsyncEncoderStatistics AsyncEncoderImpl::getStatistics() const {
+  AsyncEncoderStatistics stats;
+  stats.frames = m_frames;
+  stats.packets = m_packets;
+  stats.inputQueue = m_inputLatency.get();
+  stats.encode = m_encodeLatency.get();
+  stats.outputQueue = m_outputLatency.get();
+  return stats;
+}
+
+void AsyncEncoderImpl::run() {
+  auto const sink = [this](std::shared_ptr<IAVPacket> const &packet) {
+    ++m_packets;
+    if (m_sink) {
+      m_sink(packet);
+    } else {
+      // Blocks while the consumer is behind
+      m_output.push({packet, utils::LatencyStats::Clock::now()});
+    }
+  };
+
+  try {
+    FrameItem item;
+    while (m_input.pop(item)) {
+      m_inputLatency.addSince(item.queued);
+
+      auto const start = utils::LatencyStats::Clock::now();
+      int const error = m_encoder->encode(item.frame.get(), sink);
+      m_encodeLatency.addSince(start);
+
+      if (!item.frame) {
+        if (error < 0 && error != AVERROR_EOF) {
+          m_error = error;
+        }
+        break;
+      }
+
+      ++m_frames;
+      if (error < 0) {
+        m_error = error;
+        break;
+      }
+    }
+  } catch (std::exception const &e) {
+    LOG_ERROR(std::string("Asynchronous encoding failed: ") + e.what());
+    m_error = AVERROR_UNKNOWN;
+  }
+
+  // Unblocks both the producer and the consumer
+  m_input.close();
+  m_output.close();
+}
+}; // namespace avcodec
+}; // namespace libffmpegxx
@@ -0,0 +1,367 @@
+#include "avcodec/ChunkedEncoderImpl.h"
+
+#include "avcodec/AVPacketImpl.h"
+#include "avcodec/EncoderImpl.h"
+#include "avformat/DemuxerImpl.h"
+#include "avutil/AVFrameImpl.h"
+#include "swscale/ScalerImpl.h"
+#include "utils/LoggerApi.h"
+
+#include <algorithm>
+#include <thread>
+
+extern "C" {
+#include <libavutil/mathematics.h>
+}
+
+namespace libffmpegxx {
+namespace avcodec {
+extern void fitVideoSize(AVCodecParameters const *source, int &width,
+                         int &height);
+extern AVPixelFormat chooseEncoderPixelFormat(AVCodec const *codec,
+                                              AVPixelFormat requested,
+                                              AVPixelFormat source);
+extern avformat::StreamInfo
+makeEncodedStreamInfo(avformat::StreamInfo const &source,
+                      AVCodec const *codec, int width, int height,
+                      AVPixelFormat format);
+
+IChunkedEncoder *ChunkedEncoderFactory::create(
+    std::string const &uri, int streamIdx, ChunkedEncodeConfig const &config) {
+  return new ChunkedEncoderImpl(uri, streamIdx, config);
+}
+
+ChunkedEncoderImpl::ChunkedEncoderImpl(std::string const &uri, int streamIdx,
+                                       ChunkedEncodeConfig const &config)
+    : m_uri(uri), m_streamIdx(streamIdx), m_config(config),
+      m_encoderOptions(config.encoderOptions) {
+  if (m_config.workers <= 0) {
+    m_config.workers =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  m_window = m_config.reorderWindow > 0 ? m_config.reorderWindow
+                                        : 2 * m_config.workers;
+
+  avformat::StreamInfo source;
+  {
+    avformat::DemuxerImpl demuxer(uri);
+    auto const info = demuxer.open(m_config.demuxerOptions);
+    auto const stream = info.streamsInfo.find(streamIdx);
+    if (stream == info.streamsInfo.end() ||
+        stream->second.type != avformat::StreamType::VIDEO) {
+      LOG_FATAL("Stream " + std::to_string(streamIdx) + " of " + uri +
+                " is not a video stream");
+    }
+    source = stream->second;
+  }
+
+  auto const codec = avcodec_find_encoder(m_config.codecId);
+  if (!codec) {
+    LOG_FATAL("Could not find an encoder for codec id " +
+              std::to_string(m_config.codecId));
+  }
+
+  int width = m_config.width;
+  int height = m_config.height;
+  fitVideoSize(*source.codecPar, width, height);
+  auto const format = chooseEncoderPixelFormat(
+      codec, m_config.pixelFormat,
+      static_cast<AVPixelFormat>(source.codecPar->format));
+  m_encoderInput = makeEncodedStreamInfo(source, codec, width, height, format);
+
+  // Chunks must be decodable on their own to be stitched, whatever other
+  // flags the caller set
+  auto const flags = m_encoderOptions.find("flags");
+  if (flags == m_encoderOptions.end()) {
+    m_encoderOptions["flags"] = "+cgop";
+  } else if (auto const value = std::get_if<int>(&flags->second)) {
+    flags->second = *value | static_cast<int>(AV_CODEC_FLAG_CLOSED_GOP);
+  } else {
+    flags->second = std::get<std::string>(flags->second) + "+cgop";
+  }
+
+  // Every chunk encoder has the same settings, so this one tells the output
+  // parameters (i.e. extradata) of them all
+  m_streamInfo = EncoderImpl(m_encoderInput, m_config.settings,
+                             m_encoderOptions)
+                     .getStreamInfo();
+}
+
+ChunkedEncoderImpl::~ChunkedEncoderImpl() { stop(); }
+
+avformat::StreamInfo ChunkedEncoderImpl::getStreamInfo() const {
+  return m_streamInfo;
+}
+
+int ChunkedEncoderImpl::encode(PacketSink const &sink) {
+  m_stopRequested = false;
+  m_error = 0;
+  m_nextChunk = 0;
+  m_delivered = 0;
+  m_encoderDelay = AV_NOPTS_VALUE;
+
+  buildChunks(avformat::KeyframeIndex(m_uri, m_streamIdx,
+                                      m_config.demuxerOptions));
+  if (m_chunks.empty()) {
+    LOG_WARN("No keyframes found in stream " + std::to_string(m_streamIdx) +
+             " of " + m_uri);
+    return 0;
+  }
+
+  auto const workerCount =
+      std::min(static_cast<size_t>(m_config.workers), m_chunks.size());
+  LOG_INFO("Encoding " + std::to_string(m_chunks.size()) + " chunks of " +
+           m_uri + " with " + std::to_string(workerCount) + " workers");
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < workerCount; ++i) {
+    workers.emplace_back(&ChunkedEncoderImpl::work, this);
+  }
+
+  try {
+    for (size_t idx = 0; idx < m_chunks.size(); ++idx) {
+      Packets packets;
+      {
+        std::unique_lock<std::mutex> l(m_mutex);
+        m_cv.wait(l, [this, idx] {
+          return m_chunks[idx].done || m_stopRequested;
+        });
+        if (!m_chunks[idx].done) {
+          break;
+        }
+
+        // Frees a slot of the reorder window
+        packets.swap(m_chunks[idx].packets);
+        m_delivered = idx + 1;
+      }
+      m_cv.notify_all();
+
+      if (int const error = deliver(idx, packets, sink); error < 0) {
+        fail(error);
+        break;
+      }
+    }
+  } catch (...) {
+    stop();
+    for (auto &&worker : workers) {
+      worker.join();
+    }
+    throw;
+  }
+
+  stop();
+  for (auto &&worker : workers) {
+    worker.join();
+  }
+
+  std::lock_guard<std::mutex> l(m_mutex);
+  return m_error;
+}
+
+void ChunkedEncoderImpl::stop() {
+  {
+    std::lock_guard<std::mutex> l(m_mutex);
+    m_stopRequested = true;
+  }
+  m_cv.notify_all();
+}
+
+void ChunkedEncoderImpl::buildChunks(avformat::KeyframeIndex const &index) {
+  m_chunks.clear();
+
+  auto const &keyframes = index.getKeyframes();
+  auto const tb = index.getTimebase();
+  auto const minDuration =
+      av_rescale_q(static_cast<int64_t>(m_config.minChunkDuration.count() *
+                                        AV_TIME_BASE),
+                   AV_TIME_BASE_Q, {tb.num(), tb.den()});
+
+  for (size_t i = 0; i < keyframes.size();) {
+    Chunk chunk;
+    chunk.range.start = keyframes[i];
+    chunk.range.first = i == 0;
+
+    // Whole source GOPs until the chunk is long enough
+    auto const startTs = keyframes[i].getDecodeOrderTs();
+    size_t next = i + 1;
+    while (next < keyframes.size() &&
+           keyframes[next].getDecodeOrderTs() - startTs < minDuration) {
+      ++next;
+    }
+
+    if (next < keyframes.size()) {
+      chunk.range.end = keyframes[next];
+    }
+    m_chunks.push_back(std::move(chunk));
+    i = next;
+  }
+}
+
+void ChunkedEncoderImpl::work() {
+  try {
+    SegmentDecoder decoder(m_uri, m_streamIdx, m_config.demuxerOptions,
+                           m_config.decoderOptions, m_config.decoderThreading);
+
+    std::unique_ptr<swscale::ScalerImpl> scaler;
+    auto const sourcePar = *decoder.getStreamInfo().codecPar;
+    auto const inputPar = *m_encoderInput.codecPar;
+    if (sourcePar->width != inputPar->width ||
+        sourcePar->height != inputPar->height ||
+        sourcePar->format != inputPar->format) {
+      scaler = std::make_unique<swscale::ScalerImpl>();
+    }
+
+    while (!m_stopRequested) {
+      size_t const idx = m_nextChunk++;
+      if (idx >= m_chunks.size()) {
+        break;
+      }
+
+      {
+        std::unique_lock<std::mutex> l(m_mutex);
+        m_cv.wait(l, [this, idx] {
+          return m_stopRequested || idx < m_delivered + m_window;
+        });
+        if (m_stopRequested) {
+          break;
+        }
+      }
+
+      Packets packets;
+      int const error =
+          encodeChunk(decoder, scaler.get(), m_chunks[idx], packets);
+      if (error < 0) {
+        fail(error);
+        break;
+      }
+
+      {
+        std::lock_guard<std::mutex> l(m_mutex);
+        m_chunks[idx].packets = std::move(packets);
+        m_chunks[idx].done = true;
+      }
+      m_cv.notify_all();
+    }
+  } catch (std::exception const &e) {
+    LOG_ERROR("Chunked encoding of " + m_uri + " failed: " + e.what());
+    fail(AVERROR_UNKNOWN);
+  }
+}
+
+int ChunkedEncoderImpl::encodeChunk(SegmentDecoder &decoder,
+                                    swscale::ScalerImpl *scaler,
+                                    Chunk const &chunk, Packets &packets) {
+  // A fresh encoder per chunk starts it with a keyframe and no references
+  EncoderImpl encoder(m_encoderInput, m_config.settings, m_encoderOptions);
+
+  auto const collect = [&packets](std::shared_ptr<IAVPacket> const &packet) {
+    packets.push_back(packet);
+  };
+
+  int encodeError = 0;
+  int error = decoder.decode(
+      chunk.range,
+      [&](std::shared_ptr<avutil::IAVFrame> const &frame) {
+        if (encodeError < 0) {
+          return;
+        }
+
+        auto const decoded =
+            std::dynamic_pointer_cast<avutil::AVFrameImpl>(frame);
+        if (!decoded) {
+          LOG_FATAL("Error handling decoded frame");
+        }
+
+        // The decoder picture types must not leak into the encoder
+        auto const avframe = decoded->getWrappedFrame();
+        avframe->pts = avframe->best_effort_timestamp;
+        avframe->pict_type = AV_PICTURE_TYPE_NONE;
+
+        auto const inputPar = *m_encoderInput.codecPar;
+        auto const input =
+            scaler ? scaler->scaleFrame(
+                         decoded.get(), inputPar->width, inputPar->height,
+                         static_cast<AVPixelFormat>(inputPar->format))
+                   : decoded;
+        encodeError = encoder.encode(input.get(), collect);
+      },
+      m_stopRequested);
+
+  if (error < 0) {
+    return error;
+  }
+  if (encodeError < 0) {
+    return encodeError;
+  }
+
+  error = encoder.encode(nullptr, collect);
+  return error == AVERROR_EOF ? 0 : error;
+}
+
+int ChunkedEncoderImpl::deliver(size_t idx, Packets const &packets,
+                                PacketSink const &sink) {
+  // Each chunk encoder starts its DTS one reorder delay before its first
+  // PTS, overlapping the end of the previous chunk. Every chunk encoder has
+  // the same settings and so the same delay: rebuilding the DTS from the
+  // sorted PTS keeps them increasing across chunks. PTS are never modified.
+  std::vector<int64_t> pts;
+  pts.reserve(packets.size());
+  for (auto &&packet : packets) {
+    auto const avpacket =
+        dynamic_cast<AVPacketImpl *>(packet.get())->getWrappedPacket();
+    if (avpacket->pts == AV_NOPTS_VALUE || avpacket->dts == AV_NOPTS_VALUE) {
+      pts.clear();
+      break;
+    }
+    pts.push_back(avpacket->pts);
+  }
+
+  if (pts.empty() && idx > 0 && !packets.empty()) {
+    // Their encoder DTS would overlap the previous chunk ones
+    LOG_ERROR("Chunk " + std::to_string(idx) +
+              " has packets without timestamps, its DTS cannot follow the "
+              "previous chunk ones");
+    return AVERROR_INVALIDDATA;
+  }
+
+  if (!pts.empty()) {
+    std::sort(pts.begin(), pts.end());
+
+    auto const first =
+        dynamic_cast<AVPacketImpl *>(packets.front().get())
+            ->getWrappedPacket();
+    auto const delay = pts.front() - first->dts;
+    if (m_encoderDelay == AV_NOPTS_VALUE) {
+      m_encoderDelay = delay;
+    } else if (delay != m_encoderDelay) {
+      LOG_WARN("Chunk encoder delay " + std::to_string(delay) +
+               " differs from the first chunk one " +
+               std::to_string(m_encoderDelay));
+    }
+
+    for (size_t i = 0; i < packets.size(); ++i) {
+      auto const avpacket =
+          dynamic_cast<AVPacketImpl *>(packets[i].get())->getWrappedPacket();
+      avpacket->dts = std::min(pts[i] - m_encoderDelay, avpacket->pts);
+    }
+  }
+
+  for (auto &&packet : packets) {
+    packet->setStreamIndex(0);
+    sink(packet);
+  }
+  return 0;
+}
+
+void ChunkedEncoderImpl::fail(int error) {
+  {
+    std::lock_guard<std::mutex> l(m_mutex);
+    if (m_error == 0) {
+      m_error = error;
+    }
+    m_stopRequested = true;
+  }
+  m_cv.notify_all();
+}
+}; // namespace avcodec
+}; // namespace libffmpegxx
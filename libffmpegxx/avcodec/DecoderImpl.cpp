@@ -6,37 +6,110 @@
 #include "avcodec/AVPacketImpl.h"
 #include "avutil/AVFrameImpl.h"
 #include "utils/LoggerApi.h"
+#include "utils/ThreadAffinity.h"
 #include "utils/exception.h"
 
+#include <algorithm>
+
 namespace libffmpegxx {
+namespace utils {
+extern AVDictionary *toAVDictionary(AVOptions const &options);
+}
+
 namespace avcodec {
+extern void applyThreadingPolicy(AVCodecContext *ctx,
+                                 ThreadingPolicy const &policy);
+extern ThreadingPolicy getEffectiveThreading(AVCodecContext const *ctx,
+                                             ThreadingPolicy const &policy);
+extern utils::AVOptions logRejectedOptions(AVDictionary *opts,
+                                           std::string const &codecName);
+
 IDecoder *DecoderFactory::create(avformat::StreamInfo const &streamInfo) {
   return new DecoderImpl(streamInfo);
 }
 
-DecoderImpl::DecoderImpl(avformat::StreamInfo const &streamInfo) {
+IDecoder *DecoderFactory::create(avformat::StreamInfo const &streamInfo,
+                                 utils::AVOptions const &options,
+                                 ThreadingPolicy const &threading,
+                                 DecodeMode const &mode) {
+  return new DecoderImpl(streamInfo, options, threading, mode);
+}
+
+DecoderImpl::DecoderImpl(avformat::StreamInfo const &streamInfo,
+                         utils::AVOptions const &options,
+                         ThreadingPolicy const &threading,
+                         DecodeMode const &mode)
+    : m_codecPar(streamInfo.codecPar), m_tb(streamInfo.timebase),
+      m_options(options), m_requestedThreading(threading), m_mode(mode),
+      m_requestedLowres(mode.lowres) {
   // First find the decoder
-  auto const codec = avcodec_find_decoder(streamInfo.codecId);
-  if (!codec) {
+  m_codec = avcodec_find_decoder(streamInfo.codecId);
+  if (!m_codec) {
     LOG_FATAL("No codec found for id " + std::to_string(streamInfo.codecId));
   }
 
-  m_codecCtx = avcodec_alloc_context3(codec);
-  if (!m_codecCtx) {
-    LOG_FATAL("Could not allocate decoder context for codec ID " +
-              std::to_string(streamInfo.codecId));
+  m_mode.lowres = getSupportedLowres(m_mode.lowres);
+  m_codecCtx = openContext(m_mode.lowres);
+  m_threading = getEffectiveThreading(m_codecCtx, m_requestedThreading);
+  applyDecodeMode();
+}
+
+AVCodecContext *DecoderImpl::openContext(int lowres) const {
+  auto ctx = avcodec_alloc_context3(m_codec);
+  if (!ctx) {
+    LOG_FATAL("Could not allocate decoder context for codec " +
+              std::string(m_codec->name));
+  }
+
+  avcodec_parameters_to_context(ctx, *m_codecPar);
+  applyThreadingPolicy(ctx, m_requestedThreading);
+
+  // Lowres can only be set before opening
+  ctx->lowres = lowres;
+
+  auto opts = utils::toAVDictionary(m_options);
+
+  int error = 0;
+  try {
+    // Worker threads are spawned while opening and inherit the affinity
+    utils::ScopedThreadAffinity const affinity(m_requestedThreading.cpus);
+    error = avcodec_open2(ctx, m_codec, &opts);
+  } catch (std::runtime_error const &) {
+    av_dict_free(&opts);
+    avcodec_free_context(&ctx);
+    throw;
   }
 
-  avcodec_parameters_to_context(m_codecCtx, *streamInfo.codecPar);
+  logRejectedOptions(opts, m_codec->name);
+  av_dict_free(&opts);
 
-  int const error = avcodec_open2(m_codecCtx, codec, nullptr);
   if (error < 0) {
-    LOG_FATAL_FFMPEG_ERR("Could not open decoder for codec ID " +
-                             std::to_string(streamInfo.codecId),
+    avcodec_free_context(&ctx);
+    LOG_FATAL_FFMPEG_ERR("Could not open decoder " + std::string(m_codec->name),
                          error);
   }
 
-  m_tb = streamInfo.timebase;
+  LOG_DEBUG("Decoder " + std::string(m_codec->name) + " opened with " +
+            std::to_string(
+                getEffectiveThreading(ctx, m_requestedThreading).threadCount) +
+            " thread(s)");
+  return ctx;
+}
+
+int DecoderImpl::getSupportedLowres(int lowres) const {
+  if (lowres > m_codec->max_lowres) {
+    LOG_WARN("Lowres " + std::to_string(lowres) +
+             " not supported by decoder " + m_codec->name + ", using " +
+             std::to_string(m_codec->max_lowres));
+    return m_codec->max_lowres;
+  }
+  return std::max(lowres, 0);
+}
+
+void DecoderImpl::applyDecodeMode() {
+  m_codecCtx->skip_frame = m_mode.skipFrame;
+  m_codecCtx->skip_loop_filter = m_mode.skipLoopFilter;
+  m_codecCtx->skip_idct = m_mode.skipIdct;
 }
 
 DecoderImpl::~DecoderImpl() {
@@ -81,6 +154,67 @@ int DecoderImpl::decode(IAVPacket *packet, avutil::IAVFrame *frame) {
   return error;
 }
 
+int DecoderImpl::decode(IAVPacket *packet, FrameSink const &sink) {
+  AVPacket *avpacket{nullptr};
+  if (packet) {
+    auto packetImpl = dynamic_cast<avcodec::AVPacketImpl *>(packet);
+    if (!packetImpl) {
+      LOG_FATAL("Error handling packet while decoding");
+    }
+    avpacket = packetImpl->getWrappedPacket();
+  }
+
+  int received = 0;
+  int error = 0;
+  while ((error = avcodec_send_packet(m_codecCtx, avpacket)) ==
+         AVERROR(EAGAIN)) {
+    // The decoder output must be consumed before it accepts more input
+    int const before = received;
+    error = receiveFrames(sink, received);
+    if (error != AVERROR(EAGAIN) || received == before) {
+      LOG_ERROR("Decoder did not accept packet after draining: " +
+                utils::Logger::avErrorToStr(error));
+      return error < 0 ? error : AVERROR(EAGAIN);
+    }
+  }
+
+  if (error < 0) {
+    // EOF means the decoder was already flushed
+    if (error != AVERROR_EOF) {
+      LOG_ERROR("Error sending packet to decoder: " +
+                utils::Logger::avErrorToStr(error));
+    }
+    return error;
+  }
+
+  error = receiveFrames(sink, received);
+  if (error == AVERROR(EAGAIN)) {
+    return 0;
+  }
+
+  if (error != AVERROR_EOF) {
+    LOG_ERROR("Error receiving frame from decoder: " +
+              utils::Logger::avErrorToStr(error));
+  }
+  return error;
+}
+
+int DecoderImpl::receiveFrames(FrameSink const &sink, int &received) {
+  int error = 0;
+  while (true) {
+    auto const frame = m_framePool.acquire();
+    error = avcodec_receive_frame(m_codecCtx, frame->getWrappedFrame());
+    if (error < 0) {
+      break;
+    }
+
+    frame->setTimebase(m_tb);
+    ++received;
+    sink(frame);
+  }
+  return error;
+}
+
 int DecoderImpl::flush(std::vector<avutil::IAVFrame *> &flushedFrames) {
   auto error = avcodec_send_packet(m_codecCtx, nullptr);
   if (error < 0) {
@@ -109,5 +243,38 @@ int DecoderImpl::flush(std::vector<avutil::IAVFrame *> &flushedFrames) {
 
   return error;
 }
+
+void DecoderImpl::reset() { avcodec_flush_buffers(m_codecCtx); }
+
+ThreadingPolicy DecoderImpl::getThreading() const { return m_threading; }
+
+void DecoderImpl::setDecodeMode(DecodeMode const &mode) {
+  // Requests are compared before clamping, so an unsupported lowres does not
+  // reopen the decoder on every call
+  auto lowres = m_mode.lowres;
+  if (mode.lowres != m_requestedLowres) {
+    lowres = getSupportedLowres(mode.lowres);
+  }
+
+  if (lowres != m_mode.lowres) {
+    LOG_INFO("Reopening decoder " + std::string(m_codec->name) +
+             " with lowres " + std::to_string(lowres));
+
+    // The current context stays in use if the new one cannot be opened
+    auto ctx = openContext(lowres);
+    avcodec_free_context(&m_codecCtx);
+    m_codecCtx = ctx;
+    m_threading = getEffectiveThreading(m_codecCtx, m_requestedThreading);
+  }
+
+  m_requestedLowres = mode.lowres;
+  m_mode = mode;
+  m_mode.lowres = lowres;
+  applyDecodeMode();
+}
+
+DecodeMode DecoderImpl::getDecodeMode() const { return m_mode; }
+
+void DecoderImpl::setTimebase(time::Timebase const &tb) { m_tb = tb; }
 } // namespace avcodec
 } // namespace libffmpegxx
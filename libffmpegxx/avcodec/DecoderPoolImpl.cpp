@@ -0,0 +1,86 @@
+#include "avcodec/DecoderPoolImpl.h"
+
+#include "avcodec/DecoderImpl.h"
+#include "avutil/ChannelLayout.h"
+#include "utils/LoggerApi.h"
+
+namespace libffmpegxx {
+namespace avcodec {
+namespace {
+/**
+ * @return the 64 bits FNV-1a hash of the given data.
+ */
+uint64_t hashData(uint8_t const *data, int size) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (int i = 0; i < size; ++i) {
+    hash = (hash ^ data[i]) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+} // namespace
+
+IDecoderPool *DecoderPoolFactory::create(DecoderPoolConfig const &config) {
+  return new DecoderPoolImpl(config);
+}
+
+DecoderPoolImpl::DecoderPoolImpl(DecoderPoolConfig const &config)
+    : m_config(config),
+      m_pool(
+          config.maxIdle,
+          [mode = config.mode](DecoderImpl &decoder) {
+            try {
+              decoder.reset();
+              decoder.setDecodeMode(mode);
+            } catch (std::exception const &e) {
+              LOG_WARN(std::string("Could not recycle decoder: ") + e.what());
+              return false;
+            }
+            return true;
+          },
+          std::chrono::duration_cast<
+              utils::RecyclingPool<DecoderImpl>::Clock::duration>(
+              config.maxIdleTime)) {}
+
+std::shared_ptr<IDecoder>
+DecoderPoolImpl::acquire(avformat::StreamInfo const &streamInfo) {
+  auto const key = buildKey(streamInfo);
+
+  auto decoder = m_pool.take(key);
+  if (decoder) {
+    decoder->setTimebase(streamInfo.timebase);
+  } else {
+    decoder = std::make_unique<DecoderImpl>(
+        streamInfo, m_config.options, m_config.threading, m_config.mode);
+  }
+
+  return m_pool.share<IDecoder>(std::move(decoder), key);
+}
+
+void DecoderPoolImpl::evict() { m_pool.evict(); }
+
+void DecoderPoolImpl::clear() { m_pool.clear(); }
+
+DecoderPoolStatistics DecoderPoolImpl::getStatistics() const {
+  auto const poolStats = m_pool.getStatistics();
+
+  DecoderPoolStatistics stats;
+  stats.hits = poolStats.hits;
+  stats.misses = poolStats.misses;
+  stats.evictions = poolStats.evictions;
+  stats.idle = poolStats.idle;
+  return stats;
+}
+
+DecoderPoolImpl::Key
+DecoderPoolImpl::buildKey(avformat::StreamInfo const &streamInfo) {
+  auto const codecPar = *streamInfo.codecPar;
+  return Key{streamInfo.codecId,
+             hashData(codecPar->extradata, codecPar->extradata_size),
+             codecPar->width,
+             codecPar->height,
+             codecPar->format,
+             codecPar->sample_rate,
+             avutil::getChannelCount(codecPar)};
+}
+}; // namespace avcodec
+}; // namespace libffmpegxx
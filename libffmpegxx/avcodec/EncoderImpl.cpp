@@ -6,15 +6,36 @@
 #include "avcodec/AVPacketImpl.h"
 #include "avutil/AVFrameImpl.h"
 #include "utils/LoggerApi.h"
+#include "utils/ThreadAffinity.h"
 #include "utils/exception.h"
 
 namespace libffmpegxx {
+namespace utils {
+extern AVDictionary *toAVDictionary(AVOptions const &options);
+}
+
 namespace avcodec {
+extern void applyThreadingPolicy(AVCodecContext *ctx,
+                                 ThreadingPolicy const &policy);
+extern ThreadingPolicy getEffectiveThreading(AVCodecContext const *ctx,
+                                             ThreadingPolicy const &policy);
+extern utils::AVOptions logRejectedOptions(AVDictionary *opts,
+                                           std::string const &codecName);
+
 IEncoder *EncoderFactory::create(avformat::StreamInfo const &streamInfo) {
   return new EncoderImpl(streamInfo);
 }
 
-EncoderImpl::EncoderImpl(const avformat::StreamInfo &streamInfo) {
+IEncoder *EncoderFactory::create(avformat::StreamInfo const &streamInfo,
+                                 EncoderSettings const &settings,
+                                 utils::AVOptions const &options) {
+  return new EncoderImpl(streamInfo, settings, options);
+}
+
+EncoderImpl::EncoderImpl(avformat::StreamInfo const &streamInfo,
+                         EncoderSettings const &settings,
+                         utils::AVOptions const &options)
+    : m_streamInfo(streamInfo), m_type(streamInfo.type) {
   auto codec = avcodec_find_encoder(streamInfo.codecId);
   if (!codec) {
     LOG_FATAL("Could not find an encoder for codec id " +
@@ -28,31 +49,134 @@ EncoderImpl::EncoderImpl(const avformat::StreamInfo &streamInfo) {
   }
 
   avcodec_parameters_to_context(m_codecCtx, *streamInfo.codecPar);
+  applySettings(streamInfo, settings);
+
+  // Free-form options are added first so they win over the typed settings
+  auto opts = utils::toAVDictionary(options);
+  if (!settings.preset.empty()) {
+    av_dict_set(&opts, "preset", settings.preset.c_str(),
+                AV_DICT_DONT_OVERWRITE);
+  }
+  if (!settings.tune.empty()) {
+    av_dict_set(&opts, "tune", settings.tune.c_str(), AV_DICT_DONT_OVERWRITE);
+  }
+  if (settings.rcLookahead >= 0) {
+    av_dict_set_int(&opts, "rc-lookahead", settings.rcLookahead,
+                    AV_DICT_DONT_OVERWRITE);
+  }
+
+  int error = 0;
+  try {
+    // Worker threads are spawned while opening and inherit the affinity
+    utils::ScopedThreadAffinity const affinity(settings.threading.cpus);
+    error = avcodec_open2(m_codecCtx, codec, &opts);
+  } catch (std::runtime_error const &) {
+    av_dict_free(&opts);
+    avcodec_free_context(&m_codecCtx);
+    throw;
+  }
+
+  m_rejectedOptions = logRejectedOptions(opts, codec->name);
+  av_dict_free(&opts);
+
+  if (error < 0) {
+    avcodec_free_context(&m_codecCtx);
+    LOG_FATAL_FFMPEG_ERR("Could not open encoder " + std::string(codec->name),
+                         error);
+  }
+
+  // The encoder may adjust the timebase while opening
+  m_tb = time::Timebase(m_codecCtx->time_base.num, m_codecCtx->time_base.den);
+  m_threading = getEffectiveThreading(m_codecCtx, settings.threading);
+
+  // Extradata and other parameters are only known once opened
+  avcodec_parameters_from_context(*m_streamInfo.codecPar, m_codecCtx);
+  m_streamInfo.codecId = codec->id;
+  m_streamInfo.codecName = codec->name;
+  m_streamInfo.timebase = m_tb;
+
+  m_rescaledFrame = av_frame_alloc();
 
+  LOG_DEBUG("Encoder " + std::string(codec->name) + " opened with " +
+            std::to_string(m_threading.threadCount) + " thread(s)");
+}
+
+void EncoderImpl::applySettings(avformat::StreamInfo const &streamInfo,
+                                EncoderSettings const &settings) {
   if (std::holds_alternative<avformat::VideoInfo>(streamInfo.properties)) {
     auto const videoProps =
         std::get<avformat::VideoInfo>(streamInfo.properties);
-    m_codecCtx->time_base = {videoProps.averageFramerate.num(),
-                             videoProps.averageFramerate.den()};
+    auto const &fr = videoProps.averageFramerate;
+    if (fr.num() > 0 && fr.den() > 0) {
+      m_codecCtx->framerate = {fr.num(), fr.den()};
+      m_codecCtx->time_base = {fr.den(), fr.num()};
+    }
+  } else if (m_codecCtx->sample_rate > 0) {
+    m_codecCtx->time_base = {1, m_codecCtx->sample_rate};
   }
 
-  int const error = avcodec_open2(m_codecCtx, codec, nullptr);
-  if (error < 0) {
-    LOG_FATAL_FFMPEG_ERR("Could not open decoder for codec ID " +
-                             std::to_string(streamInfo.codecId),
-                         error);
+  if (settings.timebase) {
+    m_codecCtx->time_base = {settings.timebase->num(),
+                             settings.timebase->den()};
   }
 
-  m_tb = streamInfo.timebase;
-  m_type = streamInfo.type;
+  if (m_codecCtx->time_base.num <= 0 || m_codecCtx->time_base.den <= 0) {
+    // Fall back to the stream timebase
+    m_codecCtx->time_base = {streamInfo.timebase.num(),
+                             streamInfo.timebase.den()};
+  }
+
+  applyThreadingPolicy(m_codecCtx, settings.threading);
+
+  if (settings.slices > 0) {
+    m_codecCtx->slices = settings.slices;
+  }
+  if (settings.gopSize >= 0) {
+    m_codecCtx->gop_size = settings.gopSize;
+  }
+  if (settings.bitrate > 0) {
+    m_codecCtx->bit_rate = settings.bitrate;
+  }
+  if (settings.maxBFrames >= 0) {
+    m_codecCtx->max_b_frames = settings.maxBFrames;
+  }
+  if (settings.globalHeader) {
+    m_codecCtx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+  }
 }
 
 EncoderImpl::~EncoderImpl() {
+  av_frame_free(&m_rescaledFrame);
   if (m_codecCtx) {
     avcodec_free_context(&m_codecCtx);
   }
 }
 
+int EncoderImpl::sendFrame(avutil::AVFrameImpl *frame) {
+  if (!frame) {
+    return avcodec_send_frame(m_codecCtx, nullptr);
+  }
+
+  auto const wrapped = frame->getWrappedFrame();
+  auto const frameTb = frame->getTimebase();
+  if (wrapped->pts == AV_NOPTS_VALUE || frameTb == m_tb) {
+    return avcodec_send_frame(m_codecCtx, wrapped);
+  }
+
+  // The caller's frame keeps its own timestamp
+  auto error = av_frame_ref(m_rescaledFrame, wrapped);
+  if (error < 0) {
+    return error;
+  }
+  m_rescaledFrame->pts = av_rescale_q(
+      wrapped->pts, {frameTb.num(), frameTb.den()}, m_codecCtx->time_base);
+
+  error = avcodec_send_frame(m_codecCtx, m_rescaledFrame);
+  av_frame_unref(m_rescaledFrame);
+
+  return error;
+}
+
 int EncoderImpl::encode(avutil::IAVFrame *frame, IAVPacket *packet) {
   auto frameImpl = dynamic_cast<avutil::AVFrameImpl *>(frame);
   if (!frameImpl) {
@@ -64,26 +188,97 @@ int EncoderImpl::encode(avutil::IAVFrame *frame, IAVPacket *packet) {
     LOG_FATAL("Error handling packet while decoding");
   }
 
-  auto error = avcodec_send_frame(m_codecCtx, frameImpl->getWrappedFrame());
-  if (error != 0) {
+  auto const sendError = sendFrame(frameImpl);
+  if (sendError < 0 && sendError != AVERROR(EAGAIN)) {
     LOG_ERROR("Error sending frame to encoder " +
-              utils::Logger::avErrorToStr(error));
+              utils::Logger::avErrorToStr(sendError));
+    packet->clear();
+    return sendError;
   }
 
-  error = avcodec_receive_packet(m_codecCtx, packetImpl->getWrappedPacket());
+  // Also frees room in the encoder if it did not take the frame
+  auto const error =
+      avcodec_receive_packet(m_codecCtx, packetImpl->getWrappedPacket());
   if (error != 0) {
     if (error != AVERROR(EAGAIN)) {
       LOG_ERROR("Error retrieving packet from from encoder " +
                 utils::Logger::avErrorToStr(error));
     }
     packet->clear();
+  } else {
+    packetImpl->setTimebase(m_tb);
   }
 
+  if (sendError == AVERROR(EAGAIN) &&
+      (error == 0 || error == AVERROR(EAGAIN))) {
+    // The caller must send the frame again
+    return AVERROR(EAGAIN);
+  }
+  return error;
+}
+
+int EncoderImpl::encode(avutil::IAVFrame *frame, PacketSink const &sink) {
+  avutil::AVFrameImpl *frameImpl{nullptr};
+  if (frame) {
+    frameImpl = dynamic_cast<avutil::AVFrameImpl *>(frame);
+    if (!frameImpl) {
+      LOG_FATAL("Error handling frame while encoding");
+    }
+  }
+
+  int received = 0;
+  int error = 0;
+  while ((error = sendFrame(frameImpl)) == AVERROR(EAGAIN)) {
+    // The encoder output must be consumed before it accepts more input
+    int const before = received;
+    error = receivePackets(sink, received);
+    if (error != AVERROR(EAGAIN) || received == before) {
+      LOG_ERROR("Encoder did not accept frame after draining: " +
+                utils::Logger::avErrorToStr(error));
+      return error < 0 ? error : AVERROR(EAGAIN);
+    }
+  }
+
+  if (error < 0) {
+    // EOF means the encoder was already flushed
+    if (error != AVERROR_EOF) {
+      LOG_ERROR("Error sending frame to encoder: " +
+                utils::Logger::avErrorToStr(error));
+    }
+    return error;
+  }
+
+  error = receivePackets(sink, received);
+  if (error == AVERROR(EAGAIN)) {
+    return 0;
+  }
+
+  if (error != AVERROR_EOF) {
+    LOG_ERROR("Error receiving packet from encoder: " +
+              utils::Logger::avErrorToStr(error));
+  }
+  return error;
+}
+
+int EncoderImpl::receivePackets(PacketSink const &sink, int &received) {
+  int error = 0;
+  while (true) {
+    auto const packet = m_packetPool.acquire();
+    error = avcodec_receive_packet(m_codecCtx, packet->getWrappedPacket());
+    if (error < 0) {
+      break;
+    }
+
+    packet->setTimebase(m_tb);
+    packet->setContentType(m_type);
+    ++received;
+    sink(packet);
+  }
   return error;
 }
 
 int EncoderImpl::flush(std::vector<avcodec::IAVPacket *> &flushedPackets) {
-  auto error = avcodec_send_frame(m_codecCtx, nullptr);
+  auto error = sendFrame(nullptr);
   if (error < 0) {
     LOG_ERROR("Error sending packet to encoder while flushing: " +
               utils::Logger::avErrorToStr(error));
@@ -110,5 +305,17 @@ int EncoderImpl::flush(std::vector<avcodec::IAVPacket *> &flushedPackets) {
 
   return error;
 }
+
+utils::AVOptions EncoderImpl::getRejectedOptions() const {
+  return m_rejectedOptions;
+}
+
+ThreadingPolicy EncoderImpl::getThreading() const { return m_threading; }
+
+time::Timebase EncoderImpl::getTimebase() const { return m_tb; }
+
+avformat::StreamInfo EncoderImpl::getStreamInfo() const {
+  return m_streamInfo;
+}
 } // namespace avcodec
 } // namespace libffmpegxx
@@ -0,0 +1,177 @@
+#include "avcodec/ParallelDecoderImpl.h"
+
+#include "utils/LoggerApi.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace libffmpegxx {
+namespace avcodec {
+IParallelDecoder *
+ParallelDecoderFactory::create(std::string const &uri, int streamIdx,
+                               ParallelDecodeConfig const &config) {
+  return new ParallelDecoderImpl(uri, streamIdx, config);
+}
+
+ParallelDecoderImpl::ParallelDecoderImpl(std::string const &uri,
+                                         int streamIdx,
+                                         ParallelDecodeConfig const &config)
+    : m_uri(uri), m_streamIdx(streamIdx), m_config(config) {
+  if (m_config.workers <= 0) {
+    m_config.workers =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  m_config.gopsPerSegment = std::max(1, m_config.gopsPerSegment);
+  m_window = m_config.reorderWindow > 0 ? m_config.reorderWindow
+                                        : 2 * m_config.workers;
+}
+
+ParallelDecoderImpl::~ParallelDecoderImpl() { stop(); }
+
+int ParallelDecoderImpl::decode(FrameSink const &sink) {
+  m_stopRequested = false;
+  m_error = 0;
+  m_nextSegment = 0;
+  m_delivered = 0;
+
+  buildSegments(avformat::KeyframeIndex(m_uri, m_streamIdx,
+                                        m_config.demuxerOptions));
+  if (m_segments.empty()) {
+    LOG_WARN("No keyframes found in stream " + std::to_string(m_streamIdx) +
+             " of " + m_uri);
+    return 0;
+  }
+
+  auto const workerCount =
+      std::min(static_cast<size_t>(m_config.workers), m_segments.size());
+  LOG_INFO("Decoding " + std::to_string(m_segments.size()) +
+           " segments of " + m_uri + " with " + std::to_string(workerCount) +
+           " workers");
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < workerCount; ++i) {
+    workers.emplace_back(&ParallelDecoderImpl::work, this);
+  }
+
+  try {
+    for (size_t idx = 0; idx < m_segments.size(); ++idx) {
+      Frames frames;
+      {
+        std::unique_lock<std::mutex> l(m_mutex);
+        m_cv.wait(l, [this, idx] {
+          return m_segments[idx].done || m_stopRequested;
+        });
+        if (!m_segments[idx].done) {
+          break;
+        }
+
+        // Frees a slot of the reorder window
+        frames.swap(m_segments[idx].frames);
+        m_delivered = idx + 1;
+      }
+      m_cv.notify_all();
+
+      for (auto &&frame : frames) {
+        sink(frame);
+      }
+    }
+  } catch (...) {
+    stop();
+    for (auto &&worker : workers) {
+      worker.join();
+    }
+    throw;
+  }
+
+  stop();
+  for (auto &&worker : workers) {
+    worker.join();
+  }
+
+  std::lock_guard<std::mutex> l(m_mutex);
+  return m_error;
+}
+
+void ParallelDecoderImpl::stop() {
+  {
+    std::lock_guard<std::mutex> l(m_mutex);
+    m_stopRequested = true;
+  }
+  m_cv.notify_all();
+}
+
+void ParallelDecoderImpl::buildSegments(avformat::KeyframeIndex const &index) {
+  m_segments.clear();
+
+  auto const &keyframes = index.getKeyframes();
+  auto const step = static_cast<size_t>(m_config.gopsPerSegment);
+  for (size_t i = 0; i < keyframes.size(); i += step) {
+    Segment segment;
+    segment.range.start = keyframes[i];
+    segment.range.first = i == 0;
+    if (i + step < keyframes.size()) {
+      segment.range.end = keyframes[i + step];
+    }
+    m_segments.push_back(std::move(segment));
+  }
+}
+
+void ParallelDecoderImpl::work() {
+  try {
+    SegmentDecoder decoder(m_uri, m_streamIdx, m_config.demuxerOptions,
+                           m_config.decoderOptions, m_config.threading,
+                           m_config.mode);
+
+    while (!m_stopRequested) {
+      size_t const idx = m_nextSegment++;
+      if (idx >= m_segments.size()) {
+        break;
+      }
+
+      {
+        std::unique_lock<std::mutex> l(m_mutex);
+        m_cv.wait(l, [this, idx] {
+          return m_stopRequested || idx < m_delivered + m_window;
+        });
+        if (m_stopRequested) {
+          break;
+        }
+      }
+
+      Frames frames;
+      int const error = decoder.decode(
+          m_segments[idx].range,
+          [&frames](std::shared_ptr<avutil::IAVFrame> const &frame) {
+            frames.push_back(frame);
+          },
+          m_stopRequested);
+      if (error < 0) {
+        fail(error);
+        break;
+      }
+
+      {
+        std::lock_guard<std::mutex> l(m_mutex);
+        m_segments[idx].frames = std::move(frames);
+        m_segments[idx].done = true;
+      }
+      m_cv.notify_all();
+    }
+  } catch (std::exception const &e) {
+    LOG_ERROR("Parallel decoding of " + m_uri + " failed: " + e.what());
+    fail(AVERROR_UNKNOWN);
+  }
+}
+
+void ParallelDecoderImpl::fail(int error) {
+  {
+    std::lock_guard<std::mutex> l(m_mutex);
+    if (m_error == 0) {
+      m_error = error;
+    }
+    m_stopRequested = true;
+  }
+  m_cv.notify_all();
+}
+}; // namespace avcodec
+}; // namespace libffmpegxx
@@ -0,0 +1,178 @@
+#include "avcodec/SeekingDecoderImpl.h"
+
+#include "public/avformat/IDemuxer.h"
+#include "public/time/Timestamp.h"
+
+#include "avcodec/AVPacketImpl.h"
+#include "avcodec/DecoderImpl.h"
+#include "avutil/AVFrameImpl.h"
+#include "utils/LoggerApi.h"
+#include "utils/exception.h"
+
+#include <variant>
+
+extern "C" {
+#include <libavutil/mathematics.h>
+}
+
+namespace libffmpegxx {
+namespace avcodec {
+namespace {
+int64_t framePts(avutil::IAVFrame *frame) {
+  auto const avframe =
+      dynamic_cast<avutil::AVFrameImpl *>(frame)->getWrappedFrame();
+  return avframe->best_effort_timestamp != AV_NOPTS_VALUE
+             ? avframe->best_effort_timestamp
+             : avframe->pts;
+}
+} // namespace
+
+ISeekingDecoder *
+SeekingDecoderFactory::create(avformat::IDemuxer *demuxer, int streamIdx,
+                              utils::AVOptions const &options,
+                              ThreadingPolicy const &threading) {
+  return new SeekingDecoderImpl(demuxer, streamIdx, options, threading);
+}
+
+SeekingDecoderImpl::SeekingDecoderImpl(avformat::IDemuxer *demuxer,
+                                       int streamIdx,
+                                       utils::AVOptions const &options,
+                                       ThreadingPolicy const &threading)
+    : m_demuxer(demuxer), m_streamIdx(streamIdx) {
+  if (!m_demuxer) {
+    LOG_FATAL("Demuxer cannot be null when creating a seeking decoder");
+  }
+
+  auto const info = m_demuxer->getMediaInfo();
+  auto const stream = info.streamsInfo.find(m_streamIdx);
+  if (stream == info.streamsInfo.end()) {
+    LOG_FATAL("Stream " + std::to_string(m_streamIdx) + " not found in " +
+              info.uri);
+  }
+
+  m_tb = stream->second.timebase;
+  m_decoder = std::make_unique<DecoderImpl>(stream->second, options, threading);
+
+  // Fallback for packets with no duration
+  if (auto const video =
+          std::get_if<avformat::VideoInfo>(&stream->second.properties);
+      video && video->averageFramerate.num() > 0 &&
+      video->averageFramerate.den() > 0) {
+    m_frameDuration = av_rescale_q(
+        1, {video->averageFramerate.den(), video->averageFramerate.num()},
+        {m_tb.num(), m_tb.den()});
+  }
+}
+
+SeekingDecoderImpl::~SeekingDecoderImpl() = default;
+
+std::shared_ptr<avutil::IAVFrame>
+SeekingDecoderImpl::decodeAt(time::Timestamp const &ts) {
+  auto const target = ts.toTimebase(m_tb).value();
+  if (m_lastFrame && target == m_lastTarget) {
+    return m_lastFrame;
+  }
+  m_lastFrame.reset();
+
+  // Indexes are searched by DTS, which precede the PTS by the reorder delay,
+  // so seeking may land on a keyframe presented after the target. Seeking
+  // again right before its DTS gets the previous keyframe.
+  std::shared_ptr<avutil::IAVFrame> best;
+  std::shared_ptr<avutil::IAVFrame> first;
+  auto seekTs = target;
+  while (true) {
+    int64_t keyframeDts = AV_NOPTS_VALUE;
+    decodeFrom(seekTs, target, best, first, keyframeDts);
+    if (best || !first || keyframeDts == AV_NOPTS_VALUE ||
+        keyframeDts <= 0 || keyframeDts - 1 >= seekTs) {
+      break;
+    }
+
+    LOG_DEBUG("Keyframe at DTS " + std::to_string(keyframeDts) +
+              " is presented after " + std::to_string(target) +
+              ", seeking again");
+    seekTs = keyframeDts - 1;
+  }
+
+  m_lastFrame = best ? best : first;
+  m_lastTarget = target;
+  return m_lastFrame;
+}
+
+void SeekingDecoderImpl::decodeFrom(
+    int64_t seekTs, int64_t target, std::shared_ptr<avutil::IAVFrame> &best,
+    std::shared_ptr<avutil::IAVFrame> &first, int64_t &keyframeDts) {
+  best.reset();
+  first.reset();
+
+  int error = m_demuxer->seek(m_streamIdx, time::Timestamp(seekTs, m_tb));
+  if (error < 0) {
+    LOG_FATAL_FFMPEG_ERR("Could not seek to " + std::to_string(seekTs), error);
+  }
+  m_decoder->reset();
+
+  // Non-reference frames displayed entirely before the target cannot be it
+  // nor be needed by it. Any packet still displayed at the target or later
+  // is decoded in full, since the target may be a non-reference frame.
+  auto const fullMode = m_decoder->getDecodeMode();
+  auto preRollMode = fullMode;
+  preRollMode.skipFrame = AVDISCARD_NONREF;
+  m_decoder->setDecodeMode(preRollMode);
+  bool preRoll = true;
+  bool done = false;
+
+  // Pre-roll frames are dropped right away, going back to the frame pool
+  auto const sink = [&](std::shared_ptr<avutil::IAVFrame> const &frame) {
+    if (done) {
+      return;
+    }
+    auto const pts = framePts(frame.get());
+    if (pts != AV_NOPTS_VALUE && pts > target) {
+      if (!best && !first) {
+        first = frame;
+      }
+      done = true;
+      return;
+    }
+    best = frame;
+  };
+
+  AVPacketImpl packet;
+  while (!done && (error = m_demuxer->read(&packet)) >= 0) {
+    if (packet.getStreamIndex() != m_streamIdx) {
+      continue;
+    }
+
+    auto const avpacket = packet.getWrappedPacket();
+    if (keyframeDts == AV_NOPTS_VALUE) {
+      keyframeDts = avpacket->dts;
+    }
+
+    // Without a known duration any packet may still be displayed at the
+    // target
+    auto const duration =
+        avpacket->duration > 0 ? avpacket->duration : m_frameDuration;
+    if (preRoll && avpacket->pts != AV_NOPTS_VALUE &&
+        (duration <= 0 || avpacket->pts + duration > target)) {
+      m_decoder->setDecodeMode(fullMode);
+      preRoll = false;
+    }
+
+    error = m_decoder->decode(&packet, sink);
+    if (error < 0 && error != AVERROR_INVALIDDATA) {
+      break;
+    }
+  }
+
+  if (!done) {
+    // End of stream: the target may be among the frames still buffered
+    m_decoder->setDecodeMode(fullMode);
+    m_decoder->decode(nullptr, sink);
+  }
+
+  if (preRoll) {
+    m_decoder->setDecodeMode(fullMode);
+  }
+}
+}; // namespace avcodec
+}; // namespace libffmpegxx
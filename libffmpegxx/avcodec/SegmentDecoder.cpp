@@ -0,0 +1,154 @@
+#include "avcodec/SegmentDecoder.h"
+
+#include "public/time/Timestamp.h"
+
+#include "avcodec/AVPacketImpl.h"
+#include "avcodec/DecoderImpl.h"
+#include "avformat/DemuxerImpl.h"
+#include "avutil/AVFrameImpl.h"
+#include "utils/LoggerApi.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace libffmpegxx {
+namespace avcodec {
+namespace {
+/**
+ * @return the presentation timestamp of a decoded frame.
+ */
+int64_t framePts(avutil::IAVFrame *frame) {
+  auto const avframe =
+      dynamic_cast<avutil::AVFrameImpl *>(frame)->getWrappedFrame();
+  return avframe->best_effort_timestamp != AV_NOPTS_VALUE
+             ? avframe->best_effort_timestamp
+             : avframe->pts;
+}
+
+int64_t decodeOrderTs(AVPacket const *packet) {
+  return packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+}
+} // namespace
+
+SegmentDecoder::SegmentDecoder(std::string const &uri, int streamIdx,
+                               utils::AVOptions const &demuxerOptions,
+                               utils::AVOptions const &decoderOptions,
+                               ThreadingPolicy const &threading,
+                               DecodeMode const &mode)
+    : m_streamIdx(streamIdx),
+      m_demuxer(std::make_unique<avformat::DemuxerImpl>(uri)) {
+  auto const info = m_demuxer->open(demuxerOptions);
+
+  auto const stream = info.streamsInfo.find(m_streamIdx);
+  if (stream == info.streamsInfo.end()) {
+    LOG_FATAL("Stream " + std::to_string(m_streamIdx) + " not found in " +
+              uri);
+  }
+  m_streamInfo = stream->second;
+
+  for (auto &&[idx, _] : info.streamsInfo) {
+    if (idx != m_streamIdx) {
+      m_demuxer->setDiscard(idx, AVDISCARD_ALL);
+    }
+  }
+
+  m_decoder = std::make_unique<DecoderImpl>(m_streamInfo, decoderOptions,
+                                            threading, mode);
+}
+
+SegmentDecoder::~SegmentDecoder() = default;
+
+avformat::StreamInfo const &SegmentDecoder::getStreamInfo() const {
+  return m_streamInfo;
+}
+
+int SegmentDecoder::decode(SegmentRange const &segment, FrameSink const &sink,
+                           std::atomic<bool> const &stopRequested) {
+  m_decoder->reset();
+
+  // Timestamps cannot be negative. Seeking backwards to 0 reaches the first
+  // keyframe anyway.
+  int error = m_demuxer->seek(
+      m_streamIdx,
+      time::Timestamp(std::max<int64_t>(segment.start.getDecodeOrderTs(), 0),
+                      m_streamInfo.timebase));
+  if (error < 0) {
+    return error;
+  }
+
+  auto const lower =
+      segment.first ? std::numeric_limits<int64_t>::min() : segment.start.pts;
+  auto const upper =
+      segment.end ? segment.end->pts : std::numeric_limits<int64_t>::max();
+  auto const keep = [&sink, lower,
+                     upper](std::shared_ptr<avutil::IAVFrame> const &frame) {
+    auto const pts = framePts(frame.get());
+    if (pts == AV_NOPTS_VALUE || (pts >= lower && pts < upper)) {
+      sink(frame);
+    }
+  };
+
+  auto const decodePacket = [this, &keep](AVPacketImpl *packet) {
+    int const error = m_decoder->decode(packet, keep);
+    // Corrupted packets are skipped, as a sequential decode would do
+    return error == AVERROR_INVALIDDATA ? 0 : error;
+  };
+
+  AVPacketImpl packet;
+  AVPacketImpl nextKeyframe;
+  bool started = false;
+  bool pastEnd = false;
+
+  while ((error = m_demuxer->read(&packet)) >= 0 && !stopRequested) {
+    if (packet.getStreamIndex() != m_streamIdx) {
+      continue;
+    }
+
+    auto const avpacket = packet.getWrappedPacket();
+
+    // Seeking may land on an earlier keyframe
+    if (!started) {
+      if (decodeOrderTs(avpacket) < segment.start.getDecodeOrderTs()) {
+        continue;
+      }
+      started = true;
+    }
+
+    if (segment.end && !pastEnd &&
+        decodeOrderTs(avpacket) >= segment.end->getDecodeOrderTs()) {
+      // The next segment keyframe is only needed as reference for leading
+      // pictures (open GOP), which are presented within this segment
+      pastEnd = true;
+      packet.moveToPacket(&nextKeyframe);
+      continue;
+    }
+
+    if (pastEnd) {
+      if (avpacket->pts == AV_NOPTS_VALUE || avpacket->pts >= upper) {
+        break;
+      }
+
+      if (nextKeyframe.getSize() > 0) {
+        error = decodePacket(&nextKeyframe);
+        nextKeyframe.clear();
+        if (error < 0) {
+          return error;
+        }
+      }
+    }
+
+    error = decodePacket(&packet);
+    if (error < 0) {
+      return error;
+    }
+  }
+
+  if (error < 0 && error != AVERROR_EOF) {
+    return error;
+  }
+
+  error = m_decoder->decode(nullptr, keep);
+  return error == AVERROR_EOF ? 0 : error;
+}
+}; // namespace avcodec
+}; // namespace libffmpegxx
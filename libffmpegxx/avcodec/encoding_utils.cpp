@@ -0,0 +1,72 @@
+#include "public/avformat/MediaInfo.h"
+
+#include <algorithm>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/mathematics.h>
+}
+
+namespace libffmpegxx {
+namespace avcodec {
+namespace {
+/**
+ * @return the value rounded to the closest even number, as most encoders
+ * need even dimensions.
+ */
+int toEven(int64_t value) {
+  return static_cast<int>(std::max<int64_t>(2, (value + 1) & ~int64_t{1}));
+}
+} // namespace
+
+void fitVideoSize(AVCodecParameters const *source, int &width, int &height) {
+  if (width <= 0 && height <= 0) {
+    width = source->width;
+    height = source->height;
+  } else if (width <= 0) {
+    width = toEven(av_rescale(height, source->width, source->height));
+  } else if (height <= 0) {
+    height = toEven(av_rescale(width, source->height, source->width));
+  }
+}
+
+AVPixelFormat chooseEncoderPixelFormat(AVCodec const *codec,
+                                       AVPixelFormat requested,
+                                       AVPixelFormat source) {
+  if (requested != AV_PIX_FMT_NONE) {
+    return requested;
+  }
+
+  if (!codec->pix_fmts) {
+    return source;
+  }
+
+  for (auto format = codec->pix_fmts; *format != AV_PIX_FMT_NONE; ++format) {
+    if (*format == source) {
+      return source;
+    }
+  }
+  return codec->pix_fmts[0];
+}
+
+avformat::StreamInfo makeEncodedStreamInfo(avformat::StreamInfo const &source,
+                                           AVCodec const *codec, int width,
+                                           int height, AVPixelFormat format) {
+  avformat::StreamInfo info = source;
+  info.index = 0;
+  info.codecId = codec->id;
+  info.codecName = codec->name;
+
+  // Fresh codec parameters so nothing of the source codec leaks in
+  info.codecPar = AVCodecPar();
+  info.codecPar->codec_type = AVMEDIA_TYPE_VIDEO;
+  info.codecPar->codec_id = codec->id;
+  info.codecPar->width = width;
+  info.codecPar->height = height;
+  info.codecPar->format = format;
+  info.codecPar->sample_aspect_ratio = source.codecPar->sample_aspect_ratio;
+
+  return info;
+}
+}; // namespace avcodec
+}; // namespace libffmpegxx
@@ -0,0 +1,67 @@
+#include "public/avcodec/ThreadingPolicy.h"
+
+#include "public/utils/AVOptions.h"
+#include "utils/LoggerApi.h"
+
+#include <string>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace libffmpegxx {
+namespace utils {
+extern AVOptions fromAVDictionary(AVDictionary *dict);
+}
+
+namespace avcodec {
+void applyThreadingPolicy(AVCodecContext *ctx, ThreadingPolicy const &policy) {
+  switch (policy.mode) {
+  case ThreadingMode::AUTO:
+    ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    break;
+  case ThreadingMode::FRAME:
+    ctx->thread_type = FF_THREAD_FRAME;
+    break;
+  case ThreadingMode::SLICE:
+    ctx->thread_type = FF_THREAD_SLICE;
+    break;
+  case ThreadingMode::NONE:
+    ctx->thread_type = 0;
+    ctx->thread_count = 1;
+    return;
+  }
+
+  // With 0 threads FFmpeg uses the cores of the calling thread affinity,
+  // which is already restricted to the pinned ones while opening
+  ctx->thread_count = policy.threadCount > 0 ? policy.threadCount : 0;
+}
+
+ThreadingPolicy getEffectiveThreading(AVCodecContext const *ctx,
+                                      ThreadingPolicy const &policy) {
+  ThreadingPolicy effective;
+  effective.threadCount = ctx->thread_count;
+  effective.cpus = policy.cpus;
+
+  if (ctx->thread_count <= 1 || ctx->active_thread_type == 0) {
+    effective.mode = ThreadingMode::NONE;
+    effective.threadCount = 1;
+  } else if (ctx->active_thread_type & FF_THREAD_FRAME) {
+    effective.mode = ThreadingMode::FRAME;
+  } else {
+    effective.mode = ThreadingMode::SLICE;
+  }
+
+  return effective;
+}
+
+utils::AVOptions logRejectedOptions(AVDictionary *opts,
+                                    std::string const &codecName) {
+  auto const rejected = utils::fromAVDictionary(opts);
+  for (auto &&[key, _] : rejected) {
+    LOG_WARN("Option " + key + " not accepted by codec " + codecName);
+  }
+  return rejected;
+}
+} // namespace avcodec
+} // namespace libffmpegxx
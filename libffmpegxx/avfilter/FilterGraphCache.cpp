@@ -0,0 +1,203 @@
+#include "avfilter/FilterGraphCache.h"
+
+#include "avutil/AVFrameImpl.h"
+#include "avutil/ChannelLayout.h"
+#include "utils/LoggerApi.h"
+#include "utils/exception.h"
+
+extern "C" {
+#include <libavfilter/buffersink.h>
+#include <libavfilter/buffersrc.h>
+#include <libavutil/mem.h>
+}
+
+namespace libffmpegxx {
+namespace avfilter {
+ConfiguredGraph::~ConfiguredGraph() {
+  // Frees the filters too
+  avfilter_graph_free(&graph);
+}
+
+FilterGraphCache::FilterGraphCache(FilterGraphConfig const &config)
+    : m_config(config),
+      m_threads(utils::ThreadPool::resolveThreads(config.threads)),
+      m_threadPool(utils::ThreadPool::createForCaller(m_threads)),
+      m_graphs(config.maxIdleGraphs, [](ConfiguredGraph &graph) {
+        return graph.reusable;
+      }) {}
+
+FilterGraphCache::Key FilterGraphCache::getKey(avutil::AVFrameImpl *frame) {
+  auto const avframe = frame->getWrappedFrame();
+  auto const tb = frame->getTimebase();
+
+  if (avframe->width > 0 && avframe->height > 0) {
+    return {AVMEDIA_TYPE_VIDEO,
+            avframe->format,
+            avframe->width,
+            avframe->height,
+            avframe->sample_aspect_ratio.num,
+            avframe->sample_aspect_ratio.den,
+            0,
+            0,
+            tb.num(),
+            tb.den()};
+  }
+
+  if (avframe->sample_rate > 0 && avframe->nb_samples > 0) {
+    return {AVMEDIA_TYPE_AUDIO,
+            avframe->format,
+            0,
+            0,
+            0,
+            0,
+            avframe->sample_rate,
+            avutil::getChannelMask(avframe),
+            tb.num(),
+            tb.den()};
+  }
+
+  LOG_FATAL("Cannot filter a frame with no video or audio");
+}
+
+std::shared_ptr<ConfiguredGraph> FilterGraphCache::get(Key const &key) {
+  auto graph = m_graphs.take(key);
+  if (!graph) {
+    graph = createGraph(key);
+  }
+
+  return m_graphs.share(std::move(graph), key);
+}
+
+void FilterGraphCache::clear() { m_graphs.clear(); }
+
+size_t FilterGraphCache::getIdleCount() const {
+  return m_graphs.getIdleCount();
+}
+
+FilterGraphConfig const &FilterGraphCache::getConfig() const {
+  return m_config;
+}
+
+std::unique_ptr<ConfiguredGraph>
+FilterGraphCache::createGraph(Key const &key) const {
+  auto const [type, format, width, height, sarNum, sarDen, sampleRate,
+              layout, tbNum, tbDen] = key;
+  auto const video = type == AVMEDIA_TYPE_VIDEO;
+
+  auto entry = std::make_unique<ConfiguredGraph>();
+  entry->graph = avfilter_graph_alloc();
+  if (!entry->graph) {
+    LOG_FATAL("Could not allocate filter graph");
+  }
+
+  // Must be set before adding filters
+  entry->graph->nb_threads = static_cast<int>(m_threads);
+  if (m_threadPool) {
+    entry->graph->thread_type = AVFILTER_THREAD_SLICE;
+    entry->graph->execute = executeSlices;
+    entry->graph->opaque = m_threadPool.get();
+  }
+
+  entry->source = avfilter_graph_alloc_filter(
+      entry->graph, avfilter_get_by_name(video ? "buffer" : "abuffer"), "in");
+  if (!entry->source) {
+    LOG_FATAL("Could not allocate filter graph source");
+  }
+
+  {
+    auto params = av_buffersrc_parameters_alloc();
+    if (!params) {
+      LOG_FATAL("Could not allocate filter graph source parameters");
+    }
+    params->format = format;
+    params->time_base = {tbNum, tbDen};
+    if (video) {
+      params->width = width;
+      params->height = height;
+      params->sample_aspect_ratio = {sarNum, sarDen};
+      params->frame_rate = m_config.frameRate;
+    } else {
+      params->sample_rate = sampleRate;
+#if AVUTIL_HAS_CH_LAYOUT
+      av_channel_layout_from_mask(&params->ch_layout, layout);
+#else
+      params->channel_layout = layout;
+#endif
+    }
+
+    int const error = av_buffersrc_parameters_set(entry->source, params);
+    av_free(params);
+    if (error < 0) {
+      LOG_FATAL_FFMPEG_ERR("Could not set filter graph source parameters",
+                           error);
+    }
+  }
+
+  {
+    int const error = avfilter_init_str(entry->source, nullptr);
+    if (error < 0) {
+      LOG_FATAL_FFMPEG_ERR("Could not initialize filter graph source", error);
+    }
+  }
+
+  {
+    int const error = avfilter_graph_create_filter(
+        &entry->sink,
+        avfilter_get_by_name(video ? "buffersink" : "abuffersink"), "out",
+        nullptr, nullptr, entry->graph);
+    if (error < 0) {
+      LOG_FATAL_FFMPEG_ERR("Could not create filter graph sink", error);
+    }
+  }
+
+  // The chain input connects to the source output and vice versa
+  auto outputs = avfilter_inout_alloc();
+  auto inputs = avfilter_inout_alloc();
+  if (outputs && inputs) {
+    outputs->name = av_strdup("in");
+    outputs->filter_ctx = entry->source;
+    inputs->name = av_strdup("out");
+    inputs->filter_ctx = entry->sink;
+  }
+
+  auto const filters = m_config.filters.empty()
+                            ? std::string(video ? "null" : "anull")
+                            : m_config.filters;
+  int const error =
+      outputs && inputs
+          ? avfilter_graph_parse_ptr(entry->graph, filters.c_str(), &inputs,
+                                     &outputs, nullptr)
+          : AVERROR(ENOMEM);
+  avfilter_inout_free(&inputs);
+  avfilter_inout_free(&outputs);
+  if (error < 0) {
+    LOG_FATAL_FFMPEG_ERR("Could not parse filters \"" + filters + "\"",
+                         error);
+  }
+
+  {
+    int const error = avfilter_graph_config(entry->graph, nullptr);
+    if (error < 0) {
+      LOG_FATAL_FFMPEG_ERR("Could not configure filters \"" + filters + "\"",
+                           error);
+    }
+  }
+
+  return entry;
+}
+
+int FilterGraphCache::executeSlices(AVFilterContext *ctx,
+                                    avfilter_action_func *func, void *arg,
+                                    int *ret, int jobs) {
+  auto const threadPool =
+      static_cast<utils::ThreadPool *>(ctx->graph->opaque);
+  threadPool->parallelFor(static_cast<size_t>(jobs), [&](size_t job) {
+    int const result = func(ctx, arg, static_cast<int>(job), jobs);
+    if (ret) {
+      ret[job] = result;
+    }
+  });
+  return 0;
+}
+}; // namespace avfilter
+}; // namespace libffmpegxx
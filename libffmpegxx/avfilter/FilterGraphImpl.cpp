@@ -0,0 +1,106 @@
+#include "avfilter/FilterGraphImpl.h"
+
+#include "utils/LoggerApi.h"
+#include "utils/exception.h"
+
+extern "C" {
+#include <libavfilter/buffersink.h>
+#include <libavfilter/buffersrc.h>
+}
+
+namespace libffmpegxx {
+namespace avfilter {
+IFilterGraph *FilterGraphFactory::create(FilterGraphConfig const &config) {
+  return new FilterGraphImpl(std::make_shared<FilterGraphCache>(config));
+}
+
+FilterGraphImpl::FilterGraphImpl(std::shared_ptr<FilterGraphCache> cache)
+    : m_cache(std::move(cache)), m_framePool(8) {}
+
+int FilterGraphImpl::filter(avutil::IAVFrame *frame,
+                            avcodec::FrameSink const &sink) {
+  if (!frame) {
+    flush(sink);
+    return AVERROR_EOF;
+  }
+
+  auto const impl = dynamic_cast<avutil::AVFrameImpl *>(frame);
+  if (!impl) {
+    LOG_FATAL("Error handling frame while filtering");
+  }
+
+  auto const key = FilterGraphCache::getKey(impl);
+  if (!m_graph || key != m_key) {
+    // Frames buffered for the previous parameters come first
+    flush(sink);
+
+    m_graph = m_cache->get(key);
+    m_key = key;
+
+    auto const tb = av_buffersink_get_time_base(m_graph->sink);
+    m_timebase = time::Timebase(tb.num, tb.den);
+  }
+
+  {
+    // The graph takes a new reference, the caller keeps the frame
+    int const error = av_buffersrc_add_frame_flags(
+        m_graph->source, impl->getWrappedFrame(), AV_BUFFERSRC_FLAG_KEEP_REF);
+    if (error < 0) {
+      m_graph->reusable = false;
+      m_graph.reset();
+      LOG_FATAL_FFMPEG_ERR("Could not filter frame", error);
+    }
+  }
+
+  drain(*m_graph, sink);
+  return 0;
+}
+
+time::Timebase FilterGraphImpl::getTimebase() const {
+  if (!m_timebase) {
+    LOG_FATAL("The filter graph output timebase is not known yet");
+  }
+  return *m_timebase;
+}
+
+void FilterGraphImpl::drain(ConfiguredGraph &graph,
+                            avcodec::FrameSink const &sink) {
+  auto const tb = av_buffersink_get_time_base(graph.sink);
+
+  while (true) {
+    auto out = m_framePool.acquire();
+    int const error = av_buffersink_get_frame(graph.sink,
+                                              out->getWrappedFrame());
+    if (error == AVERROR(EAGAIN) || error == AVERROR_EOF) {
+      return;
+    } else if (error < 0) {
+      graph.reusable = false;
+      LOG_FATAL_FFMPEG_ERR("Could not get filtered frame", error);
+    }
+
+    out->setTimebase(time::Timebase(tb.num, tb.den));
+    sink(out);
+  }
+}
+
+void FilterGraphImpl::flush(avcodec::FrameSink const &sink) {
+  // Released even if the sink throws, returning to the cache if reusable
+  auto const graph = std::move(m_graph);
+  if (!graph) {
+    return;
+  }
+
+  if (!m_cache->getConfig().stateless) {
+    // libavfilter graphs cannot restart once ended
+    graph->reusable = false;
+
+    int const error = av_buffersrc_add_frame_flags(graph->source, nullptr, 0);
+    if (error < 0) {
+      LOG_FATAL_FFMPEG_ERR("Could not flush filter graph", error);
+    }
+  }
+
+  drain(*graph, sink);
+}
+}; // namespace avfilter
+}; // namespace libffmpegxx
@@ -0,0 +1,25 @@
+#include "avfilter/FilterGraphPoolImpl.h"
+
+#include "avfilter/FilterGraphImpl.h"
+
+namespace libffmpegxx {
+namespace avfilter {
+IFilterGraphPool *
+FilterGraphPoolFactory::create(FilterGraphConfig const &config) {
+  return new FilterGraphPoolImpl(config);
+}
+
+FilterGraphPoolImpl::FilterGraphPoolImpl(FilterGraphConfig const &config)
+    : m_cache(std::make_shared<FilterGraphCache>(config)) {}
+
+std::shared_ptr<IFilterGraph> FilterGraphPoolImpl::acquire() {
+  return std::make_shared<FilterGraphImpl>(m_cache);
+}
+
+void FilterGraphPoolImpl::clear() { m_cache->clear(); }
+
+size_t FilterGraphPoolImpl::getIdleCount() const {
+  return m_cache->getIdleCount();
+}
+}; // namespace avfilter
+}; // namespace libffmpegxx
@@ -0,0 +1,354 @@
+#include "avformat/AbrLadderImpl.h"
+
+#include "public/avformat/IDemuxer.h"
+
+#include "avcodec/AVPacketImpl.h"
+#include "avcodec/DecoderImpl.h"
+#include "avcodec/EncoderImpl.h"
+#include "avformat/MuxerImpl.h"
+#include "avutil/AVFrameImpl.h"
+#include "swscale/ScalerImpl.h"
+#include "utils/LoggerApi.h"
+
+#include <algorithm>
+#include <cmath>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace libffmpegxx {
+namespace avcodec {
+extern void fitVideoSize(AVCodecParameters const *source, int &width,
+                         int &height);
+extern AVPixelFormat chooseEncoderPixelFormat(AVCodec const *codec,
+                                              AVPixelFormat requested,
+                                              AVPixelFormat source);
+extern avformat::StreamInfo
+makeEncodedStreamInfo(avformat::StreamInfo const &source,
+                      AVCodec const *codec, int width, int height,
+                      AVPixelFormat format);
+}; // namespace avcodec
+
+namespace avformat {
+IAbrLadder *AbrLadderFactory::create(IDemuxer *demuxer, int streamIdx,
+                                     AbrLadderConfig const &config) {
+  return new AbrLadderImpl(demuxer, streamIdx, config);
+}
+
+AbrLadderImpl::AbrLadderImpl(IDemuxer *demuxer, int streamIdx,
+                             AbrLadderConfig const &config)
+    : m_demuxer(demuxer), m_streamIdx(streamIdx),
+      m_keyframeInterval(config.keyframeInterval),
+      m_queueCapacity(std::max<size_t>(config.queueCapacity, 1)),
+      m_scaler(std::make_unique<swscale::ScalerImpl>(config.scaling)) {
+  if (!demuxer) {
+    LOG_FATAL("Demuxer cannot be null for an ABR ladder");
+  }
+
+  if (config.renditions.empty()) {
+    LOG_FATAL("No renditions given to the ABR ladder");
+  }
+
+  auto const mediaInfo = demuxer->getMediaInfo();
+  auto const stream = mediaInfo.streamsInfo.find(streamIdx);
+  if (stream == mediaInfo.streamsInfo.end() ||
+      stream->second.type != StreamType::VIDEO) {
+    LOG_FATAL("Stream " + std::to_string(streamIdx) + " of " + mediaInfo.uri +
+              " is not a video stream");
+  }
+  m_streamInfo = stream->second;
+
+  if (m_keyframeInterval <= 0) {
+    // Two seconds worth of frames
+    auto const &fr =
+        std::get<VideoInfo>(m_streamInfo.properties).averageFramerate;
+    m_keyframeInterval = 50;
+    if (fr.num() > 0 && fr.den() > 0) {
+      auto const frames = std::lround(2. * fr.num() / fr.den());
+      m_keyframeInterval = std::max(1, static_cast<int>(frames));
+    }
+  }
+
+  m_decoder = std::make_unique<avcodec::DecoderImpl>(
+      m_streamInfo, config.decoderOptions, config.decoderThreading);
+
+  for (auto &&rendition : config.renditions) {
+    addOutput(rendition);
+  }
+}
+
+void AbrLadderImpl::addOutput(Rendition const &rendition) {
+  auto const codec = avcodec_find_encoder(rendition.codecId);
+  if (!codec) {
+    LOG_FATAL("Could not find an encoder for codec id " +
+              std::to_string(rendition.codecId) + " for " + rendition.uri);
+  }
+
+  auto const srcPar = *m_streamInfo.codecPar;
+  int width = rendition.width;
+  int height = rendition.height;
+  avcodec::fitVideoSize(srcPar, width, height);
+
+  auto const srcFormat = static_cast<AVPixelFormat>(srcPar->format);
+  auto const format = avcodec::chooseEncoderPixelFormat(
+      codec, rendition.pixelFormat, srcFormat);
+
+  auto output = std::make_unique<Output>();
+
+  // Renditions of the same size share the scaled frames
+  if (width != srcPar->width || height != srcPar->height ||
+      format != srcFormat) {
+    auto const size = std::find_if(
+        m_sizes.begin(), m_sizes.end(), [&](ScaledSize const &s) {
+          return s.width == width && s.height == height && s.format == format;
+        });
+    output->sizeIdx = static_cast<int>(size - m_sizes.begin());
+    if (size == m_sizes.end()) {
+      m_sizes.push_back({width, height, format});
+    }
+  }
+
+  auto const encodedInfo = avcodec::makeEncodedStreamInfo(
+      m_streamInfo, codec, width, height, format);
+
+  auto settings = rendition.settings;
+  if (settings.gopSize < 0) {
+    settings.gopSize = m_keyframeInterval;
+  }
+
+  auto const outputFormat = av_guess_format(
+      rendition.format.empty() ? nullptr : rendition.format.c_str(),
+      rendition.uri.c_str(), nullptr);
+  if (outputFormat && (outputFormat->flags & AVFMT_GLOBALHEADER)) {
+    settings.globalHeader = true;
+  }
+
+  // Keyframes only where forced so they are aligned across the ladder
+  auto options = rendition.options;
+  options.insert({"sc_threshold", 0});
+  options.insert({"forced-idr", 1});
+
+  output->encoder =
+      std::make_unique<avcodec::EncoderImpl>(encodedInfo, settings, options);
+
+  MediaInfo outputInfo;
+  outputInfo.uri = rendition.uri;
+  outputInfo.format = rendition.format;
+  outputInfo.duration = m_demuxer->getMediaInfo().duration;
+  outputInfo.startTime = time::Seconds{0.};
+  outputInfo.streamsInfo.insert({0, output->encoder->getStreamInfo()});
+  output->muxer = std::make_unique<MuxerImpl>(outputInfo);
+
+  LOG_INFO("Rendition " + rendition.uri + ": " + std::to_string(width) + "x" +
+           std::to_string(height) + " " + codec->name);
+
+  m_outputs.push_back(std::move(output));
+}
+
+AbrLadderImpl::~AbrLadderImpl() {
+  if (m_thread.joinable()) {
+    stop();
+    wait();
+  }
+}
+
+void AbrLadderImpl::start(utils::AVOptions const &options) {
+  if (m_thread.joinable()) {
+    LOG_FATAL("ABR ladder of " + m_demuxer->getMediaInfo().uri +
+              " is already running");
+  }
+
+  for (auto &&output : m_outputs) {
+    output->muxer->open(options);
+    output->queue = std::make_unique<FrameQueue>(m_queueCapacity);
+    output->result = 0;
+    output->frames = 0;
+    output->packets = 0;
+    output->bytes = 0;
+  }
+
+  m_decodedFrames = 0;
+  m_result = 0;
+  m_stopRequested = false;
+  m_stopwatch.start();
+
+  for (auto &&output : m_outputs) {
+    output->thread =
+        std::thread(&AbrLadderImpl::encode, this, std::ref(*output));
+  }
+  m_thread = std::thread(&AbrLadderImpl::run, this);
+}
+
+void AbrLadderImpl::stop() {
+  m_stopRequested = true;
+  closeQueues();
+}
+
+int AbrLadderImpl::wait() {
+  if (!m_thread.joinable()) {
+    return m_result;
+  }
+
+  m_thread.join();
+  for (auto &&output : m_outputs) {
+    output->muxer->close();
+  }
+
+  auto const stats = getStatistics();
+  LOG_INFO("Encoded " + std::to_string(stats.decodedFrames) + " frames into " +
+           std::to_string(m_outputs.size()) + " renditions in " +
+           std::to_string(stats.elapsed.count()) + " s");
+
+  return m_result;
+}
+
+bool AbrLadderImpl::isRunning() const { return m_stopwatch.isRunning(); }
+
+AbrLadderStatistics AbrLadderImpl::getStatistics() const {
+  AbrLadderStatistics stats;
+  stats.decodedFrames = m_decodedFrames;
+  stats.elapsed = m_stopwatch.getElapsed();
+
+  for (auto &&output : m_outputs) {
+    RenditionStatistics renditionStats;
+    renditionStats.frames = output->frames;
+    renditionStats.packets = output->packets;
+    renditionStats.bytes = output->bytes;
+    stats.renditions.push_back(renditionStats);
+  }
+
+  return stats;
+}
+
+void AbrLadderImpl::run() {
+  avcodec::AVPacketImpl packet;
+  int error = 0;
+
+  try {
+    while (!m_stopRequested && (error = m_demuxer->read(&packet)) >= 0) {
+      if (packet.getStreamIndex() != m_streamIdx) {
+        continue;
+      }
+
+      error = decode(&packet);
+      if (error == AVERROR_INVALIDDATA) {
+        LOG_WARN("Skipping corrupted packet of " +
+                 m_demuxer->getMediaInfo().uri);
+        error = 0;
+      } else if (error < 0) {
+        break;
+      }
+    }
+
+    if (error == AVERROR_EOF && !m_stopRequested) {
+      error = decode(nullptr);
+    }
+  } catch (std::exception const &e) {
+    LOG_ERROR("ABR ladder of " + m_demuxer->getMediaInfo().uri +
+              " failed: " + e.what());
+    error = AVERROR_UNKNOWN;
+  }
+
+  if (error == AVERROR_EOF) {
+    error = 0;
+  }
+  if (error < 0) {
+    m_stopRequested = true;
+  }
+
+  // Lets the encoding threads flush and finish
+  closeQueues();
+  for (auto &&output : m_outputs) {
+    output->thread.join();
+    if (error >= 0 && output->result < 0) {
+      error = output->result;
+    }
+  }
+
+  m_result = error;
+  m_stopwatch.stop();
+}
+
+int AbrLadderImpl::decode(avcodec::IAVPacket *packet) {
+  std::vector<std::shared_ptr<avutil::AVFrameImpl>> scaled(m_sizes.size());
+
+  return m_decoder->decode(
+      packet, [this, &scaled](std::shared_ptr<avutil::IAVFrame> const &frame) {
+        auto const decoded = std::dynamic_pointer_cast<avutil::AVFrameImpl>(
+            frame);
+        if (!decoded) {
+          LOG_FATAL("Error handling decoded frame");
+        }
+
+        // The decoder picture types must not leak into the encoders
+        auto const avframe = decoded->getWrappedFrame();
+        avframe->pts = avframe->best_effort_timestamp;
+        avframe->pict_type = m_decodedFrames % m_keyframeInterval == 0
+                                 ? AV_PICTURE_TYPE_I
+                                 : AV_PICTURE_TYPE_NONE;
+        ++m_decodedFrames;
+
+        // Each size is scaled once, whatever the amount of its renditions
+        for (size_t i = 0; i < m_sizes.size(); ++i) {
+          auto const &size = m_sizes[i];
+          scaled[i] = m_scaler->scaleFrame(decoded.get(), size.width,
+                                           size.height, size.format);
+        }
+
+        for (auto &&output : m_outputs) {
+          output->queue->push(output->sizeIdx < 0 ? decoded
+                                                  : scaled[output->sizeIdx]);
+        }
+
+        std::fill(scaled.begin(), scaled.end(), nullptr);
+      });
+}
+
+void AbrLadderImpl::encode(Output &output) {
+  auto const sink = [&output](std::shared_ptr<avcodec::IAVPacket> const &p) {
+    p->setStreamIndex(0);
+    output.bytes += p->getSize();
+    ++output.packets;
+    output.muxer->write(p.get());
+  };
+
+  std::shared_ptr<avutil::AVFrameImpl> frame;
+  int error = 0;
+
+  try {
+    while (!m_stopRequested && output.queue->pop(frame)) {
+      error = output.encoder->encode(frame.get(), sink);
+      frame.reset();
+      if (error < 0) {
+        break;
+      }
+      ++output.frames;
+    }
+
+    if (error >= 0 && !m_stopRequested) {
+      error = output.encoder->encode(nullptr, sink);
+    }
+  } catch (std::exception const &e) {
+    LOG_ERROR("Encoding " + output.muxer->getMediaInfo().uri +
+              " failed: " + e.what());
+    error = AVERROR_UNKNOWN;
+  }
+
+  output.result = error == AVERROR_EOF ? 0 : error;
+
+  if (output.result < 0) {
+    // A failed rendition stops the whole ladder
+    stop();
+  }
+}
+
+void AbrLadderImpl::closeQueues() {
+  for (auto &&output : m_outputs) {
+    if (output->queue) {
+      output->queue->close();
+    }
+  }
+}
+}; // namespace avformat
+}; // namespace libffmpegxx
@@ -0,0 +1,282 @@
+#include "avformat/CompositorImpl.h"
+
+#include "public/avformat/IDemuxer.h"
+
+#include "avcodec/AVPacketImpl.h"
+#include "avformat/MuxerImpl.h"
+#include "utils/LoggerApi.h"
+
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/mathematics.h>
+}
+
+namespace libffmpegxx {
+namespace avformat {
+namespace {
+/**
+ * @return true if the packet a has to be written before the packet b. Packets
+ * are ordered by DTS, or PTS if DTS is unknown. Packets without timestamps go
+ * first.
+ */
+bool isBefore(avcodec::AVPacketImpl const *a, avcodec::AVPacketImpl const *b) {
+  auto const avpacketA = a->getWrappedPacket();
+  auto const avpacketB = b->getWrappedPacket();
+  auto const tsA =
+      avpacketA->dts != AV_NOPTS_VALUE ? avpacketA->dts : avpacketA->pts;
+  auto const tsB =
+      avpacketB->dts != AV_NOPTS_VALUE ? avpacketB->dts : avpacketB->pts;
+
+  if (tsA == AV_NOPTS_VALUE) {
+    return true;
+  }
+  if (tsB == AV_NOPTS_VALUE) {
+    return false;
+  }
+
+  auto const tbA = a->getTimebase();
+  auto const tbB = b->getTimebase();
+  return av_compare_ts(tsA, {tbA.num(), tbA.den()}, tsB,
+                       {tbB.num(), tbB.den()}) < 0;
+}
+} // namespace
+
+ICompositor *CompositorFactory::create(std::vector<StreamSource> const &sources,
+                                       std::string const &uri,
+                                       std::string const &format,
+                                       size_t queueCapacity) {
+  return new CompositorImpl(sources, uri, format, queueCapacity);
+}
+
+CompositorImpl::CompositorImpl(std::vector<StreamSource> const &sources,
+                               std::string const &uri,
+                               std::string const &format,
+                               size_t queueCapacity)
+    : m_queueCapacity(std::max<size_t>(queueCapacity, 1)) {
+  if (sources.empty()) {
+    LOG_FATAL("No stream sources given to compose " + uri);
+  }
+
+  MediaInfo outputInfo;
+  outputInfo.uri = uri;
+  outputInfo.format = format;
+  outputInfo.duration = time::Seconds{0.};
+  outputInfo.startTime = time::Seconds{0.};
+
+  for (auto &&source : sources) {
+    if (!source.demuxer) {
+      LOG_FATAL("Demuxer cannot be null when composing " + uri);
+    }
+
+    auto const inputInfo = source.demuxer->getMediaInfo();
+    auto const stream = inputInfo.streamsInfo.find(source.streamIdx);
+    if (stream == inputInfo.streamsInfo.end()) {
+      LOG_FATAL("Stream " + std::to_string(source.streamIdx) +
+                " not found in " + inputInfo.uri);
+    }
+
+    // One reading thread per demuxer, whatever the amount of its streams used
+    auto input = std::find_if(
+        m_inputs.begin(), m_inputs.end(),
+        [&source](auto const &i) { return i->demuxer == source.demuxer; });
+    if (input == m_inputs.end()) {
+      m_inputs.push_back(std::make_unique<Input>());
+      m_inputs.back()->demuxer = source.demuxer;
+      input = std::prev(m_inputs.end());
+    }
+
+    int const outputIdx = static_cast<int>(outputInfo.streamsInfo.size());
+    if (!(*input)->outputIndexes.insert({source.streamIdx, outputIdx}).second) {
+      LOG_FATAL("Stream " + std::to_string(source.streamIdx) + " of " +
+                inputInfo.uri + " used twice when composing " + uri);
+    }
+
+    StreamInfo info = stream->second;
+    info.index = outputIdx;
+    for (auto &&[key, value] : source.metadata) {
+      info.metadata[key] = value;
+    }
+    outputInfo.streamsInfo.insert({outputIdx, info});
+
+    outputInfo.duration = std::max(outputInfo.duration, inputInfo.duration);
+  }
+
+  m_muxer = std::make_unique<MuxerImpl>(outputInfo);
+}
+
+CompositorImpl::~CompositorImpl() {
+  if (m_thread.joinable()) {
+    stop();
+    wait();
+  }
+}
+
+void CompositorImpl::start(utils::AVOptions const &options) {
+  if (m_thread.joinable()) {
+    LOG_FATAL("Compositor to " + m_muxer->getMediaInfo().uri +
+              " is already running");
+  }
+
+  m_muxer->open(options);
+
+  for (auto &&input : m_inputs) {
+    input->filled = std::make_unique<PacketQueue>(m_queueCapacity);
+    input->recycled = std::make_unique<PacketQueue>(m_queueCapacity);
+    input->packets.resize(m_queueCapacity);
+    for (auto &&packet : input->packets) {
+      if (!packet) {
+        packet = std::make_unique<avcodec::AVPacketImpl>();
+      }
+      packet->clear();
+      input->recycled->tryPush(packet.get());
+    }
+    input->head = nullptr;
+    input->result = 0;
+  }
+
+  m_packets = 0;
+  m_bytes = 0;
+  m_result = 0;
+  m_stopRequested = false;
+  m_stopwatch.start();
+
+  for (auto &&input : m_inputs) {
+    input->thread = std::thread(&CompositorImpl::readInput, this,
+                                std::ref(*input));
+  }
+  m_thread = std::thread(&CompositorImpl::run, this);
+}
+
+void CompositorImpl::stop() {
+  m_stopRequested = true;
+  closeQueues();
+}
+
+int CompositorImpl::wait() {
+  if (!m_thread.joinable()) {
+    return m_result;
+  }
+
+  m_thread.join();
+  m_muxer->close();
+
+  auto const stats = getStatistics();
+  LOG_INFO("Composed " + std::to_string(stats.packets) + " packets (" +
+           std::to_string(stats.bytes) + " bytes) to " +
+           m_muxer->getMediaInfo().uri + " at " +
+           std::to_string(stats.throughput) + " MB/s");
+
+  return m_result;
+}
+
+bool CompositorImpl::isRunning() const { return m_stopwatch.isRunning(); }
+
+RemuxStatistics CompositorImpl::getStatistics() const {
+  RemuxStatistics stats;
+  stats.packets = m_packets;
+  stats.bytes = m_bytes;
+  stats.elapsed = m_stopwatch.getElapsed();
+  stats.throughput = m_stopwatch.getThroughput(stats.bytes);
+
+  return stats;
+}
+
+MediaInfo CompositorImpl::getMediaInfo() const {
+  return m_muxer->getMediaInfo();
+}
+
+void CompositorImpl::readInput(Input &input) {
+  avcodec::AVPacketImpl *packet{nullptr};
+  int error = 0;
+
+  try {
+    while (error >= 0 && input.recycled->pop(packet)) {
+      while ((error = input.demuxer->read(packet)) >= 0) {
+        auto const outputIdx =
+            input.outputIndexes.find(packet->getStreamIndex());
+        if (outputIdx != input.outputIndexes.end()) {
+          packet->setStreamIndex(outputIdx->second);
+          break;
+        }
+      }
+
+      if (error >= 0 && !input.filled->push(packet)) {
+        break;
+      }
+    }
+  } catch (std::exception const &e) {
+    LOG_ERROR("Reading " + input.demuxer->getMediaInfo().uri +
+              " failed: " + e.what());
+    error = AVERROR_UNKNOWN;
+  }
+
+  input.result = error == AVERROR_EOF ? 0 : error;
+
+  // Lets the muxing thread know this input is over
+  input.filled->close();
+}
+
+void CompositorImpl::run() {
+  int error = 0;
+
+  try {
+    for (auto &&input : m_inputs) {
+      if (!input->filled->pop(input->head)) {
+        input->head = nullptr;
+      }
+    }
+
+    while (!m_stopRequested) {
+      // Inputs are few, a linear scan is cheaper than keeping a heap
+      Input *next{nullptr};
+      for (auto &&input : m_inputs) {
+        if (input->head && (!next || isBefore(input->head, next->head))) {
+          next = input.get();
+        }
+      }
+
+      if (!next) {
+        break;
+      }
+
+      auto const packet = next->head;
+      m_bytes += packet->getSize();
+      ++m_packets;
+
+      m_muxer->write(packet);
+
+      packet->clear();
+      next->recycled->push(packet);
+      if (!next->filled->pop(next->head)) {
+        next->head = nullptr;
+      }
+    }
+  } catch (std::exception const &e) {
+    LOG_ERROR("Composing " + m_muxer->getMediaInfo().uri +
+              " failed: " + e.what());
+    error = AVERROR_UNKNOWN;
+  }
+
+  closeQueues();
+  for (auto &&input : m_inputs) {
+    input->thread.join();
+    if (error >= 0 && input->result < 0) {
+      error = input->result;
+    }
+  }
+
+  m_result = error;
+  m_stopwatch.stop();
+}
+
+void CompositorImpl::closeQueues() {
+  for (auto &&input : m_inputs) {
+    if (input->filled) {
+      input->filled->close();
+      input->recycled->close();
+    }
+  }
+}
+}; // namespace avformat
+}; // namespace libffmpegxx
@@ -21,14 +21,17 @@ IDemuxer *DemuxerFactory::create(std::string const &uri) {
 }
 
 namespace {
-std::string buildDebugInfo(avcodec::IAVPacket *packet) {
+std::string buildDebugInfo(avcodec::AVPacketImpl *packet) {
+  // Raw timestamps: time::Timestamp rejects the negative ones
+  auto const avpacket = packet->getWrappedPacket();
+
   std::stringstream ss;
   ss << "Packet data:";
   ss << "\n\tType: " << static_cast<int>(packet->getContentType());
   ss << "\n\tSize: " << packet->getSize();
   ss << "\n\tStream idx: " << packet->getStreamIndex();
-  ss << "\n\tPTS: " << packet->getPts().value();
-  ss << "\n\tDTS: " << packet->getDts().value();
+  ss << "\n\tPTS: " << avpacket->pts;
+  ss << "\n\tDTS: " << avpacket->dts;
   ss << "\n\tTimebase: " << packet->getTimebase().toString();
   ss << "\n\tDuration: " << packet->getDuration();
 
@@ -76,6 +79,13 @@ MediaInfo DemuxerImpl::open(const utils::AVOptions &options) {
 
   LOG_INFO("Stream info found for " + m_uri)
 
+  // Stream types are resolved once instead of on every read packet
+  m_streamTypes.clear();
+  for (unsigned int i = 0; i < m_formatContext->nb_streams; ++i) {
+    m_streamTypes.push_back(getStreamType(static_cast<int>(i)));
+  }
+  m_discard.assign(m_formatContext->nb_streams, AVDISCARD_DEFAULT);
+
   // Dump media info to the log
   av_dump_format(m_formatContext, 0, m_formatContext->url, false);
 
@@ -112,7 +122,11 @@ int DemuxerImpl::read(avcodec::IAVPacket *packet) {
 
   LOG_DEBUG("Reading a packet from " + m_uri);
 
-  int const error = av_read_frame(m_formatContext, avpacket);
+  int error = 0;
+  while ((error = av_read_frame(m_formatContext, avpacket)) >= 0 &&
+         isDiscarded(avpacket)) {
+    av_packet_unref(avpacket);
+  }
 
   if (error < 0) {
     auto const msgError = "Error while reading " + m_uri + ": " +
@@ -121,15 +135,20 @@ int DemuxerImpl::read(avcodec::IAVPacket *packet) {
     return error;
   }
 
-  auto const tb = m_formatContext->streams[avpacket->stream_index]->time_base;
-  auto const streamTb = time::Timebase(tb.num, tb.den);
-  readingPacket->setContentType(getStreamType(avpacket->stream_index));
-  readingPacket->setTimebase(streamTb);
-  readingPacket->setTimestamp(time::Timestamp(avpacket->pts, streamTb),
-                              time::Timestamp(avpacket->dts, streamTb));
-
-  LOG_DEBUG("Packet successfully read from " + m_uri + ". " +
-            buildDebugInfo(readingPacket));
+  // Timestamps are already in stream timebase units. Setting them through
+  // time::Timestamp would reject the negative DTS some inputs start with.
+  auto const streamIdx = avpacket->stream_index;
+  auto const tb = m_formatContext->streams[streamIdx]->time_base;
+  readingPacket->setContentType(
+      streamIdx < static_cast<int>(m_streamTypes.size())
+          ? m_streamTypes[streamIdx]
+          : getStreamType(streamIdx));
+  readingPacket->setTimebase(time::Timebase(tb.num, tb.den));
+
+  if (LOG_DEBUG_ENABLED) {
+    LOG_DEBUG("Packet successfully read from " + m_uri + ". " +
+              buildDebugInfo(readingPacket));
+  }
 
   return error;
 }
@@ -138,6 +157,61 @@ MediaInfo DemuxerImpl::getMediaInfo() const {
   return libffmpegxx::avformat::MediaInfoFactory::build(m_formatContext);
 }
 
+void DemuxerImpl::setDiscard(int streamIdx, AVDiscard discard) {
+  std::lock_guard<std::mutex> l(m_ioMutex);
+
+  if (!m_formatContext) {
+    LOG_FATAL("Demuxer for " + m_uri + " not opened yet");
+  }
+
+  if (streamIdx < 0 || streamIdx >= static_cast<int>(m_discard.size())) {
+    LOG_FATAL("Stream " + std::to_string(streamIdx) + " not found in " +
+              m_uri);
+  }
+
+  m_formatContext->streams[streamIdx]->discard = discard;
+  m_discard[streamIdx] = discard;
+}
+
+int DemuxerImpl::seek(int streamIdx, time::Timestamp const &ts) {
+  std::lock_guard<std::mutex> l(m_ioMutex);
+
+  if (!m_formatContext) {
+    LOG_FATAL("Demuxer for " + m_uri + " not opened yet");
+  }
+
+  if (streamIdx < 0 ||
+      streamIdx >= static_cast<int>(m_formatContext->nb_streams)) {
+    LOG_FATAL("Stream " + std::to_string(streamIdx) + " not found in " +
+              m_uri);
+  }
+
+  auto const tb = m_formatContext->streams[streamIdx]->time_base;
+  auto const target = ts.toTimebase(time::Timebase(tb.num, tb.den)).value();
+
+  int const error =
+      av_seek_frame(m_formatContext, streamIdx, target, AVSEEK_FLAG_BACKWARD);
+  if (error < 0) {
+    LOG_ERROR("Error while seeking " + m_uri + " to " +
+              std::to_string(target) + ": " +
+              utils::Logger::avErrorToStr(error));
+  }
+
+  return error;
+}
+
+bool DemuxerImpl::isDiscarded(AVPacket const *packet) const {
+  // Not every demuxer honours the stream discard level by itself
+  auto const streamIdx = packet->stream_index;
+  if (streamIdx >= static_cast<int>(m_discard.size())) {
+    return false;
+  }
+
+  auto const discard = m_discard[streamIdx];
+  return discard >= AVDISCARD_ALL ||
+         (discard >= AVDISCARD_NONKEY && !(packet->flags & AV_PKT_FLAG_KEY));
+}
+
 StreamType DemuxerImpl::getStreamType(int streamIdx) const {
   static std::vector<AVMediaType> const EXPECTED_TYPES = {
       AVMEDIA_TYPE_VIDEO, AVMEDIA_TYPE_AUDIO, AVMEDIA_TYPE_DATA,
@@ -0,0 +1,55 @@
+#include "avformat/KeyframeIndex.h"
+
+#include "avcodec/AVPacketImpl.h"
+#include "avformat/DemuxerImpl.h"
+#include "utils/LoggerApi.h"
+
+namespace libffmpegxx {
+namespace avformat {
+int64_t KeyframePosition::getDecodeOrderTs() const {
+  return dts != AV_NOPTS_VALUE ? dts : pts;
+}
+
+KeyframeIndex::KeyframeIndex(std::string const &uri, int streamIdx,
+                             utils::AVOptions const &options) {
+  DemuxerImpl demuxer(uri);
+  auto const info = demuxer.open(options);
+
+  auto const stream = info.streamsInfo.find(streamIdx);
+  if (stream == info.streamsInfo.end()) {
+    LOG_FATAL("Stream " + std::to_string(streamIdx) + " not found in " + uri);
+  }
+  m_tb = stream->second.timebase;
+
+  for (auto &&[idx, _] : info.streamsInfo) {
+    demuxer.setDiscard(idx, idx == streamIdx ? AVDISCARD_NONKEY
+                                             : AVDISCARD_ALL);
+  }
+
+  avcodec::AVPacketImpl packet;
+  int error = 0;
+  while ((error = demuxer.read(&packet)) >= 0) {
+    if (packet.getStreamIndex() != streamIdx) {
+      continue;
+    }
+
+    auto const avpacket = packet.getWrappedPacket();
+    m_keyframes.push_back({avpacket->pts, avpacket->dts});
+  }
+
+  if (error != AVERROR_EOF) {
+    LOG_WARN("Keyframe scan of " + uri + " ended early: " +
+             utils::Logger::avErrorToStr(error));
+  }
+
+  LOG_DEBUG(std::to_string(m_keyframes.size()) + " keyframes found in " +
+            uri);
+}
+
+std::vector<KeyframePosition> const &KeyframeIndex::getKeyframes() const {
+  return m_keyframes;
+}
+
+time::Timebase const &KeyframeIndex::getTimebase() const { return m_tb; }
+}; // namespace avformat
+}; // namespace libffmpegxx
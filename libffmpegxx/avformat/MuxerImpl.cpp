@@ -6,6 +6,9 @@
 #include "avcodec/AVPacketImpl.h"
 #include "utils/exception.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace libffmpegxx {
 namespace utils {
 extern AVDictionary *toAVDictionary(AVOptions const &options);
@@ -16,26 +19,95 @@ extern void addStreams(AVFormatContext *ctx,
                        std::map<int, StreamInfo> const &streamsInfo);
 
 namespace {
-std::string buildDebugInfo(avcodec::IAVPacket *packet) {
+std::string buildDebugInfo(avcodec::AVPacketImpl *packet) {
+  // Raw timestamps: time::Timestamp rejects the negative ones
+  auto const avpacket = packet->getWrappedPacket();
+
   std::stringstream ss;
   ss << "Packet data:";
   ss << "\n\tType: " << static_cast<int>(packet->getContentType());
   ss << "\n\tSize: " << packet->getSize();
   ss << "\n\tStream idx: " << packet->getStreamIndex();
-  ss << "\n\tPTS: " << packet->getPts().value();
-  ss << "\n\tDTS: " << packet->getDts().value();
+  ss << "\n\tPTS: " << avpacket->pts;
+  ss << "\n\tDTS: " << avpacket->dts;
   ss << "\n\tTimebase: " << packet->getTimebase().toString();
   ss << "\n\tDuration: " << packet->getDuration();
 
   return ss.str();
 }
+
+bool isFragmentableFormat(AVOutputFormat const *format) {
+  static std::vector<std::string> const FRAGMENTABLE_FORMATS = {"mp4", "mov",
+                                                                "ismv", "ipod"};
+  for (auto &&name : FRAGMENTABLE_FORMATS) {
+    if (name == format->name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Size of the I/O buffer handed to output sinks on each flush.
+ */
+constexpr int SINK_BUFFER_SIZE = 32 * 1024;
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+int writeToSink(void *opaque, uint8_t const *buf, int size) {
+#else
+int writeToSink(void *opaque, uint8_t *buf, int size) {
+#endif
+  return static_cast<IOutputSink *>(opaque)->write(buf, size);
+}
+
+int64_t seekSink(void *opaque, int64_t offset, int whence) {
+  return static_cast<IOutputSink *>(opaque)->seek(offset, whence);
+}
+
+double packetTime(AVPacket const *packet, AVRational tb) {
+  auto const ts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+  if (ts == AV_NOPTS_VALUE) {
+    return -1.;
+  }
+  return ts * av_q2d(tb);
+}
 } // namespace
 
 IMuxer *MuxerFactory::create(const MediaInfo &mediaInfo) {
   return new MuxerImpl(mediaInfo);
 }
 
-MuxerImpl::MuxerImpl(MediaInfo const &mediaInfo) : m_mediaInfo(mediaInfo) {}
+IMuxer *MuxerFactory::create(MediaInfo const &mediaInfo,
+                             FragmentationConfig const &fragmentation) {
+  return new MuxerImpl(mediaInfo, fragmentation);
+}
+
+IMuxer *MuxerFactory::create(MediaInfo const &mediaInfo, IOutputSink *sink) {
+  if (!sink) {
+    LOG_FATAL("Invalid output sink for " + mediaInfo.uri);
+  }
+  return new MuxerImpl(mediaInfo, sink);
+}
+
+IMuxer *MuxerFactory::create(MediaInfo const &mediaInfo, IOutputSink *sink,
+                             FragmentationConfig const &fragmentation) {
+  if (!sink) {
+    LOG_FATAL("Invalid output sink for " + mediaInfo.uri);
+  }
+  return new MuxerImpl(mediaInfo, fragmentation, sink);
+}
+
+MuxerImpl::MuxerImpl(MediaInfo const &mediaInfo, IOutputSink *sink)
+    : m_mediaInfo(mediaInfo), m_sink(sink) {}
+
+MuxerImpl::MuxerImpl(MediaInfo const &mediaInfo,
+                     FragmentationConfig const &fragmentation,
+                     IOutputSink *sink)
+    : m_mediaInfo(mediaInfo), m_sink(sink), m_fragmentation(fragmentation) {
+  if (m_fragmentation->fragmentDuration.count() < 0) {
+    LOG_FATAL("Fragment duration cannot be negative");
+  }
+}
 
 MuxerImpl::~MuxerImpl() { this->MuxerImpl::close(); }
 
@@ -48,9 +120,11 @@ void MuxerImpl::open(utils::AVOptions const &options) {
 
   std::lock_guard<std::mutex> l(m_ioMutex);
 
-  int error = avformat_alloc_output_context2(&m_formatContext, nullptr,
-                                             m_mediaInfo.format.c_str(),
-                                             m_mediaInfo.uri.c_str());
+  // With an output sink the URI is not an output, it only names the muxer
+  int error = avformat_alloc_output_context2(
+      &m_formatContext, nullptr,
+      m_mediaInfo.format.empty() ? nullptr : m_mediaInfo.format.c_str(),
+      m_sink ? nullptr : m_mediaInfo.uri.c_str());
   if (!m_formatContext) {
     LOG_FATAL_FFMPEG_ERR(
         "Error while allocating output context for " + m_mediaInfo.uri, error);
@@ -67,24 +141,59 @@ void MuxerImpl::open(utils::AVOptions const &options) {
 
   auto opts = utils::toAVDictionary(options);
 
-  error = avio_open2(&m_formatContext->pb, m_mediaInfo.uri.c_str(),
-                     AVIO_FLAG_WRITE, nullptr, &opts);
-  if (error < 0) {
-    LOG_FATAL_FFMPEG_ERR("Error while opening output for " + m_mediaInfo.uri,
-                         error);
+  if (m_fragmentation) {
+    setupFragmentation(&opts);
+  }
+
+  if (m_sink) {
+    try {
+      openSink();
+    } catch (std::runtime_error const &) {
+      av_dict_free(&opts);
+      throw;
+    }
+  } else {
+    error = avio_open2(&m_formatContext->pb, m_mediaInfo.uri.c_str(),
+                       AVIO_FLAG_WRITE, nullptr, &opts);
+    if (error < 0) {
+      av_dict_free(&opts);
+      LOG_FATAL_FFMPEG_ERR("Error while opening output for " + m_mediaInfo.uri,
+                           error);
+    }
   }
 
   LOG_DEBUG("Muxer opened successfully for " + m_mediaInfo.uri);
 
   av_dump_format(m_formatContext, 0, m_mediaInfo.uri.c_str(), true);
 
-  error = avformat_write_header(m_formatContext, NULL);
+  // Options not consumed by the I/O layer are muxer options (i.e. movflags)
+  error = avformat_write_header(m_formatContext, &opts);
+  av_dict_free(&opts);
   if (error < 0) {
     LOG_FATAL_FFMPEG_ERR("Error while writing header for " + m_mediaInfo.uri,
                          error);
   }
 
   LOG_DEBUG("Header written output for " + m_mediaInfo.uri);
+
+  // The muxer may have changed the stream timebases while writing the header,
+  // so rescaling plans are computed now
+  m_rescalers.clear();
+  for (auto &&[streamIdx, info] : m_mediaInfo.streamsInfo) {
+    auto const tb = m_formatContext->streams[m_rescalers.size()]->time_base;
+    m_rescalers.emplace_back(info.timebase, time::Timebase(tb.num, tb.den));
+  }
+
+  if (m_fragmentation && m_fragmentation->emptyMoov) {
+    // The initialization segment is complete once the header is written
+    avio_flush(m_formatContext->pb);
+    auto const end = avio_tell(m_formatContext->pb);
+    if (m_fragmentation->onFragment) {
+      m_fragmentation->onFragment(
+          {0, 0, end, time::Seconds{0.}, time::Seconds{0.}});
+    }
+    m_fragmentOffset = end;
+  }
 }
 
 void MuxerImpl::close() {
@@ -99,6 +208,10 @@ void MuxerImpl::close() {
   LOG_INFO("Closing muxer to " + m_mediaInfo.uri);
 
   if (m_formatContext->pb) {
+    if (m_fragmentation) {
+      flushFragment();
+    }
+
     avio_flush(m_formatContext->pb);
 
     LOG_DEBUG("Writing trailer to " + m_mediaInfo.uri);
@@ -111,48 +224,316 @@ void MuxerImpl::close() {
 
     LOG_DEBUG("Closing I/O to " + m_mediaInfo.uri);
 
-    avio_close(m_formatContext->pb);
+    if (m_sink) {
+      closeSink();
+    } else {
+      avio_close(m_formatContext->pb);
+    }
   } else {
     LOG_ERROR("No I/O context found while closing muxer to " + m_mediaInfo.uri);
   }
 
   avformat_free_context(m_formatContext);
+  m_formatContext = nullptr;
 }
 
 void MuxerImpl::write(avcodec::IAVPacket *packet) {
+  auto const packetImpl = toWritablePacket(packet);
+
+  std::lock_guard<std::mutex> l(m_ioMutex);
+
+  auto const &rescaler =
+      getRescaler(packetImpl->getStreamIndex(), packetImpl->getTimebase());
+  rescaler.rescale(packetImpl->getWrappedPacket());
+  packetImpl->setTimebase(rescaler.to());
+
+  writeRescaled(packetImpl);
+}
+
+void MuxerImpl::write(std::vector<avcodec::IAVPacket *> const &packets) {
+  std::lock_guard<std::mutex> l(m_ioMutex);
+
+  m_batch.clear();
+  for (auto &&packet : packets) {
+    m_batch.push_back(toWritablePacket(packet));
+  }
+
+  // Timestamps are converted stream by stream in bulk before writing
+  for (unsigned int streamIdx = 0; streamIdx < m_formatContext->nb_streams;
+       ++streamIdx) {
+    m_batchTimestamps.clear();
+    time::TimestampRescaler const *rescaler{nullptr};
+
+    for (auto &&packetImpl : m_batch) {
+      if (packetImpl->getStreamIndex() != static_cast<int>(streamIdx)) {
+        continue;
+      }
+
+      if (!rescaler) {
+        rescaler = &getRescaler(streamIdx, packetImpl->getTimebase());
+      }
+
+      auto const avpacket = packetImpl->getWrappedPacket();
+      if (packetImpl->getTimebase() != rescaler->from()) {
+        // Unusual: a different timebase for the same stream in one batch
+        time::TimestampRescaler(packetImpl->getTimebase(), rescaler->to())
+            .rescale(avpacket);
+      } else {
+        m_batchTimestamps.insert(m_batchTimestamps.end(),
+                                 {avpacket->pts, avpacket->dts,
+                                  avpacket->duration > 0 ? avpacket->duration
+                                                         : 0});
+      }
+    }
+
+    if (!rescaler) {
+      continue;
+    }
+
+    rescaler->rescale(m_batchTimestamps.data(), m_batchTimestamps.size());
+
+    auto ts = m_batchTimestamps.cbegin();
+    for (auto &&packetImpl : m_batch) {
+      if (packetImpl->getStreamIndex() != static_cast<int>(streamIdx)) {
+        continue;
+      }
+
+      if (packetImpl->getTimebase() == rescaler->from()) {
+        auto const avpacket = packetImpl->getWrappedPacket();
+        avpacket->pts = *ts++;
+        avpacket->dts = *ts++;
+        avpacket->duration = *ts++;
+      }
+      packetImpl->setTimebase(rescaler->to());
+    }
+  }
+
+  for (auto &&packetImpl : m_batch) {
+    writeRescaled(packetImpl);
+  }
+  m_batch.clear();
+}
+
+avcodec::AVPacketImpl *MuxerImpl::toWritablePacket(avcodec::IAVPacket *packet) {
   if (!m_formatContext) {
     throw std::runtime_error("Muxer to " + m_mediaInfo.uri + " not opened yet");
   }
 
-  auto const debugInfo = buildDebugInfo(packet);
-
-  auto const packetImpl = reinterpret_cast<avcodec::AVPacketImpl *>(packet);
+  auto const packetImpl = dynamic_cast<avcodec::AVPacketImpl *>(packet);
   if (!packetImpl) {
-    throw std::runtime_error("Could not handle packet for " + m_mediaInfo.uri +
-                             ". " + debugInfo);
+    throw std::runtime_error("Could not handle packet for " + m_mediaInfo.uri);
   }
 
-  auto const pts = packetImpl->getPts();
-  auto const dts = packetImpl->getDts();
+  auto const streamIdx = packetImpl->getStreamIndex();
+  if (streamIdx < 0 ||
+      streamIdx >= static_cast<int>(m_formatContext->nb_streams)) {
+    throw std::runtime_error("Stream " + std::to_string(streamIdx) +
+                             " not found in " + m_mediaInfo.uri);
+  }
 
-  std::lock_guard<std::mutex> l(m_ioMutex);
+  return packetImpl;
+}
+
+time::TimestampRescaler const &
+MuxerImpl::getRescaler(int streamIdx, time::Timebase const &tb) {
+  auto &rescaler = m_rescalers[streamIdx];
 
-  auto const streamTb =
-      m_formatContext->streams[packetImpl->getStreamIndex()]->time_base;
-  auto const tb = time::Timebase({streamTb.num, streamTb.den});
+  // Packets with a timebase other than the planned one (i.e. encoder output)
+  // replace the plan of the stream
+  if (rescaler.from() != tb) {
+    rescaler = time::TimestampRescaler(tb, rescaler.to());
+  }
 
-  packetImpl->setTimebase(tb);
-  packetImpl->setTimestamp(pts.toTimebase(tb), dts.toTimebase(tb));
+  return rescaler;
+}
 
-  LOG_DEBUG("Writing packet to " + m_mediaInfo.uri + ". " + debugInfo);
+void MuxerImpl::writeRescaled(avcodec::AVPacketImpl *packet) {
+  if (LOG_DEBUG_ENABLED) {
+    LOG_DEBUG("Writing packet to " + m_mediaInfo.uri + ". " +
+              buildDebugInfo(packet));
+  }
 
-  int const error =
-      av_write_frame(m_formatContext, packetImpl->getWrappedPacket());
+  auto const avpacket = packet->getWrappedPacket();
+
+  if (m_fragmentation && avpacket->stream_index == m_fragmentRefStream &&
+      m_fragmentStart >= 0 &&
+      (!m_fragmentation->keyframeAligned ||
+       (avpacket->flags & AV_PKT_FLAG_KEY))) {
+    auto const tb = m_formatContext->streams[avpacket->stream_index]->time_base;
+    auto const time = packetTime(avpacket, tb);
+    if (time - m_fragmentStart >= m_fragmentation->fragmentDuration.count()) {
+      flushFragment();
+    }
+  }
+
+  int const error = av_write_frame(m_formatContext, avpacket);
   if (error < 0) {
     LOG_FATAL_FFMPEG_ERR("Error while writing packet for " + m_mediaInfo.uri +
-                             ". " + debugInfo,
+                             ". " + buildDebugInfo(packet),
+                         error);
+  }
+
+  if (m_fragmentation) {
+    onPacketWritten(avpacket);
+  }
+}
+
+MediaInfo const &MuxerImpl::getMediaInfo() const { return m_mediaInfo; }
+
+std::string MuxerImpl::getFormatName() const {
+  if (m_formatContext) {
+    return m_formatContext->oformat->name;
+  }
+
+  auto const format = av_guess_format(m_mediaInfo.format.c_str(),
+                                      m_mediaInfo.uri.c_str(), nullptr);
+  return format ? format->name : m_mediaInfo.format;
+}
+
+void MuxerImpl::setCodecParameters(int streamIdx,
+                                   AVCodecParameters const *codecPar) {
+  if (m_formatContext) {
+    LOG_FATAL("Cannot change codec parameters of " + m_mediaInfo.uri +
+              " once the muxer is opened");
+  }
+
+  auto const it = m_mediaInfo.streamsInfo.find(streamIdx);
+  if (it == m_mediaInfo.streamsInfo.end()) {
+    LOG_FATAL("Stream " + std::to_string(streamIdx) + " not found in " +
+              m_mediaInfo.uri);
+  }
+
+  int const error = avcodec_parameters_copy(*it->second.codecPar, codecPar);
+  if (error < 0) {
+    LOG_FATAL_FFMPEG_ERR("Error while copying codec parameters of stream " +
+                             std::to_string(streamIdx),
+                         error);
+  }
+}
+
+time::Timebase MuxerImpl::getStreamTimebase(int streamIdx) const {
+  if (!m_formatContext) {
+    LOG_FATAL("Muxer to " + m_mediaInfo.uri + " not opened yet");
+  }
+
+  if (streamIdx < 0 ||
+      streamIdx >= static_cast<int>(m_formatContext->nb_streams)) {
+    LOG_FATAL("Stream " + std::to_string(streamIdx) + " not found in " +
+              m_mediaInfo.uri);
+  }
+
+  auto const tb = m_formatContext->streams[streamIdx]->time_base;
+  return time::Timebase(tb.num, tb.den);
+}
+
+void MuxerImpl::openSink() {
+  auto const buffer = static_cast<unsigned char *>(av_malloc(SINK_BUFFER_SIZE));
+  if (!buffer) {
+    LOG_FATAL("Could not allocate I/O buffer for " + m_mediaInfo.uri);
+  }
+
+  // The sink receives the I/O buffer itself on each flush
+  m_formatContext->pb = avio_alloc_context(
+      buffer, SINK_BUFFER_SIZE, 1, m_sink, nullptr, &writeToSink,
+      m_sink->isSeekable() ? &seekSink : nullptr);
+  if (!m_formatContext->pb) {
+    av_free(buffer);
+    LOG_FATAL("Could not allocate I/O context for " + m_mediaInfo.uri);
+  }
+
+  m_formatContext->pb->seekable =
+      m_sink->isSeekable() ? AVIO_SEEKABLE_NORMAL : 0;
+  m_formatContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+}
+
+void MuxerImpl::closeSink() {
+  // The buffer may have been reallocated by the I/O layer
+  av_freep(&m_formatContext->pb->buffer);
+  avio_context_free(&m_formatContext->pb);
+}
+
+void MuxerImpl::setupFragmentation(AVDictionary **opts) {
+  if (!isFragmentableFormat(m_formatContext->oformat)) {
+    av_dict_free(opts);
+    LOG_FATAL("Fragmented output is not supported by format " +
+              std::string(m_formatContext->oformat->name));
+  }
+
+  // Fragments are cut by the muxer itself, see MuxerImpl::write()
+  std::string movflags = "+frag_custom+default_base_moof";
+  if (m_fragmentation->emptyMoov) {
+    movflags += "+empty_moov";
+  }
+
+  int const error =
+      av_dict_set(opts, "movflags", movflags.c_str(), AV_DICT_APPEND);
+  if (error < 0) {
+    av_dict_free(opts);
+    LOG_FATAL_FFMPEG_ERR("Error while setting fragmentation flags for " +
+                             m_mediaInfo.uri,
                          error);
   }
+
+  // Fragments are cut at the first video stream or at the first stream
+  m_fragmentRefStream = 0;
+  for (unsigned int i = 0; i < m_formatContext->nb_streams; ++i) {
+    if (m_formatContext->streams[i]->codecpar->codec_type ==
+        AVMEDIA_TYPE_VIDEO) {
+      m_fragmentRefStream = static_cast<int>(i);
+      break;
+    }
+  }
+
+  m_fragmentIndex = 1;
+  m_fragmentOffset = 0;
+  m_fragmentStart = m_fragmentEnd = -1.;
+}
+
+void MuxerImpl::onPacketWritten(AVPacket const *packet) {
+  auto const tb = m_formatContext->streams[packet->stream_index]->time_base;
+  auto const start = packetTime(packet, tb);
+  if (start < 0) {
+    return;
+  }
+
+  auto const end = start + packet->duration * av_q2d(tb);
+  if (m_fragmentStart < 0 || start < m_fragmentStart) {
+    m_fragmentStart = start;
+  }
+  m_fragmentEnd = std::max(m_fragmentEnd, end);
+}
+
+void MuxerImpl::flushFragment() {
+  if (m_fragmentStart < 0) {
+    return;
+  }
+
+  // With frag_custom, a null packet makes the muxer write the pending fragment
+  int const error = av_write_frame(m_formatContext, nullptr);
+  if (error < 0) {
+    LOG_FATAL_FFMPEG_ERR("Error while flushing fragment for " +
+                             m_mediaInfo.uri,
+                         error);
+  }
+  avio_flush(m_formatContext->pb);
+
+  auto const end = avio_tell(m_formatContext->pb);
+  FragmentInfo const info{m_fragmentIndex, m_fragmentOffset,
+                          end - m_fragmentOffset,
+                          time::Seconds{m_fragmentStart},
+                          time::Seconds{m_fragmentEnd - m_fragmentStart}};
+
+  LOG_DEBUG("Fragment " + std::to_string(info.index) + " written to " +
+            m_mediaInfo.uri + " at offset " + std::to_string(info.offset) +
+            " (" + std::to_string(info.size) + " bytes)");
+
+  ++m_fragmentIndex;
+  m_fragmentOffset = end;
+  m_fragmentStart = m_fragmentEnd = -1.;
+
+  if (m_fragmentation->onFragment) {
+    m_fragmentation->onFragment(info);
+  }
 }
 }; // namespace avformat
 }; // namespace libffmpegxx
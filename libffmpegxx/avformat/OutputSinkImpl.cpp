@@ -0,0 +1,220 @@
+#include "avformat/OutputSinkImpl.h"
+
+#include "utils/LoggerApi.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+#include <libavformat/avio.h>
+#include <libavutil/error.h>
+}
+
+namespace libffmpegxx {
+namespace avformat {
+namespace {
+/**
+ * @brief Resolves a seek request against the current position and size.
+ * @return the new position or a negative FFmpeg API error code.
+ */
+int64_t resolveSeek(int64_t offset, int whence, int64_t position,
+                    int64_t size) {
+  switch (whence & ~AVSEEK_FORCE) {
+  case SEEK_SET:
+    return offset;
+  case SEEK_CUR:
+    return position + offset;
+  case SEEK_END:
+    return size + offset;
+  default:
+    return AVERROR(EINVAL);
+  }
+}
+} // namespace
+
+IMemoryOutputSink *OutputSinkFactory::createMemorySink(size_t initialCapacity) {
+  return new MemoryOutputSinkImpl(initialCapacity);
+}
+
+IOutputSink *OutputSinkFactory::createCallbackSink(WriteCallback const &write,
+                                                   SeekCallback const &seek) {
+  return new CallbackOutputSinkImpl(write, seek);
+}
+
+IChunkChainOutputSink *
+OutputSinkFactory::createChunkChainSink(size_t chunkSize, size_t chunkCount) {
+  return new ChunkChainOutputSinkImpl(chunkSize, chunkCount);
+}
+
+MemoryOutputSinkImpl::MemoryOutputSinkImpl(size_t initialCapacity) {
+  m_buffer.reserve(initialCapacity);
+}
+
+int MemoryOutputSinkImpl::write(uint8_t const *data, int size) {
+  if (size < 0 || m_position < m_base) {
+    return AVERROR(EINVAL);
+  }
+
+  auto const offset = static_cast<size_t>(m_position - m_base);
+  if (offset > m_buffer.size()) {
+    // Seeked past the end, the gap is zero filled
+    m_buffer.resize(offset);
+  }
+
+  // Rewritten bytes (i.e. headers patched on close) are overwritten in place
+  auto const overwritten =
+      std::min(static_cast<size_t>(size), m_buffer.size() - offset);
+  std::memcpy(m_buffer.data() + offset, data, overwritten);
+  m_buffer.insert(m_buffer.end(), data + overwritten, data + size);
+
+  m_position += size;
+  return size;
+}
+
+int64_t MemoryOutputSinkImpl::seek(int64_t offset, int whence) {
+  auto const size = m_base + static_cast<int64_t>(m_buffer.size());
+  if (whence & AVSEEK_SIZE) {
+    return size;
+  }
+
+  auto const position = resolveSeek(offset, whence, m_position, size);
+  if (position < m_base) {
+    return AVERROR(EINVAL);
+  }
+
+  m_position = position;
+  return m_position;
+}
+
+bool MemoryOutputSinkImpl::isSeekable() const { return true; }
+
+uint8_t const *MemoryOutputSinkImpl::getData() const {
+  return m_buffer.data();
+}
+
+size_t MemoryOutputSinkImpl::getSize() const { return m_buffer.size(); }
+
+int64_t MemoryOutputSinkImpl::getOffset() const { return m_base; }
+
+std::vector<uint8_t> MemoryOutputSinkImpl::release() {
+  m_base += static_cast<int64_t>(m_buffer.size());
+  m_position = std::max(m_position, m_base);
+
+  std::vector<uint8_t> data;
+  data.swap(m_buffer);
+  return data;
+}
+
+CallbackOutputSinkImpl::CallbackOutputSinkImpl(
+    OutputSinkFactory::WriteCallback const &write,
+    OutputSinkFactory::SeekCallback const &seek)
+    : m_write(write), m_seek(seek) {
+  if (!m_write) {
+    LOG_FATAL("Output sink write callback cannot be empty");
+  }
+}
+
+int CallbackOutputSinkImpl::write(uint8_t const *data, int size) {
+  return m_write(data, size);
+}
+
+int64_t CallbackOutputSinkImpl::seek(int64_t offset, int whence) {
+  return m_seek ? m_seek(offset, whence) : AVERROR(ENOSYS);
+}
+
+bool CallbackOutputSinkImpl::isSeekable() const {
+  return static_cast<bool>(m_seek);
+}
+
+ChunkChainOutputSinkImpl::ChunkChainOutputSinkImpl(size_t chunkSize,
+                                                   size_t chunkCount)
+    : m_chunkSize(chunkSize) {
+  if (m_chunkSize == 0) {
+    LOG_FATAL("Output sink chunk size cannot be zero");
+  }
+
+  m_chunks.reserve(chunkCount);
+  for (size_t i = 0; i < chunkCount; ++i) {
+    m_chunks.emplace_back(new uint8_t[m_chunkSize]);
+  }
+}
+
+int ChunkChainOutputSinkImpl::write(uint8_t const *data, int size) {
+  if (size < 0) {
+    return AVERROR(EINVAL);
+  }
+
+  auto const end = static_cast<size_t>(m_position) + size;
+  auto const neededChunks = (end + m_chunkSize - 1) / m_chunkSize;
+  if (neededChunks > m_chunks.size()) {
+    LOG_DEBUG("Output sink grows to " + std::to_string(neededChunks) +
+              " chunks");
+    while (m_chunks.size() < neededChunks) {
+      m_chunks.emplace_back(new uint8_t[m_chunkSize]);
+    }
+  }
+
+  // Gaps left by seeking past the end are zero filled
+  for (auto gap = static_cast<size_t>(m_size);
+       gap < static_cast<size_t>(m_position);) {
+    auto const chunkOffset = gap % m_chunkSize;
+    auto const count = std::min(m_chunkSize - chunkOffset,
+                                static_cast<size_t>(m_position) - gap);
+    std::memset(m_chunks[gap / m_chunkSize].get() + chunkOffset, 0, count);
+    gap += count;
+  }
+
+  auto position = static_cast<size_t>(m_position);
+  for (int written = 0; written < size;) {
+    auto const chunkOffset = position % m_chunkSize;
+    auto const count = std::min(m_chunkSize - chunkOffset,
+                                static_cast<size_t>(size - written));
+    std::memcpy(m_chunks[position / m_chunkSize].get() + chunkOffset,
+                data + written, count);
+    position += count;
+    written += static_cast<int>(count);
+  }
+
+  m_position = static_cast<int64_t>(position);
+  m_size = std::max(m_size, m_position);
+  return size;
+}
+
+int64_t ChunkChainOutputSinkImpl::seek(int64_t offset, int whence) {
+  if (whence & AVSEEK_SIZE) {
+    return m_size;
+  }
+
+  auto const position = resolveSeek(offset, whence, m_position, m_size);
+  if (position < 0) {
+    return AVERROR(EINVAL);
+  }
+
+  m_position = position;
+  return m_position;
+}
+
+bool ChunkChainOutputSinkImpl::isSeekable() const { return true; }
+
+std::vector<OutputChunk> ChunkChainOutputSinkImpl::getChunks() const {
+  std::vector<OutputChunk> chunks;
+  for (size_t offset = 0; offset < static_cast<size_t>(m_size);
+       offset += m_chunkSize) {
+    chunks.push_back(
+        {m_chunks[offset / m_chunkSize].get(),
+         std::min(m_chunkSize, static_cast<size_t>(m_size) - offset)});
+  }
+  return chunks;
+}
+
+size_t ChunkChainOutputSinkImpl::getSize() const {
+  return static_cast<size_t>(m_size);
+}
+
+void ChunkChainOutputSinkImpl::reset() {
+  m_size = 0;
+  m_position = 0;
+}
+}; // namespace avformat
+}; // namespace libffmpegxx
@@ -0,0 +1,292 @@
+#include "avformat/RemuxerImpl.h"
+
+#include "public/avformat/IDemuxer.h"
+
+#include "avcodec/AVPacketImpl.h"
+#include "avformat/MuxerImpl.h"
+#include "utils/LoggerApi.h"
+#include "utils/exception.h"
+
+#include <set>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#if __has_include(<libavcodec/bsf.h>)
+#include <libavcodec/bsf.h>
+#endif
+}
+
+namespace libffmpegxx {
+namespace avformat {
+namespace {
+/**
+ * @brief Chooses the bitstream filter needed to carry a stream in the given
+ * output format.
+ * @return the filter name or an empty string if none is needed.
+ */
+std::string selectBitstreamFilter(AVCodecParameters const *codecPar,
+                                  std::string const &format) {
+  static std::set<std::string> const ANNEXB_FORMATS = {"mpegts", "rtp_mpegts",
+                                                       "h264", "hevc"};
+  static std::set<std::string> const ASC_FORMATS = {
+      "mp4", "mov", "ismv", "ipod", "3gp", "3g2", "psp", "f4v", "flv",
+      "matroska"};
+
+  // avcC/hvcC extradata means length prefixed NAL units (MP4 style)
+  bool const lengthPrefixed =
+      codecPar->extradata_size > 0 && codecPar->extradata[0] == 1;
+
+  switch (codecPar->codec_id) {
+  case AV_CODEC_ID_H264:
+    if (lengthPrefixed && ANNEXB_FORMATS.count(format)) {
+      return "h264_mp4toannexb";
+    }
+    break;
+  case AV_CODEC_ID_HEVC:
+    if (lengthPrefixed && ANNEXB_FORMATS.count(format)) {
+      return "hevc_mp4toannexb";
+    }
+    break;
+  case AV_CODEC_ID_AAC:
+    // AAC without AudioSpecificConfig comes with ADTS headers
+    if (codecPar->extradata_size == 0 && ASC_FORMATS.count(format)) {
+      return "aac_adtstoasc";
+    }
+    break;
+  default:
+    break;
+  }
+
+  return "";
+}
+} // namespace
+
+IRemuxer *RemuxerFactory::create(IDemuxer *demuxer, IMuxer *muxer) {
+  return new RemuxerImpl(demuxer, muxer);
+}
+
+RemuxerImpl::RemuxerImpl(IDemuxer *demuxer, IMuxer *muxer)
+    : m_demuxer(demuxer) {
+  if (!m_demuxer) {
+    LOG_FATAL("Demuxer cannot be null when creating a remuxer");
+  }
+
+  m_muxer = dynamic_cast<MuxerImpl *>(muxer);
+  if (!m_muxer) {
+    LOG_FATAL("Could not handle given muxer when creating a remuxer");
+  }
+}
+
+RemuxerImpl::~RemuxerImpl() {
+  if (m_thread.joinable()) {
+    stop();
+    wait();
+  }
+
+  freePlans();
+}
+
+void RemuxerImpl::start(utils::AVOptions const &options) {
+  if (m_thread.joinable()) {
+    LOG_FATAL("Remuxer to " + m_muxer->getMediaInfo().uri +
+              " is already running");
+  }
+
+  freePlans();
+  buildPlans();
+
+  m_muxer->open(options);
+
+  // Rescale plans are fixed once the muxer has chosen its timebases
+  for (auto &&[streamIdx, plan] : m_plans) {
+    plan.rescaler = time::TimestampRescaler(
+        plan.inputTb, m_muxer->getStreamTimebase(plan.outputIndex));
+  }
+
+  m_packets = 0;
+  m_bytes = 0;
+  m_result = 0;
+  m_stopRequested = false;
+  m_stopwatch.start();
+
+  m_thread = std::thread(&RemuxerImpl::run, this);
+}
+
+void RemuxerImpl::stop() { m_stopRequested = true; }
+
+int RemuxerImpl::wait() {
+  if (!m_thread.joinable()) {
+    return m_result;
+  }
+
+  m_thread.join();
+  m_muxer->close();
+  freePlans();
+
+  auto const stats = getStatistics();
+  LOG_INFO("Remuxed " + std::to_string(stats.packets) + " packets (" +
+           std::to_string(stats.bytes) + " bytes) to " +
+           m_muxer->getMediaInfo().uri + " at " +
+           std::to_string(stats.throughput) + " MB/s");
+
+  return m_result;
+}
+
+bool RemuxerImpl::isRunning() const { return m_stopwatch.isRunning(); }
+
+RemuxStatistics RemuxerImpl::getStatistics() const {
+  RemuxStatistics stats;
+  stats.packets = m_packets;
+  stats.bytes = m_bytes;
+  stats.elapsed = m_stopwatch.getElapsed();
+  stats.throughput = m_stopwatch.getThroughput(stats.bytes);
+
+  return stats;
+}
+
+void RemuxerImpl::buildPlans() {
+  auto const inputInfo = m_demuxer->getMediaInfo();
+  auto const format = m_muxer->getFormatName();
+
+  // Output streams are created in the order of the muxer MediaInfo
+  std::vector<int> streamIndexes;
+  for (auto &&[streamIdx, _] : m_muxer->getMediaInfo().streamsInfo) {
+    streamIndexes.push_back(streamIdx);
+  }
+
+  int outputIndex = 0;
+  for (int const streamIdx : streamIndexes) {
+    auto const input = inputInfo.streamsInfo.find(streamIdx);
+    if (input == inputInfo.streamsInfo.end()) {
+      freePlans();
+      LOG_FATAL("Stream " + std::to_string(streamIdx) + " of " +
+                m_muxer->getMediaInfo().uri + " not found in " +
+                inputInfo.uri);
+    }
+
+    StreamPlan plan;
+    plan.outputIndex = outputIndex++;
+    plan.inputTb = input->second.timebase;
+
+    auto const bsfName =
+        selectBitstreamFilter(*input->second.codecPar, format);
+    if (!bsfName.empty()) {
+      auto const filter = av_bsf_get_by_name(bsfName.c_str());
+      int error = filter ? av_bsf_alloc(filter, &plan.bsf)
+                         : AVERROR_BSF_NOT_FOUND;
+      if (error >= 0) {
+        avcodec_parameters_copy(plan.bsf->par_in, *input->second.codecPar);
+        plan.bsf->time_base_in = {plan.inputTb.num(), plan.inputTb.den()};
+        error = av_bsf_init(plan.bsf);
+      }
+
+      if (error < 0) {
+        av_bsf_free(&plan.bsf);
+        freePlans();
+        LOG_FATAL_FFMPEG_ERR("Could not initialize " + bsfName +
+                                 " for stream " + std::to_string(streamIdx),
+                             error);
+      }
+
+      m_muxer->setCodecParameters(streamIdx, plan.bsf->par_out);
+      plan.inputTb = time::Timebase(plan.bsf->time_base_out.num,
+                                    plan.bsf->time_base_out.den);
+
+      LOG_INFO("Using " + bsfName + " for stream " +
+               std::to_string(streamIdx) + " remuxed to " + format);
+    }
+
+    m_plans.insert({streamIdx, plan});
+  }
+}
+
+void RemuxerImpl::freePlans() {
+  for (auto &&[_, plan] : m_plans) {
+    if (plan.bsf) {
+      av_bsf_free(&plan.bsf);
+    }
+  }
+  m_plans.clear();
+}
+
+void RemuxerImpl::run() {
+  avcodec::AVPacketImpl packet;
+  int error = 0;
+
+  try {
+    while (!m_stopRequested) {
+      error = m_demuxer->read(&packet);
+      if (error < 0) {
+        break;
+      }
+
+      auto const plan = m_plans.find(packet.getStreamIndex());
+      if (plan == m_plans.end()) {
+        continue;
+      }
+
+      error = filterAndWrite(plan->second, &packet);
+      if (error < 0) {
+        break;
+      }
+    }
+
+    if (error == AVERROR_EOF) {
+      // An empty packet signals the end of stream to the bitstream filters,
+      // which drain any packet they still buffer
+      error = 0;
+      for (auto &&[_, plan] : m_plans) {
+        if (plan.bsf && error >= 0) {
+          packet.clear();
+          error = filterAndWrite(plan, &packet);
+        }
+      }
+    }
+  } catch (std::exception const &e) {
+    LOG_ERROR("Remuxing to " + m_muxer->getMediaInfo().uri +
+              " failed: " + e.what());
+    error = AVERROR_UNKNOWN;
+  }
+
+  m_result = error;
+  m_stopwatch.stop();
+}
+
+int RemuxerImpl::filterAndWrite(StreamPlan &plan,
+                                avcodec::AVPacketImpl *packet) {
+  if (!plan.bsf) {
+    writePacket(plan, packet);
+    return 0;
+  }
+
+  auto const avpacket = packet->getWrappedPacket();
+  int error = av_bsf_send_packet(plan.bsf, avpacket);
+  if (error < 0) {
+    LOG_ERROR("Error sending packet to bitstream filter: " +
+              utils::Logger::avErrorToStr(error));
+    return error;
+  }
+
+  // The sent packet is left blank, so it is reused for the filtered ones
+  while ((error = av_bsf_receive_packet(plan.bsf, avpacket)) == 0) {
+    writePacket(plan, packet);
+  }
+
+  return (error == AVERROR(EAGAIN) || error == AVERROR_EOF) ? 0 : error;
+}
+
+void RemuxerImpl::writePacket(StreamPlan const &plan,
+                              avcodec::AVPacketImpl *packet) {
+  auto const avpacket = packet->getWrappedPacket();
+
+  avpacket->stream_index = plan.outputIndex;
+  plan.rescaler.rescale(avpacket);
+  packet->setTimebase(plan.rescaler.to());
+
+  m_bytes += avpacket->size;
+  ++m_packets;
+
+  m_muxer->write(packet);
+}
+}; // namespace avformat
+}; // namespace libffmpegxx
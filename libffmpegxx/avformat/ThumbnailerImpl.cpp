@@ -0,0 +1,398 @@
+#include "avformat/ThumbnailerImpl.h"
+
+#include "public/time/Timestamp.h"
+
+#include "avcodec/AVPacketImpl.h"
+#include "avcodec/EncoderImpl.h"
+#include "avutil/AVFrameImpl.h"
+#include "utils/LoggerApi.h"
+#include "utils/exception.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/common.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace libffmpegxx {
+namespace avcodec {
+extern void fitVideoSize(AVCodecParameters const *source, int &width,
+                         int &height);
+extern AVPixelFormat chooseEncoderPixelFormat(AVCodec const *codec,
+                                              AVPixelFormat requested,
+                                              AVPixelFormat source);
+extern avformat::StreamInfo
+makeEncodedStreamInfo(avformat::StreamInfo const &source,
+                      AVCodec const *codec, int width, int height,
+                      AVPixelFormat format);
+}; // namespace avcodec
+
+namespace avformat {
+namespace {
+// Keyframes read before giving up on a time, as decoders with a delay need
+// a few packets before returning the first frame
+constexpr int MAX_KEYFRAMES = 8;
+
+// Lowres decoding reduces by up to 1 / 2^3
+constexpr int MAX_LOWRES = 3;
+
+int64_t framePts(AVFrame const *frame) {
+  return frame->best_effort_timestamp != AV_NOPTS_VALUE
+             ? frame->best_effort_timestamp
+             : frame->pts;
+}
+
+/**
+ * @brief Copies a frame into another one at a position. Positions and sizes
+ * must be multiples of the chroma subsampling.
+ */
+void copyTile(AVFrame const *src, AVFrame *dst, int x, int y) {
+  auto const format = static_cast<AVPixelFormat>(dst->format);
+  auto const desc = av_pix_fmt_desc_get(format);
+  for (int p = 0; p < av_pix_fmt_count_planes(format); ++p) {
+    auto const shift = p == 1 || p == 2 ? desc->log2_chroma_h : 0;
+    auto const offset = av_image_get_linesize(format, x, p);
+    av_image_copy_plane(
+        dst->data[p] + static_cast<ptrdiff_t>(y >> shift) * dst->linesize[p] +
+            offset,
+        dst->linesize[p], src->data[p], src->linesize[p],
+        av_image_get_linesize(format, src->width, p),
+        AV_CEIL_RSHIFT(src->height, shift));
+  }
+}
+} // namespace
+
+IThumbnailer *ThumbnailerFactory::create(std::string const &uri,
+                                         int streamIdx,
+                                         ThumbnailerConfig const &config) {
+  return new ThumbnailerImpl(uri, streamIdx, config);
+}
+
+ThumbnailerImpl::ThumbnailerImpl(std::string const &uri, int streamIdx,
+                                 ThumbnailerConfig const &config)
+    : m_uri(uri), m_streamIdx(streamIdx), m_config(config),
+      m_threads(utils::ThreadPool::resolveThreads(config.threads)) {
+  if (m_config.count == 0) {
+    LOG_FATAL("A thumbnailer needs at least one thumbnail");
+  }
+
+  // The probing demuxer becomes the first worker
+  auto worker = acquireWorker();
+  auto const info = worker->demuxer->getMediaInfo();
+  m_streamInfo = info.streamsInfo.at(m_streamIdx);
+  releaseWorker(std::move(worker));
+
+  m_start = m_streamInfo.startTime;
+  m_duration = m_streamInfo.duration.count() > 0 ? m_streamInfo.duration
+                                                 : info.duration;
+
+  m_codec = avcodec_find_encoder(m_config.codecId);
+  if (!m_codec) {
+    LOG_FATAL(std::string("Image encoder not found: ") +
+              avcodec_get_name(m_config.codecId));
+  }
+
+  auto const source = *m_streamInfo.codecPar;
+  m_width = m_config.width;
+  m_height = m_config.height;
+  avcodec::fitVideoSize(source, m_width, m_height);
+  m_format = avcodec::chooseEncoderPixelFormat(
+      m_codec, AV_PIX_FMT_NONE, static_cast<AVPixelFormat>(source->format));
+
+  // Tiles must start on whole chroma samples
+  auto const desc = av_pix_fmt_desc_get(m_format);
+  if (desc) {
+    auto const alignW = 1 << desc->log2_chroma_w;
+    auto const alignH = 1 << desc->log2_chroma_h;
+    m_width = (m_width + alignW - 1) / alignW * alignW;
+    m_height = (m_height + alignH - 1) / alignH * alignH;
+  }
+
+  avcodec::DecoderPoolConfig decoders;
+  decoders.maxIdle = m_threads;
+  decoders.options = m_config.decoderOptions;
+  // Parallelism comes from decoding several times at once
+  decoders.threading.mode = avcodec::ThreadingMode::NONE;
+  decoders.mode.skipFrame = AVDISCARD_NONKEY;
+  if (m_config.fastDecode) {
+    decoders.mode.skipLoopFilter = AVDISCARD_ALL;
+
+    auto const decoder = avcodec_find_decoder(m_streamInfo.codecId);
+    auto const maxLowres =
+        decoder ? std::min<int>(decoder->max_lowres, MAX_LOWRES) : 0;
+    while (decoders.mode.lowres < maxLowres &&
+           (source->width >> (decoders.mode.lowres + 1)) >= m_width &&
+           (source->height >> (decoders.mode.lowres + 1)) >= m_height) {
+      ++decoders.mode.lowres;
+    }
+  }
+  m_decoders = std::make_unique<avcodec::DecoderPoolImpl>(decoders);
+
+  m_threadPool = utils::ThreadPool::createForCaller(m_threads);
+}
+
+ThumbnailerImpl::~ThumbnailerImpl() = default;
+
+std::vector<Thumbnail> ThumbnailerImpl::createThumbnails() {
+  auto const times = getTimes();
+  std::vector<Thumbnail> thumbnails(times.size());
+  // Not a vector<bool>, as tasks set their flags concurrently
+  std::vector<char> extracted(times.size(), 0);
+
+  runParallel(times.size(), [&](size_t i, Worker &worker) {
+    auto &thumbnail = thumbnails[i];
+    thumbnail.requestedTime = times[i];
+
+    auto const frame = extractAt(worker, times[i], thumbnail.time);
+    if (frame) {
+      thumbnail.image = encodeImage(frame.get());
+      extracted[i] = 1;
+    }
+  });
+
+  std::vector<Thumbnail> result;
+  result.reserve(thumbnails.size());
+  for (size_t i = 0; i < thumbnails.size(); ++i) {
+    if (extracted[i]) {
+      result.push_back(std::move(thumbnails[i]));
+    }
+  }
+  return result;
+}
+
+SpriteSheet ThumbnailerImpl::createSpriteSheet() {
+  auto const times = getTimes();
+  auto const count = static_cast<int>(times.size());
+
+  SpriteSheet sheet;
+  sheet.tileWidth = m_width;
+  sheet.tileHeight = m_height;
+  sheet.columns =
+      m_config.columns > 0
+          ? std::min(m_config.columns, count)
+          : static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+  sheet.rows = (count + sheet.columns - 1) / sheet.columns;
+  sheet.width = sheet.columns * m_width;
+  sheet.height = sheet.rows * m_height;
+
+  avutil::AVFrameImpl image;
+  auto const frame = image.getWrappedFrame();
+  frame->width = sheet.width;
+  frame->height = sheet.height;
+  frame->format = m_format;
+  if (auto const err = av_frame_get_buffer(frame, 0); err < 0) {
+    LOG_FATAL_FFMPEG_ERR("Could not allocate the sprite sheet", err);
+  }
+
+  auto const desc = av_pix_fmt_desc_get(m_format);
+  auto const range = desc && std::strncmp(desc->name, "yuvj", 4) == 0
+                         ? AVCOL_RANGE_JPEG
+                         : AVCOL_RANGE_MPEG;
+  ptrdiff_t lineSizes[4];
+  for (int p = 0; p < 4; ++p) {
+    lineSizes[p] = frame->linesize[p];
+  }
+  av_image_fill_black(frame->data, lineSizes, m_format, range, frame->width,
+                      frame->height);
+
+  std::vector<Thumbnail> tiles(times.size());
+  std::vector<char> extracted(times.size(), 0);
+
+  // Tiles do not overlap, so they are copied from each task
+  runParallel(times.size(), [&](size_t i, Worker &worker) {
+    auto &tile = tiles[i];
+    tile.requestedTime = times[i];
+    tile.x = static_cast<int>(i % sheet.columns) * m_width;
+    tile.y = static_cast<int>(i / sheet.columns) * m_height;
+
+    auto const thumbnail = extractAt(worker, times[i], tile.time);
+    if (thumbnail) {
+      copyTile(thumbnail->getWrappedFrame(), frame, tile.x, tile.y);
+      extracted[i] = 1;
+    }
+  });
+
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    if (extracted[i]) {
+      sheet.tiles.push_back(std::move(tiles[i]));
+    }
+  }
+
+  sheet.image = encodeImage(&image);
+  return sheet;
+}
+
+void ThumbnailerImpl::runParallel(
+    size_t count, std::function<void(size_t, Worker &)> const &task) {
+  auto const run = [this, &task](size_t i) {
+    auto worker = acquireWorker();
+    try {
+      task(i, *worker);
+    } catch (...) {
+      releaseWorker(std::move(worker));
+      throw;
+    }
+    releaseWorker(std::move(worker));
+  };
+
+  if (m_threadPool && count > 1) {
+    m_threadPool->parallelFor(count, run);
+  } else {
+    for (size_t i = 0; i < count; ++i) {
+      run(i);
+    }
+  }
+}
+
+std::shared_ptr<avutil::AVFrameImpl>
+ThumbnailerImpl::extractAt(Worker &worker, time::Seconds const &time,
+                           time::Seconds &frameTime) {
+  auto const tb = m_streamInfo.timebase;
+  auto target = time::Timestamp(0, tb);
+  target.set(time);
+
+  // Timestamps cannot be negative. Seeking backwards to 0 reaches the first
+  // keyframe anyway.
+  int error = worker.demuxer->seek(
+      m_streamIdx, time::Timestamp(std::max<int64_t>(target.value(), 0), tb));
+  if (error < 0) {
+    LOG_WARN("Could not seek to " + std::to_string(time.count()) + " s in " +
+             m_uri);
+    return nullptr;
+  }
+
+  auto const decoder = m_decoders->acquire(m_streamInfo);
+
+  std::shared_ptr<avutil::IAVFrame> decoded;
+  auto const sink = [&decoded](std::shared_ptr<avutil::IAVFrame> const &f) {
+    if (!decoded) {
+      decoded = f;
+    }
+  };
+
+  // Only keyframes are read, as the demuxer discards the rest
+  avcodec::AVPacketImpl packet;
+  int keyframes = 0;
+  while (!decoded && keyframes < MAX_KEYFRAMES &&
+         (error = worker.demuxer->read(&packet)) >= 0) {
+    if (packet.getStreamIndex() != m_streamIdx) {
+      continue;
+    }
+    ++keyframes;
+
+    error = decoder->decode(&packet, sink);
+    if (error < 0 && error != AVERROR_INVALIDDATA) {
+      break;
+    }
+  }
+
+  if (!decoded) {
+    // The pool resets the decoder when it is released
+    decoder->decode(nullptr, sink);
+  }
+
+  if (!decoded) {
+    LOG_WARN("No keyframe decoded at " + std::to_string(time.count()) +
+             " s in " + m_uri);
+    return nullptr;
+  }
+
+  auto const frame =
+      static_cast<avutil::AVFrameImpl *>(decoded.get())->getWrappedFrame();
+  auto const pts = framePts(frame);
+  frameTime = pts != AV_NOPTS_VALUE ? time::Timestamp(pts, tb).toSeconds()
+                                    : time;
+
+  return worker.scaler->scaleFrame(
+      static_cast<avutil::AVFrameImpl *>(decoded.get()), m_width, m_height,
+      m_format);
+}
+
+std::vector<time::Seconds> ThumbnailerImpl::getTimes() const {
+  if (m_duration.count() <= 0) {
+    LOG_FATAL("Thumbnails need the stream duration, unknown for " + m_uri);
+  }
+
+  std::vector<time::Seconds> times;
+  times.reserve(m_config.count);
+  for (size_t i = 0; i < m_config.count; ++i) {
+    // Middle of each part, avoiding the fades at both ends
+    times.push_back(m_start + m_duration * ((i + 0.5) / m_config.count));
+  }
+  return times;
+}
+
+std::vector<uint8_t>
+ThumbnailerImpl::encodeImage(avutil::AVFrameImpl *frame) const {
+  avcodec::EncoderSettings settings;
+  settings.timebase = time::Timebase(1, 1);
+  settings.threading.mode = avcodec::ThreadingMode::NONE;
+
+  auto const wrapped = frame->getWrappedFrame();
+  avcodec::EncoderImpl encoder(
+      avcodec::makeEncodedStreamInfo(m_streamInfo, m_codec, wrapped->width,
+                                     wrapped->height, m_format),
+      settings, m_config.encoderOptions);
+
+  wrapped->pts = 0;
+  wrapped->pict_type = AV_PICTURE_TYPE_NONE;
+  frame->setTimebase(time::Timebase(1, 1));
+
+  std::vector<uint8_t> image;
+  auto const sink = [&image](std::shared_ptr<avcodec::IAVPacket> const &p) {
+    image.insert(image.end(), p->getRawData(), p->getRawData() + p->getSize());
+  };
+
+  int error = encoder.encode(frame, sink);
+  if (error < 0) {
+    LOG_FATAL_FFMPEG_ERR("Could not encode a thumbnail", error);
+  }
+
+  error = encoder.encode(nullptr, sink);
+  if (error < 0 && error != AVERROR_EOF) {
+    LOG_FATAL_FFMPEG_ERR("Could not encode a thumbnail", error);
+  }
+
+  return image;
+}
+
+std::unique_ptr<ThumbnailerImpl::Worker> ThumbnailerImpl::acquireWorker() {
+  {
+    std::lock_guard<std::mutex> lock(m_workersMutex);
+    if (!m_idleWorkers.empty()) {
+      auto worker = std::move(m_idleWorkers.back());
+      m_idleWorkers.pop_back();
+      return worker;
+    }
+  }
+
+  auto worker = std::make_unique<Worker>();
+  worker->demuxer = std::make_unique<DemuxerImpl>(m_uri);
+  auto const info = worker->demuxer->open(m_config.demuxerOptions);
+
+  auto const stream = info.streamsInfo.find(m_streamIdx);
+  if (stream == info.streamsInfo.end() ||
+      stream->second.type != StreamType::VIDEO) {
+    LOG_FATAL("Video stream " + std::to_string(m_streamIdx) +
+              " not found in " + m_uri);
+  }
+
+  for (auto &&[idx, _] : info.streamsInfo) {
+    worker->demuxer->setDiscard(
+        idx, idx == m_streamIdx ? AVDISCARD_NONKEY : AVDISCARD_ALL);
+  }
+
+  worker->scaler = std::make_unique<swscale::ScalerImpl>(m_config.scaling);
+  return worker;
+}
+
+void ThumbnailerImpl::releaseWorker(std::unique_ptr<Worker> worker) {
+  std::lock_guard<std::mutex> lock(m_workersMutex);
+  m_idleWorkers.push_back(std::move(worker));
+}
+}; // namespace avformat
+}; // namespace libffmpegxx
@@ -1,4 +1,5 @@
 #include "avutil/AVFrameImpl.h"
+#include "avutil/ChannelLayout.h"
 
 #include "public/time/Timebase.h"
 #include "public/time/Timestamp.h"
@@ -140,7 +141,13 @@ int AVFrameImpl::getAudioSamplerate() const { return m_avframe->sample_rate; }
 int AVFrameImpl::getAudioChannels() const { return m_avframe->nb_samples; }
 
 uint64_t AVFrameImpl::getAudioChannelLayout() const {
+#if AVUTIL_HAS_CH_LAYOUT
+  return m_avframe->ch_layout.order == AV_CHANNEL_ORDER_NATIVE
+             ? m_avframe->ch_layout.u.mask
+             : 0;
+#else
   return m_avframe->channel_layout;
+#endif
 }
 
 std::vector<AVFrameSideData *> AVFrameImpl::getSideData() {
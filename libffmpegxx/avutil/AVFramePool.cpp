@@ -0,0 +1,21 @@
+#include "avutil/AVFramePool.h"
+
+namespace libffmpegxx {
+namespace avutil {
+AVFramePool::AVFramePool(size_t maxIdle)
+    : m_pool(maxIdle, [](AVFrameImpl &frame) {
+        frame.clear();
+        return true;
+      }) {}
+
+std::shared_ptr<AVFrameImpl> AVFramePool::acquire() {
+  auto frame = m_pool.take();
+  if (!frame) {
+    frame = std::make_unique<AVFrameImpl>();
+  }
+  return m_pool.share(std::move(frame));
+}
+
+size_t AVFramePool::getIdleCount() const { return m_pool.getIdleCount(); }
+}; // namespace avutil
+}; // namespace libffmpegxx
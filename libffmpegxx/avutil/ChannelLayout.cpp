@@ -0,0 +1,44 @@
+#include "avutil/ChannelLayout.h"
+
+extern "C" {
+#include <libavutil/common.h>
+}
+
+namespace libffmpegxx {
+namespace avutil {
+#if AVUTIL_HAS_CH_LAYOUT
+uint64_t getChannelMask(AVChannelLayout const &layout) {
+  if (layout.order == AV_CHANNEL_ORDER_NATIVE) {
+    return layout.u.mask;
+  }
+
+  AVChannelLayout guessed;
+  av_channel_layout_default(&guessed, layout.nb_channels);
+  return guessed.order == AV_CHANNEL_ORDER_NATIVE ? guessed.u.mask : 0;
+}
+#endif
+
+int getChannelCount(uint64_t mask) { return av_popcount64(mask); }
+
+uint64_t getChannel(uint64_t mask, int index) {
+  for (; mask; mask &= mask - 1) {
+    if (index-- == 0) {
+      // Lowest set bit
+      return mask & (~mask + 1);
+    }
+  }
+  return 0;
+}
+
+int setChannelMask(AVFrame *frame, uint64_t mask) {
+#if AVUTIL_HAS_CH_LAYOUT
+  av_channel_layout_uninit(&frame->ch_layout);
+  return av_channel_layout_from_mask(&frame->ch_layout, mask);
+#else
+  frame->channel_layout = mask;
+  frame->channels = getChannelCount(mask);
+  return 0;
+#endif
+}
+}; // namespace avutil
+}; // namespace libffmpegxx
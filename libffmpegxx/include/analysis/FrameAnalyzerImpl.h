@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../public/analysis/IFrameAnalyzer.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+namespace libffmpegxx {
+namespace analysis {
+class FrameAnalyzerImpl : public IFrameAnalyzer {
+public:
+  explicit FrameAnalyzerImpl(FrameAnalyzerConfig const &config);
+  ~FrameAnalyzerImpl() override;
+
+  FrameAnalyzerImpl(FrameAnalyzerImpl const &) = delete;
+  FrameAnalyzerImpl &operator=(FrameAnalyzerImpl const &) = delete;
+
+  FrameAnalysis analyze(avutil::IAVFrame *frame) override;
+  void reset() override;
+  std::string getKernelName() const override;
+
+private:
+  /**
+   * @throws if the format has no 8 bit planar luma.
+   */
+  void checkFormat(int format);
+
+  FrameAnalyzerConfig m_config;
+
+  int m_checkedFormat{-1};
+
+  /**
+   * @brief Reference to the previous frame.
+   */
+  AVFrame *m_previous{nullptr};
+
+  /**
+   * @brief Mean absolute difference of the previous frame.
+   */
+  double m_previousMad{0.0};
+};
+}; // namespace analysis
+}; // namespace libffmpegxx
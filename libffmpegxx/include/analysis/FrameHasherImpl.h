@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../public/analysis/IFrameHasher.h"
+
+#include <optional>
+#include <vector>
+
+namespace libffmpegxx {
+namespace analysis {
+class FrameHasherImpl : public IFrameHasher {
+public:
+  explicit FrameHasherImpl(FrameHasherConfig const &config);
+
+  FrameHash hash(avutil::IAVFrame *frame) override;
+  bool addFrame(avutil::IAVFrame *frame) override;
+  Fingerprint getFingerprint() const override;
+  void reset() override;
+
+private:
+  /**
+   * @throws if the format has no 8 bit planar luma.
+   */
+  void checkFormat(int format);
+
+  FrameHasherConfig m_config;
+  int m_checkedFormat{-1};
+
+  /**
+   * @brief Column sums of the rows of a cell row.
+   */
+  std::vector<uint32_t> m_columnSums;
+
+  Fingerprint m_fingerprint;
+  std::optional<time::Seconds> m_lastTime;
+};
+}; // namespace analysis
+}; // namespace libffmpegxx
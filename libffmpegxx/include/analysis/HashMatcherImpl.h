@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../public/analysis/IHashMatcher.h"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace libffmpegxx {
+namespace analysis {
+class HashMatcherImpl : public IHashMatcher {
+public:
+  size_t add(Fingerprint const &fingerprint) override;
+  std::vector<HashMatch> find(FrameHash hash, int maxDistance) const override;
+  std::vector<FingerprintMatch> match(Fingerprint const &fingerprint,
+                                      int maxDistance,
+                                      double minRatio) const override;
+  size_t getFingerprintCount() const override;
+  size_t getHashCount() const override;
+
+private:
+  static constexpr int PARTS = 4;
+
+  /**
+   * @brief Part value and hash position, sorted by value.
+   */
+  using PartIndex = std::vector<std::pair<uint16_t, uint32_t>>;
+
+  static uint16_t partOf(FrameHash hash, int part);
+
+  // Stored hashes, with the fingerprint and position of each
+  std::vector<FrameHash> m_hashes;
+  std::vector<uint32_t> m_owners;
+  std::vector<uint32_t> m_positions;
+  size_t m_fingerprintCount{0};
+
+  std::array<PartIndex, PARTS> m_index;
+};
+}; // namespace analysis
+}; // namespace libffmpegxx
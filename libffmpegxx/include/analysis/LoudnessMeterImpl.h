@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../public/analysis/ILoudnessMeter.h"
+#include "swresample/ResamplerImpl.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace libffmpegxx {
+namespace analysis {
+class LoudnessMeterImpl : public ILoudnessMeter {
+public:
+  explicit LoudnessMeterImpl(LoudnessMeterConfig const &config);
+
+  void addFrame(avutil::IAVFrame *frame) override;
+  Loudness getLoudness() const override;
+  void reset() override;
+
+private:
+  static constexpr int HISTOGRAM_BINS = 1000;
+  static constexpr int SHORT_TERM_BLOCKS = 30;
+  static constexpr int MOMENTARY_BLOCKS = 4;
+
+  using Histogram = std::array<uint64_t, HISTOGRAM_BINS>;
+
+  /**
+   * @brief Sets up the filters for a sample rate and channel layout,
+   * unless they are already set up for them.
+   */
+  void configure(int sampleRate, uint64_t channelLayout);
+
+  /**
+   * @brief Measures planar float samples.
+   */
+  void process(float const *const *data, int samples);
+
+  /**
+   * @brief Ends a 100 ms block, updating the gated measurements.
+   */
+  void endBlock();
+
+  /**
+   * @brief Updates the true peak of a channel.
+   */
+  template <int Factor>
+  void measureTruePeak(int channel, float const *samples, int count);
+
+  static int binOf(double loudness);
+  static double integratedOf(Histogram const &histogram);
+  static double rangeOf(Histogram const &histogram);
+
+  LoudnessMeterConfig m_config;
+
+  /**
+   * @brief Converts input frames to planar float.
+   */
+  std::unique_ptr<swresample::ResamplerImpl> m_resampler;
+
+  int m_sampleRate{0};
+  uint64_t m_channelLayout{0};
+  int m_channels{0};
+  std::vector<double> m_weights;
+
+  // K-weighting filter: both stages combined, direct form II
+  std::array<double, 5> m_b{};
+  std::array<double, 5> m_a{};
+  std::vector<std::array<double, 4>> m_filterState;
+
+  int m_blockSamples{0};
+  int m_blockFill{0};
+  std::vector<double> m_blockEnergy;
+
+  /**
+   * @brief Mean square of the last 100 ms blocks, channels weighted.
+   */
+  std::array<double, SHORT_TERM_BLOCKS> m_blocks{};
+  int64_t m_blockCount{0};
+
+  // True peak oversampling: polyphase filter and delay lines
+  int m_oversampling{1};
+  int m_truePeakTaps{0};
+  std::vector<float> m_truePeakCoeffs;
+  std::vector<std::vector<float>> m_truePeakHistory;
+  std::vector<int> m_truePeakPos;
+
+  mutable std::mutex m_mutex;
+  Loudness m_loudness;
+  Histogram m_gatingBlocks{};
+  Histogram m_shortTermBlocks{};
+};
+}; // namespace analysis
+}; // namespace libffmpegxx
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../public/analysis/IQualityMeter.h"
+#include "utils/ThreadPool.h"
+
+#include <memory>
+#include <mutex>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+namespace libffmpegxx {
+namespace analysis {
+class QualityMeterImpl : public IQualityMeter {
+public:
+  explicit QualityMeterImpl(QualityMeterConfig const &config);
+
+  FrameQuality compare(avutil::IAVFrame *reference,
+                       avutil::IAVFrame *distorted) override;
+  StreamQuality getStreamQuality() const override;
+  void reset() override;
+  std::string getKernelName() const override;
+
+private:
+  /**
+   * @brief The Band struct holds the rows of a plane a task compares and
+   * its results.
+   */
+  struct Band {
+    int plane{0};
+    int firstRow{0};
+    int lastRow{0};
+    int firstWindow{0};
+    int lastWindow{0};
+
+    uint64_t sse{0};
+    double ssim{0.0};
+
+    /**
+     * @brief SSIM sums of two rows of 4x4 blocks.
+     */
+    std::vector<int32_t> sums;
+  };
+
+  /**
+   * @brief Splits the planes into bands, unless the frame geometry is the
+   * one they were made for.
+   */
+  void prepareBands(AVFrame const *frame);
+
+  /**
+   * @brief Compares the rows of a band.
+   */
+  void compareBand(Band &band, AVFrame const *reference,
+                   AVFrame const *distorted) const;
+
+  /**
+   * @brief Adds a frame to the stream quality.
+   */
+  void accumulate(FrameQuality const &quality);
+
+  QualityMeterConfig m_config;
+  size_t m_threads;
+  std::unique_ptr<utils::ThreadPool> m_threadPool;
+
+  // Geometry the bands were made for
+  int m_width{0};
+  int m_height{0};
+  int m_format{-1};
+
+  std::vector<int> m_planeWidths;
+  std::vector<int> m_planeHeights;
+  std::vector<Band> m_bands;
+
+  mutable std::mutex m_mutex;
+  int64_t m_frameCount{0};
+  std::vector<double> m_planeMseSum;
+  std::vector<double> m_planeSsimSum;
+  double m_mseSum{0.0};
+  double m_ssimSum{0.0};
+  double m_minPsnr{0.0};
+  double m_minSsim{1.0};
+};
+}; // namespace analysis
+}; // namespace libffmpegxx
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+
+// Kernels built with per-function target attributes and picked at runtime
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ANALYSIS_X86 1
+#else
+#define ANALYSIS_X86 0
+#endif
+
+// NEON is part of every AArch64 CPU and of the armv7 builds enabling it
+#if defined(__ARM_NEON)
+#define ANALYSIS_NEON 1
+#else
+#define ANALYSIS_NEON 0
+#endif
+
+namespace libffmpegxx {
+namespace analysis {
+namespace kernels {
+/**
+ * @brief Width and height of the blocks SAD is reported for.
+ */
+constexpr int BLOCK_SIZE = 16;
+
+/**
+ * @brief The KernelSet struct holds the row kernels of an instruction set.
+ *
+ * Rows are 8 bit samples with no alignment requirement.
+ */
+struct KernelSet {
+  /**
+   * @brief Instruction set name, for logging.
+   */
+  char const *name;
+
+  /**
+   * @brief Adds the sum and the sum of squares of a row.
+   */
+  void (*sumRow)(uint8_t const *row, int width, uint64_t *sum,
+                 uint64_t *sumSq);
+
+  /**
+   * @brief Adds the SAD of each BLOCK_SIZE wide segment of two rows to
+   * blocks[x / BLOCK_SIZE].
+   * @return the SAD of the whole row.
+   */
+  uint64_t (*sadRow)(uint8_t const *a, uint8_t const *b, int width,
+                     uint32_t *blocks);
+
+  /**
+   * @return the sum of squared differences of two rows.
+   */
+  uint64_t (*sseRow)(uint8_t const *a, uint8_t const *b, int width);
+
+  /**
+   * @brief Computes the SSIM sums of a row of 4x4 blocks: sum of a, sum of
+   * b, sum of a^2 + b^2 and sum of a * b.
+   * @param blocks Amount of blocks, the first 4 * blocks columns.
+   */
+  void (*ssimRow)(uint8_t const *a, int aLineSize, uint8_t const *b,
+                  int bLineSize, int blocks, int32_t (*sums)[4]);
+
+  /**
+   * @brief Adds each sample of a row to its column sum: sums[x] += row[x].
+   */
+  void (*accumulateRow)(uint8_t const *row, int width, uint32_t *sums);
+};
+
+/**
+ * @return the fastest kernels the CPU supports. Detected once.
+ */
+KernelSet const &getKernels();
+
+/**
+ * @brief Adds the histogram of a plane to hist (256 bins).
+ */
+void histogramPlane(uint8_t const *data, int lineSize, int width, int height,
+                    uint32_t *hist);
+
+KernelSet const &getScalarKernels();
+#if ANALYSIS_X86
+KernelSet const &getSse2Kernels();
+KernelSet const &getAvx2Kernels();
+#endif
+#if ANALYSIS_NEON
+KernelSet const &getNeonKernels();
+#endif
+}; // namespace kernels
+}; // namespace analysis
+}; // namespace libffmpegxx
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "avcodec/AVPacketImpl.h"
+#include "utils/RecyclingPool.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace libffmpegxx {
+namespace avcodec {
+/**
+ * @brief The AVPacketPool class recycles packet wrappers.
+ *
+ * Acquired packets are handed out as shared pointers. When the last reference
+ * is dropped the packet data is unreferenced and the wrapper goes back to the
+ * pool. Packets may outlive the pool; they are then simply freed.
+ */
+class AVPacketPool {
+public:
+  /**
+   * @brief AVPacketPool constructor.
+   * @param maxIdle Maximum amount of idle packets kept for reuse.
+   */
+  explicit AVPacketPool(size_t maxIdle = 32);
+
+  /**
+   * @return an empty packet.
+   */
+  std::shared_ptr<AVPacketImpl> acquire();
+
+  /**
+   * @return the amount of idle packets ready for reuse.
+   */
+  size_t getIdleCount() const;
+
+private:
+  utils::RecyclingPool<AVPacketImpl> m_pool;
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
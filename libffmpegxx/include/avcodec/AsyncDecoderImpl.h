@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../public/avcodec/IAsyncDecoder.h"
+#include "avcodec/AVPacketImpl.h"
+#include "utils/LatencyStats.h"
+#include "utils/SpscQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace libffmpegxx {
+namespace avcodec {
+class AsyncDecoderImpl : public IAsyncDecoder {
+public:
+  AsyncDecoderImpl(IDecoder *decoder, size_t inputCapacity,
+                   size_t outputCapacity);
+  ~AsyncDecoderImpl() override;
+
+  bool push(IAVPacket const *packet) override;
+  void flush() override;
+  bool pop(std::shared_ptr<avutil::IAVFrame> &frame) override;
+  bool tryPop(std::shared_ptr<avutil::IAVFrame> &frame) override;
+  int getError() const override;
+  AsyncDecoderStatistics getStatistics() const override;
+
+private:
+  /**
+   * @brief A queued packet. A null packet requests flushing.
+   */
+  struct PacketItem {
+    std::unique_ptr<AVPacketImpl> packet;
+    utils::LatencyStats::Clock::time_point queued;
+  };
+
+  struct FrameItem {
+    std::shared_ptr<avutil::IAVFrame> frame;
+    utils::LatencyStats::Clock::time_point queued;
+  };
+
+  void run();
+
+  IDecoder *m_decoder{nullptr};
+  utils::SpscQueue<PacketItem> m_input;
+  utils::SpscQueue<FrameItem> m_output;
+  std::thread m_thread;
+
+  std::atomic<int> m_error{0};
+  std::atomic<int64_t> m_packets{0};
+  std::atomic<int64_t> m_frames{0};
+  utils::LatencyStats m_inputLatency;
+  utils::LatencyStats m_decodeLatency;
+  utils::LatencyStats m_outputLatency;
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
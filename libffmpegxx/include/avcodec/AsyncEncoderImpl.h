@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../public/avcodec/IAsyncEncoder.h"
+#include "avutil/AVFrameImpl.h"
+#include "utils/LatencyStats.h"
+#include "utils/SpscQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace libffmpegxx {
+namespace avcodec {
+class AsyncEncoderImpl : public IAsyncEncoder {
+public:
+  AsyncEncoderImpl(IEncoder *encoder, PacketSink const &sink,
+                   size_t inputCapacity, size_t outputCapacity);
+  ~AsyncEncoderImpl() override;
+
+  bool push(avutil::IAVFrame const *frame) override;
+  bool tryPush(avutil::IAVFrame const *frame) override;
+  void flush() override;
+  int wait() override;
+  bool pop(std::shared_ptr<IAVPacket> &packet) override;
+  bool tryPop(std::shared_ptr<IAVPacket> &packet) override;
+  int getError() const override;
+  AsyncEncoderStatistics getStatistics() const override;
+
+private:
+  /**
+   * @brief A queued frame. A null frame requests flushing.
+   */
+  struct FrameItem {
+    std::unique_ptr<avutil::AVFrameImpl> frame;
+    utils::LatencyStats::Clock::time_point queued;
+  };
+
+  struct PacketItem {
+    std::shared_ptr<IAVPacket> packet;
+    utils::LatencyStats::Clock::time_point queued;
+  };
+
+  FrameItem toItem(avutil::IAVFrame const *frame) const;
+  void run();
+
+  IEncoder *m_encoder{nullptr};
+  PacketSink m_sink;
+  utils::SpscQueue<FrameItem> m_input;
+  utils::SpscQueue<PacketItem> m_output;
+  std::thread m_thread;
+
+  std::atomic<int> m_error{0};
+  std::atomic<int64_t> m_frames{0};
+  std::atomic<int64_t> m_packets{0};
+  utils::LatencyStats m_inputLatency;
+  utils::LatencyStats m_encodeLatency;
+  utils::LatencyStats m_outputLatency;
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
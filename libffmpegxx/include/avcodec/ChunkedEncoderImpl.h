@@ -0,0 +1,81 @@
+#pragma once
+
+#include "../public/avcodec/IChunkedEncoder.h"
+#include "avcodec/SegmentDecoder.h"
+#include "avformat/KeyframeIndex.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace libffmpegxx {
+namespace swscale {
+class ScalerImpl;
+};
+
+namespace avcodec {
+class ChunkedEncoderImpl : public IChunkedEncoder {
+public:
+  ChunkedEncoderImpl(std::string const &uri, int streamIdx,
+                     ChunkedEncodeConfig const &config);
+  ~ChunkedEncoderImpl() override;
+
+  avformat::StreamInfo getStreamInfo() const override;
+  int encode(PacketSink const &sink) override;
+  void stop() override;
+
+private:
+  using Packets = std::vector<std::shared_ptr<IAVPacket>>;
+
+  struct Chunk {
+    SegmentRange range;
+
+    Packets packets;
+    bool done{false};
+  };
+
+  void buildChunks(avformat::KeyframeIndex const &index);
+  void work();
+  int encodeChunk(SegmentDecoder &decoder, swscale::ScalerImpl *scaler,
+                  Chunk const &chunk, Packets &packets);
+  /**
+   * @brief Rebuilds the DTS of a chunk so they follow the previous chunk
+   * ones, and hands its packets to the sink.
+   * @return FFmpeg API error code. AVERROR_INVALIDDATA if the chunk comes
+   * after the first one and some packets lack timestamps.
+   */
+  int deliver(size_t idx, Packets const &packets, PacketSink const &sink);
+  void fail(int error);
+
+  std::string m_uri;
+  int m_streamIdx;
+  ChunkedEncodeConfig m_config;
+
+  /**
+   * @brief The encoder input: size and pixel format of the frames.
+   */
+  avformat::StreamInfo m_encoderInput;
+  utils::AVOptions m_encoderOptions;
+  /**
+   * @brief The encoder output.
+   */
+  avformat::StreamInfo m_streamInfo;
+
+  std::vector<Chunk> m_chunks;
+  std::atomic<size_t> m_nextChunk{0};
+  size_t m_delivered{0};
+  size_t m_window{0};
+  /**
+   * @brief PTS to DTS offset of the chunk encoders, in the encoder timebase.
+   */
+  int64_t m_encoderDelay{0};
+  int m_error{0};
+  std::atomic<bool> m_stopRequested{false};
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
@@ -1,21 +1,67 @@
 #pragma once
 
 #include "../public/avcodec/IDecoder.h"
+#include "avutil/AVFramePool.h"
 
 namespace libffmpegxx {
 namespace avcodec {
 class DecoderImpl : public IDecoder {
 public:
-  explicit DecoderImpl(avformat::StreamInfo const &streamInfo);
+  explicit DecoderImpl(avformat::StreamInfo const &streamInfo,
+                       utils::AVOptions const &options = {},
+                       ThreadingPolicy const &threading = {},
+                       DecodeMode const &mode = {});
 
   ~DecoderImpl();
 
   int decode(IAVPacket *packet, avutil::IAVFrame *frame) override;
+  int decode(IAVPacket *packet, FrameSink const &sink) override;
   int flush(std::vector<avutil::IAVFrame *> &flushedFrames) override;
+  void reset() override;
+  ThreadingPolicy getThreading() const override;
+  void setDecodeMode(DecodeMode const &mode) override;
+  DecodeMode getDecodeMode() const override;
+
+  /**
+   * @brief Sets the timebase of the decoded frames (i.e. when a pooled
+   * decoder is reused for another stream).
+   */
+  void setTimebase(time::Timebase const &tb);
 
 private:
+  /**
+   * @return a new opened codec context.
+   * @throws if it cannot be opened.
+   */
+  AVCodecContext *openContext(int lowres) const;
+
+  /**
+   * @return the lowres closest to a requested one the decoder supports.
+   */
+  int getSupportedLowres(int lowres) const;
+
+  void applyDecodeMode();
+  /**
+   * @brief Receives frames until the decoder asks for more input.
+   * @param received Incremented per received frame.
+   * @return the error code that ended the loop (AVERROR(EAGAIN) when the
+   * decoder needs more input).
+   */
+  int receiveFrames(FrameSink const &sink, int &received);
+
   AVCodecContext *m_codecCtx{nullptr};
+  AVCodec const *m_codec{nullptr};
+  AVCodecPar m_codecPar;
   time::Timebase m_tb;
+  utils::AVOptions m_options;
+  ThreadingPolicy m_requestedThreading;
+  ThreadingPolicy m_threading;
+  DecodeMode m_mode;
+  /**
+   * @brief Lowres last requested, before clamping to the supported ones.
+   */
+  int m_requestedLowres;
+  avutil::AVFramePool m_framePool;
 };
 }; // namespace avcodec
 }; // namespace libffmpegxx
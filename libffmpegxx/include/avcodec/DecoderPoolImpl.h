@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../public/avcodec/IDecoderPool.h"
+#include "utils/RecyclingPool.h"
+
+#include <tuple>
+
+namespace libffmpegxx {
+namespace avcodec {
+class DecoderImpl;
+
+class DecoderPoolImpl : public IDecoderPool {
+public:
+  explicit DecoderPoolImpl(DecoderPoolConfig const &config);
+
+  std::shared_ptr<IDecoder>
+  acquire(avformat::StreamInfo const &streamInfo) override;
+  void evict() override;
+  void clear() override;
+  DecoderPoolStatistics getStatistics() const override;
+
+private:
+  /**
+   * @brief Parameters a decoder context depends on: codec id, extradata
+   * hash, width, height, format, sample rate and channels.
+   */
+  using Key = std::tuple<int, uint64_t, int, int, int, int, int>;
+
+  static Key buildKey(avformat::StreamInfo const &streamInfo);
+
+  DecoderPoolConfig m_config;
+  utils::RecyclingPool<DecoderImpl, Key> m_pool;
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
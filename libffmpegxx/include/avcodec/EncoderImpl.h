@@ -1,23 +1,67 @@
 #pragma once
 
 #include "../public/avcodec/IEncoder.h"
+#include "avcodec/AVPacketPool.h"
 
 namespace libffmpegxx {
+namespace avutil {
+class AVFrameImpl;
+}
 namespace avcodec {
 class EncoderImpl : public IEncoder {
 public:
-  explicit EncoderImpl(avformat::StreamInfo const &streamInfo);
+  explicit EncoderImpl(avformat::StreamInfo const &streamInfo,
+                       EncoderSettings const &settings = {},
+                       utils::AVOptions const &options = {});
 
   ~EncoderImpl();
 
   int encode(avutil::IAVFrame *frame, IAVPacket *packet) override;
 
+  int encode(avutil::IAVFrame *frame, PacketSink const &sink) override;
+
   int flush(std::vector<avcodec::IAVPacket *> &flushedPackets) override;
 
+  utils::AVOptions getRejectedOptions() const override;
+
+  ThreadingPolicy getThreading() const override;
+
+  time::Timebase getTimebase() const override;
+
+  avformat::StreamInfo getStreamInfo() const override;
+
 private:
+  /**
+   * @brief Sends a frame to the encoder, with its timestamp converted to the
+   * encoder timebase.
+   * @param frame The frame to send or nullptr to flush.
+   * @return FFmpeg API error code.
+   */
+  int sendFrame(avutil::AVFrameImpl *frame);
+
+  /**
+   * @brief Hands every packet the encoder has ready to the sink.
+   * @param sink The packet sink.
+   * @param received Incremented once per packet handed to the sink.
+   * @return the error code that stopped the receiving loop.
+   */
+  int receivePackets(PacketSink const &sink, int &received);
+
+  void applySettings(avformat::StreamInfo const &streamInfo,
+                     EncoderSettings const &settings);
+
   AVCodecContext *m_codecCtx{nullptr};
+  /**
+   * @brief References input frames whose timestamp has to be rescaled, so
+   * frames shared with other encoders are never modified.
+   */
+  AVFrame *m_rescaledFrame{nullptr};
+  avformat::StreamInfo m_streamInfo;
   time::Timebase m_tb;
   avformat::StreamType m_type;
+  utils::AVOptions m_rejectedOptions;
+  ThreadingPolicy m_threading;
+  AVPacketPool m_packetPool;
 };
 }; // namespace avcodec
 }; // namespace libffmpegxx
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../public/avcodec/IParallelDecoder.h"
+#include "avcodec/SegmentDecoder.h"
+#include "avformat/KeyframeIndex.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace libffmpegxx {
+namespace avcodec {
+class ParallelDecoderImpl : public IParallelDecoder {
+public:
+  ParallelDecoderImpl(std::string const &uri, int streamIdx,
+                      ParallelDecodeConfig const &config);
+  ~ParallelDecoderImpl() override;
+
+  int decode(FrameSink const &sink) override;
+  void stop() override;
+
+private:
+  using Frames = std::vector<std::shared_ptr<avutil::IAVFrame>>;
+
+  struct Segment {
+    SegmentRange range;
+
+    Frames frames;
+    bool done{false};
+  };
+
+  void buildSegments(avformat::KeyframeIndex const &index);
+  void work();
+  void fail(int error);
+
+  std::string m_uri;
+  int m_streamIdx;
+  ParallelDecodeConfig m_config;
+
+  std::vector<Segment> m_segments;
+  std::atomic<size_t> m_nextSegment{0};
+  size_t m_delivered{0};
+  size_t m_window{0};
+  int m_error{0};
+  std::atomic<bool> m_stopRequested{false};
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../public/avcodec/ISeekingDecoder.h"
+#include "../public/time/Timebase.h"
+
+#include <cstdint>
+
+extern "C" {
+#include <libavutil/avutil.h>
+}
+
+namespace libffmpegxx {
+namespace avcodec {
+class DecoderImpl;
+
+class SeekingDecoderImpl : public ISeekingDecoder {
+public:
+  SeekingDecoderImpl(avformat::IDemuxer *demuxer, int streamIdx,
+                     utils::AVOptions const &options,
+                     ThreadingPolicy const &threading);
+  ~SeekingDecoderImpl() override;
+
+  std::shared_ptr<avutil::IAVFrame>
+  decodeAt(time::Timestamp const &ts) override;
+
+private:
+  /**
+   * @brief Seeks to the keyframe before a time and decodes up to a target.
+   * @param best Set to the frame displayed at the target, if decoded.
+   * @param first Set to the first frame decoded if presented after the
+   * target.
+   * @param keyframeDts Set to the DTS of the first packet read.
+   */
+  void decodeFrom(int64_t seekTs, int64_t target,
+                  std::shared_ptr<avutil::IAVFrame> &best,
+                  std::shared_ptr<avutil::IAVFrame> &first,
+                  int64_t &keyframeDts);
+
+  avformat::IDemuxer *m_demuxer{nullptr};
+  int m_streamIdx;
+  time::Timebase m_tb;
+  std::unique_ptr<DecoderImpl> m_decoder;
+
+  /**
+   * @brief Frame duration from the average framerate. 0 if unknown.
+   */
+  int64_t m_frameDuration{0};
+
+  /**
+   * @brief Last fetched frame, returned again for repeated requests.
+   */
+  std::shared_ptr<avutil::IAVFrame> m_lastFrame;
+  int64_t m_lastTarget{AV_NOPTS_VALUE};
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../public/avcodec/DecodeMode.h"
+#include "../public/avcodec/IDecoder.h"
+#include "../public/avcodec/ThreadingPolicy.h"
+#include "../public/avformat/MediaInfo.h"
+#include "avformat/KeyframeIndex.h"
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace libffmpegxx {
+namespace avformat {
+class DemuxerImpl;
+};
+
+namespace avcodec {
+class DecoderImpl;
+
+/**
+ * @brief The SegmentRange struct delimits a range of GOPs. Frames presented
+ * from its first keyframe up to (not including) the end keyframe belong to
+ * it.
+ */
+struct SegmentRange {
+  avformat::KeyframePosition start;
+  std::optional<avformat::KeyframePosition> end;
+  /**
+   * @brief Whether this is the first segment of the stream, which also gets
+   * the frames presented before its keyframe.
+   */
+  bool first{false};
+};
+
+/**
+ * @brief The SegmentDecoder class decodes segments of a stream with its own
+ * demuxer and decoder, so several ones can work on the same input at once.
+ */
+class SegmentDecoder {
+public:
+  /**
+   * @brief Opens the input and the decoder. Other streams are discarded.
+   * @param uri The input URI.
+   * @param streamIdx The stream to decode.
+   * @param demuxerOptions Demuxer open options.
+   * @param decoderOptions Decoder options.
+   * @param threading Decoder threading policy.
+   * @param mode Decoding mode.
+   * @throws if the input cannot be opened or the stream does not exist.
+   */
+  SegmentDecoder(std::string const &uri, int streamIdx,
+                 utils::AVOptions const &demuxerOptions,
+                 utils::AVOptions const &decoderOptions,
+                 ThreadingPolicy const &threading,
+                 DecodeMode const &mode = {});
+  ~SegmentDecoder();
+
+  /**
+   * @return the info of the decoded stream.
+   */
+  avformat::StreamInfo const &getStreamInfo() const;
+
+  /**
+   * @brief Decodes the frames presented within a segment. Open GOPs are
+   * handled by decoding the leading pictures of the end keyframe.
+   * @param segment The segment to decode.
+   * @param sink Called for every frame of the segment, in output order.
+   * @param stopRequested Decoding stops early when set.
+   * @return FFmpeg API error code. 0 if the whole segment was decoded.
+   */
+  int decode(SegmentRange const &segment, FrameSink const &sink,
+             std::atomic<bool> const &stopRequested);
+
+private:
+  int m_streamIdx;
+  avformat::StreamInfo m_streamInfo;
+  std::unique_ptr<avformat::DemuxerImpl> m_demuxer;
+  std::unique_ptr<DecoderImpl> m_decoder;
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "../public/avfilter/IFilterGraph.h"
+#include "utils/RecyclingPool.h"
+#include "utils/ThreadPool.h"
+
+#include <cstdint>
+#include <memory>
+#include <tuple>
+
+extern "C" {
+#include <libavfilter/avfilter.h>
+}
+
+namespace libffmpegxx {
+namespace avutil {
+class AVFrameImpl;
+}
+
+namespace avfilter {
+/**
+ * @brief The ConfiguredGraph struct holds a libavfilter graph configured for
+ * some input parameters.
+ */
+struct ConfiguredGraph {
+  ConfiguredGraph() = default;
+  ~ConfiguredGraph();
+
+  ConfiguredGraph(ConfiguredGraph const &) = delete;
+  ConfiguredGraph &operator=(ConfiguredGraph const &) = delete;
+
+  AVFilterGraph *graph{nullptr};
+  AVFilterContext *source{nullptr};
+  AVFilterContext *sink{nullptr};
+
+  /**
+   * @brief false once ended or failed.
+   */
+  bool reusable{true};
+};
+
+/**
+ * @brief The FilterGraphCache class configures the graphs of a filter chain
+ * and keeps the released ones which can be reused. It is shared by the
+ * filter graphs of a pool.
+ */
+class FilterGraphCache {
+public:
+  /**
+   * @brief Media type, format, width, height, sample aspect ratio, sample
+   * rate, channel layout and timebase of the input frames.
+   */
+  using Key = std::tuple<int, int, int, int, int, int, int, uint64_t, int,
+                         int>;
+
+  explicit FilterGraphCache(FilterGraphConfig const &config);
+
+  static Key getKey(avutil::AVFrameImpl *frame);
+
+  /**
+   * @brief Gets a graph for some input parameters, configuring it if none is
+   * idle.
+   * @return the graph. It returns to the cache once released if reusable.
+   */
+  std::shared_ptr<ConfiguredGraph> get(Key const &key);
+
+  void clear();
+  size_t getIdleCount() const;
+
+  FilterGraphConfig const &getConfig() const;
+
+private:
+  std::unique_ptr<ConfiguredGraph> createGraph(Key const &key) const;
+
+  /**
+   * @brief AVFilterGraph::execute callback running the slices of a filter
+   * on the thread pool.
+   */
+  static int executeSlices(AVFilterContext *ctx, avfilter_action_func *func,
+                           void *arg, int *ret, int jobs);
+
+  FilterGraphConfig m_config;
+  size_t m_threads{1};
+
+  // Declared before the graphs, which reference it
+  std::unique_ptr<utils::ThreadPool> m_threadPool;
+  utils::RecyclingPool<ConfiguredGraph, Key> m_graphs;
+};
+}; // namespace avfilter
+}; // namespace libffmpegxx
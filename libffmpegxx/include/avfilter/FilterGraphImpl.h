@@ -0,0 +1,46 @@
+#pragma once
+
+#include "../public/avfilter/IFilterGraph.h"
+#include "avfilter/FilterGraphCache.h"
+#include "avutil/AVFramePool.h"
+
+#include <memory>
+#include <optional>
+
+namespace libffmpegxx {
+namespace avfilter {
+class FilterGraphImpl : public IFilterGraph {
+public:
+  explicit FilterGraphImpl(std::shared_ptr<FilterGraphCache> cache);
+
+  FilterGraphImpl(FilterGraphImpl const &) = delete;
+  FilterGraphImpl &operator=(FilterGraphImpl const &) = delete;
+
+  int filter(avutil::IAVFrame *frame,
+             avcodec::FrameSink const &sink) override;
+  time::Timebase getTimebase() const override;
+
+private:
+  /**
+   * @brief Hands every frame the graph outputs to the sink.
+   */
+  void drain(ConfiguredGraph &graph, avcodec::FrameSink const &sink);
+
+  /**
+   * @brief Hands the remaining frames of the current graph to the sink and
+   * releases it. Stateless graphs are only drained, others are sent the end
+   * of the input.
+   */
+  void flush(avcodec::FrameSink const &sink);
+
+  std::shared_ptr<FilterGraphCache> m_cache;
+
+  std::shared_ptr<ConfiguredGraph> m_graph;
+  FilterGraphCache::Key m_key;
+
+  std::optional<time::Timebase> m_timebase;
+
+  avutil::AVFramePool m_framePool;
+};
+}; // namespace avfilter
+}; // namespace libffmpegxx
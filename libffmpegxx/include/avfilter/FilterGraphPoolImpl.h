@@ -0,0 +1,22 @@
+#pragma once
+
+#include "../public/avfilter/IFilterGraphPool.h"
+#include "avfilter/FilterGraphCache.h"
+
+#include <memory>
+
+namespace libffmpegxx {
+namespace avfilter {
+class FilterGraphPoolImpl : public IFilterGraphPool {
+public:
+  explicit FilterGraphPoolImpl(FilterGraphConfig const &config);
+
+  std::shared_ptr<IFilterGraph> acquire() override;
+  void clear() override;
+  size_t getIdleCount() const override;
+
+private:
+  std::shared_ptr<FilterGraphCache> m_cache;
+};
+}; // namespace avfilter
+}; // namespace libffmpegxx
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../public/avformat/IAbrLadder.h"
+#include "../public/avformat/MediaInfo.h"
+#include "utils/SpscQueue.h"
+#include "utils/Stopwatch.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace libffmpegxx {
+namespace avcodec {
+class DecoderImpl;
+class EncoderImpl;
+class IAVPacket;
+}; // namespace avcodec
+
+namespace avutil {
+class AVFrameImpl;
+}; // namespace avutil
+
+namespace swscale {
+class ScalerImpl;
+}; // namespace swscale
+
+namespace avformat {
+class MuxerImpl;
+
+class AbrLadderImpl : public IAbrLadder {
+public:
+  AbrLadderImpl(IDemuxer *demuxer, int streamIdx,
+                AbrLadderConfig const &config);
+  ~AbrLadderImpl() override;
+
+  void start(utils::AVOptions const &options = {}) override;
+  void stop() override;
+  int wait() override;
+  bool isRunning() const override;
+  AbrLadderStatistics getStatistics() const override;
+
+private:
+  using FrameQueue = utils::SpscQueue<std::shared_ptr<avutil::AVFrameImpl>>;
+
+  struct ScaledSize {
+    int width;
+    int height;
+    AVPixelFormat format;
+  };
+
+  /**
+   * @brief An encoder fed by the decoding thread through a bounded queue and
+   * writing to its own muxer.
+   */
+  struct Output {
+    std::unique_ptr<avcodec::EncoderImpl> encoder;
+    std::unique_ptr<MuxerImpl> muxer;
+    /**
+     * @brief Index of the scaled size feeding this output. -1 for the
+     * decoded frames themselves.
+     */
+    int sizeIdx{-1};
+
+    std::unique_ptr<FrameQueue> queue;
+    std::thread thread;
+    int result{0};
+
+    std::atomic<int64_t> frames{0};
+    std::atomic<int64_t> packets{0};
+    std::atomic<int64_t> bytes{0};
+  };
+
+  void addOutput(Rendition const &rendition);
+  void encode(Output &output);
+  void run();
+  int decode(avcodec::IAVPacket *packet);
+  void closeQueues();
+
+  IDemuxer *m_demuxer;
+  int m_streamIdx;
+  StreamInfo m_streamInfo;
+  int m_keyframeInterval;
+  size_t m_queueCapacity;
+
+  std::unique_ptr<avcodec::DecoderImpl> m_decoder;
+  std::unique_ptr<swscale::ScalerImpl> m_scaler;
+  std::vector<ScaledSize> m_sizes;
+  std::vector<std::unique_ptr<Output>> m_outputs;
+
+  std::thread m_thread;
+  std::atomic<bool> m_stopRequested{false};
+  int m_result{0};
+
+  std::atomic<int64_t> m_decodedFrames{0};
+  utils::Stopwatch m_stopwatch;
+};
+}; // namespace avformat
+}; // namespace libffmpegxx
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "../public/avformat/ICompositor.h"
+#include "utils/SpscQueue.h"
+#include "utils/Stopwatch.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <thread>
+
+namespace libffmpegxx {
+namespace avcodec {
+class AVPacketImpl;
+};
+
+namespace avformat {
+class MuxerImpl;
+
+class CompositorImpl : public ICompositor {
+public:
+  CompositorImpl(std::vector<StreamSource> const &sources,
+                 std::string const &uri, std::string const &format,
+                 size_t queueCapacity);
+  ~CompositorImpl() override;
+
+  void start(utils::AVOptions const &options = {}) override;
+  void stop() override;
+  int wait() override;
+  bool isRunning() const override;
+  RemuxStatistics getStatistics() const override;
+  MediaInfo getMediaInfo() const override;
+
+private:
+  using PacketQueue = utils::SpscQueue<avcodec::AVPacketImpl *>;
+
+  /**
+   * @brief A demuxer read ahead by its own thread. Packets travel to the
+   * muxing thread through the filled queue and come back through the
+   * recycled one, so memory is bounded by the queue capacity.
+   */
+  struct Input {
+    IDemuxer *demuxer{nullptr};
+    /**
+     * @brief Input stream index to output stream index.
+     */
+    std::map<int, int> outputIndexes;
+
+    std::vector<std::unique_ptr<avcodec::AVPacketImpl>> packets;
+    std::unique_ptr<PacketQueue> filled;
+    std::unique_ptr<PacketQueue> recycled;
+    avcodec::AVPacketImpl *head{nullptr};
+
+    std::thread thread;
+    int result{0};
+  };
+
+  void readInput(Input &input);
+  void run();
+  void closeQueues();
+
+  std::vector<std::unique_ptr<Input>> m_inputs;
+  std::unique_ptr<MuxerImpl> m_muxer;
+  size_t m_queueCapacity;
+
+  std::thread m_thread;
+  std::atomic<bool> m_stopRequested{false};
+  int m_result{0};
+
+  std::atomic<int64_t> m_packets{0};
+  std::atomic<int64_t> m_bytes{0};
+  utils::Stopwatch m_stopwatch;
+};
+}; // namespace avformat
+}; // namespace libffmpegxx
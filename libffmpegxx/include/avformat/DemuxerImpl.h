@@ -6,6 +6,7 @@
 
 #include <mutex>
 #include <string>
+#include <vector>
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -25,12 +26,17 @@ public:
   void close() override;
   int read(avcodec::IAVPacket *packet) override;
   MediaInfo getMediaInfo() const override;
+  void setDiscard(int streamIdx, AVDiscard discard) override;
+  int seek(int streamIdx, time::Timestamp const &ts) override;
 
 private:
   avformat::StreamType getStreamType(int streamIdx) const;
+  bool isDiscarded(AVPacket const *packet) const;
 
   std::string m_uri;
   AVFormatContext *m_formatContext{nullptr};
+  std::vector<StreamType> m_streamTypes;
+  std::vector<AVDiscard> m_discard;
 
   std::mutex m_ioMutex;
 };
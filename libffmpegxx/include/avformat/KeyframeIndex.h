@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../public/time/Timebase.h"
+#include "../public/utils/AVOptions.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace libffmpegxx {
+namespace avformat {
+/**
+ * @brief The KeyframePosition struct locates a keyframe within its stream.
+ */
+struct KeyframePosition {
+  int64_t pts;
+  int64_t dts;
+
+  /**
+   * @return the timestamp packets are read in order of: DTS, or PTS if DTS
+   * is unknown.
+   */
+  int64_t getDecodeOrderTs() const;
+};
+
+/**
+ * @brief The KeyframeIndex class lists the keyframes of a stream.
+ *
+ * The input is read with every non-key packet discarded, which is pure I/O
+ * and works for any container, indexed or not.
+ */
+class KeyframeIndex {
+public:
+  /**
+   * @brief Scans the keyframes of a stream.
+   * @param uri The input URI. A dedicated demuxer is opened for the scan.
+   * @param streamIdx The stream to scan.
+   * @param options Demuxer open options.
+   * @throws if the input cannot be opened or the stream does not exist.
+   */
+  KeyframeIndex(std::string const &uri, int streamIdx,
+                utils::AVOptions const &options = {});
+
+  /**
+   * @return the keyframes in decoding order.
+   */
+  std::vector<KeyframePosition> const &getKeyframes() const;
+
+  /**
+   * @return the timebase of the keyframe timestamps.
+   */
+  time::Timebase const &getTimebase() const;
+
+private:
+  std::vector<KeyframePosition> m_keyframes;
+  time::Timebase m_tb;
+};
+}; // namespace avformat
+}; // namespace libffmpegxx
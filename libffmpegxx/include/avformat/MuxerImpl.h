@@ -2,25 +2,81 @@
 
 #include "public/avformat/IMuxer.h"
 
+#include "time/TimestampRescaler.h"
+
 #include <mutex>
+#include <optional>
+#include <vector>
 
 extern "C" {
 #include <libavformat/avformat.h>
 }
 
 namespace libffmpegxx {
+namespace avcodec {
+class AVPacketImpl;
+};
+
 namespace avformat {
 class MuxerImpl : public IMuxer {
 public:
-  explicit MuxerImpl(MediaInfo const &mediaInfo);
+  explicit MuxerImpl(MediaInfo const &mediaInfo, IOutputSink *sink = nullptr);
+  MuxerImpl(MediaInfo const &mediaInfo,
+            FragmentationConfig const &fragmentation,
+            IOutputSink *sink = nullptr);
   ~MuxerImpl() override;
   void open(utils::AVOptions const &options = {}) override;
   void close() override;
   void write(avcodec::IAVPacket *packet) override;
+  void write(std::vector<avcodec::IAVPacket *> const &packets) override;
+
+  MediaInfo const &getMediaInfo() const;
+
+  /**
+   * @return the short name of the output format, even before opening.
+   */
+  std::string getFormatName() const;
+
+  /**
+   * @brief Replaces the codec parameters of an output stream. Only allowed
+   * before opening the muxer.
+   * @param streamIdx The stream index within the muxer MediaInfo.
+   * @param codecPar The new codec parameters.
+   * @throws if the muxer is already opened or the stream does not exist.
+   */
+  void setCodecParameters(int streamIdx, AVCodecParameters const *codecPar);
+
+  /**
+   * @return the timebase chosen by the muxer for an output stream.
+   * @throws if the muxer is not opened or the stream does not exist.
+   */
+  time::Timebase getStreamTimebase(int streamIdx) const;
 
 private:
+  avcodec::AVPacketImpl *toWritablePacket(avcodec::IAVPacket *packet);
+  time::TimestampRescaler const &getRescaler(int streamIdx,
+                                             time::Timebase const &tb);
+  void writeRescaled(avcodec::AVPacketImpl *packet);
+  void openSink();
+  void closeSink();
+  void setupFragmentation(AVDictionary **opts);
+  void onPacketWritten(AVPacket const *packet);
+  void flushFragment();
+
   AVFormatContext *m_formatContext{nullptr};
   MediaInfo m_mediaInfo;
+  IOutputSink *m_sink{nullptr};
+
+  std::vector<time::TimestampRescaler> m_rescalers;
+  std::vector<avcodec::AVPacketImpl *> m_batch;
+  std::vector<int64_t> m_batchTimestamps;
+
+  std::optional<FragmentationConfig> m_fragmentation;
+  int m_fragmentRefStream{0};
+  int m_fragmentIndex{0};
+  int64_t m_fragmentOffset{0};
+  double m_fragmentStart{-1.};
+  double m_fragmentEnd{-1.};
 
   std::mutex m_ioMutex;
 };
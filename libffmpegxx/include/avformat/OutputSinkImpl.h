@@ -0,0 +1,64 @@
+#pragma once
+
+#include "public/avformat/IOutputSink.h"
+
+#include <memory>
+
+namespace libffmpegxx {
+namespace avformat {
+class MemoryOutputSinkImpl : public IMemoryOutputSink {
+public:
+  explicit MemoryOutputSinkImpl(size_t initialCapacity);
+
+  int write(uint8_t const *data, int size) override;
+  int64_t seek(int64_t offset, int whence) override;
+  bool isSeekable() const override;
+
+  uint8_t const *getData() const override;
+  size_t getSize() const override;
+  int64_t getOffset() const override;
+  std::vector<uint8_t> release() override;
+
+private:
+  std::vector<uint8_t> m_buffer;
+  /**
+   * @brief Output offset of the first byte in the buffer.
+   */
+  int64_t m_base{0};
+  int64_t m_position{0};
+};
+
+class CallbackOutputSinkImpl : public IOutputSink {
+public:
+  CallbackOutputSinkImpl(OutputSinkFactory::WriteCallback const &write,
+                         OutputSinkFactory::SeekCallback const &seek);
+
+  int write(uint8_t const *data, int size) override;
+  int64_t seek(int64_t offset, int whence) override;
+  bool isSeekable() const override;
+
+private:
+  OutputSinkFactory::WriteCallback m_write;
+  OutputSinkFactory::SeekCallback m_seek;
+};
+
+class ChunkChainOutputSinkImpl : public IChunkChainOutputSink {
+public:
+  ChunkChainOutputSinkImpl(size_t chunkSize, size_t chunkCount);
+
+  int write(uint8_t const *data, int size) override;
+  int64_t seek(int64_t offset, int whence) override;
+  bool isSeekable() const override;
+
+  std::vector<OutputChunk> getChunks() const override;
+  size_t getSize() const override;
+  void reset() override;
+
+private:
+  size_t m_chunkSize;
+  std::vector<std::unique_ptr<uint8_t[]>> m_chunks;
+  int64_t m_size{0};
+  int64_t m_position{0};
+};
+}; // namespace avformat
+}; // namespace libffmpegxx
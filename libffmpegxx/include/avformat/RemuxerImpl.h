@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../public/avformat/IRemuxer.h"
+#include "../public/avformat/MediaInfo.h"
+#include "time/TimestampRescaler.h"
+#include "utils/Stopwatch.h"
+
+#include <atomic>
+#include <map>
+#include <thread>
+
+struct AVBSFContext;
+
+namespace libffmpegxx {
+namespace avcodec {
+class AVPacketImpl;
+};
+
+namespace avformat {
+class MuxerImpl;
+
+class RemuxerImpl : public IRemuxer {
+public:
+  RemuxerImpl(IDemuxer *demuxer, IMuxer *muxer);
+  ~RemuxerImpl() override;
+
+  void start(utils::AVOptions const &options = {}) override;
+  void stop() override;
+  int wait() override;
+  bool isRunning() const override;
+  RemuxStatistics getStatistics() const override;
+
+private:
+  /**
+   * @brief Per input stream remuxing plan, computed once before starting.
+   */
+  struct StreamPlan {
+    int outputIndex{0};
+    AVBSFContext *bsf{nullptr};
+    time::Timebase inputTb;
+    time::TimestampRescaler rescaler;
+  };
+
+  void buildPlans();
+  void freePlans();
+  void run();
+  int filterAndWrite(StreamPlan &plan, avcodec::AVPacketImpl *packet);
+  void writePacket(StreamPlan const &plan, avcodec::AVPacketImpl *packet);
+
+  IDemuxer *m_demuxer{nullptr};
+  MuxerImpl *m_muxer{nullptr};
+  std::map<int, StreamPlan> m_plans;
+
+  std::thread m_thread;
+  std::atomic<bool> m_stopRequested{false};
+  int m_result{0};
+
+  std::atomic<int64_t> m_packets{0};
+  std::atomic<int64_t> m_bytes{0};
+  utils::Stopwatch m_stopwatch;
+};
+}; // namespace avformat
+}; // namespace libffmpegxx
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../public/avformat/IThumbnailer.h"
+#include "../public/avformat/MediaInfo.h"
+#include "avcodec/DecoderPoolImpl.h"
+#include "avformat/DemuxerImpl.h"
+#include "swscale/ScalerImpl.h"
+#include "utils/ThreadPool.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace libffmpegxx {
+namespace avutil {
+class AVFrameImpl;
+}
+
+namespace avformat {
+class ThumbnailerImpl : public IThumbnailer {
+public:
+  ThumbnailerImpl(std::string const &uri, int streamIdx,
+                  ThumbnailerConfig const &config);
+  ~ThumbnailerImpl() override;
+
+  std::vector<Thumbnail> createThumbnails() override;
+  SpriteSheet createSpriteSheet() override;
+
+private:
+  /**
+   * @brief The Worker struct holds what a thread needs to extract
+   * thumbnails. Workers are handed out to one task at a time.
+   */
+  struct Worker {
+    std::unique_ptr<DemuxerImpl> demuxer;
+    std::unique_ptr<swscale::ScalerImpl> scaler;
+  };
+
+  /**
+   * @brief Runs task(0, worker) to task(count - 1, worker) on the thread
+   * pool, each with a worker of its own.
+   */
+  void runParallel(size_t count,
+                   std::function<void(size_t, Worker &)> const &task);
+
+  /**
+   * @brief Decodes and scales the keyframe at or before a time.
+   * @param frameTime Set to the time of the keyframe.
+   * @return the scaled keyframe, nullptr if none could be decoded.
+   */
+  std::shared_ptr<avutil::AVFrameImpl> extractAt(Worker &worker,
+                                                 time::Seconds const &time,
+                                                 time::Seconds &frameTime);
+
+  /**
+   * @return the evenly spaced times.
+   */
+  std::vector<time::Seconds> getTimes() const;
+
+  /**
+   * @return the image encoded.
+   */
+  std::vector<uint8_t> encodeImage(avutil::AVFrameImpl *frame) const;
+
+  /**
+   * @return an idle worker, or a new one with its demuxer opened.
+   */
+  std::unique_ptr<Worker> acquireWorker();
+  void releaseWorker(std::unique_ptr<Worker> worker);
+
+  std::string m_uri;
+  int m_streamIdx;
+  ThumbnailerConfig m_config;
+
+  StreamInfo m_streamInfo;
+  time::Seconds m_start{0.};
+  time::Seconds m_duration{0.};
+
+  AVCodec const *m_codec{nullptr};
+  int m_width{0};
+  int m_height{0};
+  AVPixelFormat m_format{AV_PIX_FMT_NONE};
+
+  std::unique_ptr<avcodec::DecoderPoolImpl> m_decoders;
+  std::unique_ptr<utils::ThreadPool> m_threadPool;
+  size_t m_threads;
+
+  std::mutex m_workersMutex;
+  std::vector<std::unique_ptr<Worker>> m_idleWorkers;
+};
+}; // namespace avformat
+}; // namespace libffmpegxx
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "avutil/AVFrameImpl.h"
+#include "utils/RecyclingPool.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace libffmpegxx {
+namespace avutil {
+/**
+ * @brief The AVFramePool class recycles frame wrappers.
+ *
+ * Acquired frames are handed out as shared pointers. When the last reference
+ * is dropped the frame data is unreferenced and the wrapper goes back to the
+ * pool, so steady state decoding does not allocate AVFrame structs. Frames
+ * may outlive the pool; they are then simply freed.
+ */
+class AVFramePool {
+public:
+  /**
+   * @brief AVFramePool constructor.
+   * @param maxIdle Maximum amount of idle frames kept for reuse.
+   */
+  explicit AVFramePool(size_t maxIdle = 32);
+
+  /**
+   * @return an empty frame.
+   */
+  std::shared_ptr<AVFrameImpl> acquire();
+
+  /**
+   * @return the amount of idle frames ready for reuse.
+   */
+  size_t getIdleCount() const;
+
+private:
+  utils::RecyclingPool<AVFrameImpl> m_pool;
+};
+}; // namespace avutil
+}; // namespace libffmpegxx
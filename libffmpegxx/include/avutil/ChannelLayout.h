@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/frame.h>
+#include <libavutil/version.h>
+}
+
+/**
+ * @brief Whether channel layouts are AVChannelLayout structs (FFmpeg 5.1 and
+ * later) instead of channel masks and counts, which FFmpeg 7 removed.
+ */
+#define AVUTIL_HAS_CH_LAYOUT                                                 \
+  (LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100))
+
+namespace libffmpegxx {
+namespace avutil {
+#if AVUTIL_HAS_CH_LAYOUT
+/**
+ * @return the mask of a layout, the default one for its channel count if
+ * not in native order. 0 if there is none.
+ */
+uint64_t getChannelMask(AVChannelLayout const &layout);
+#endif
+
+/**
+ * @return the channel mask of a frame or codec parameters, the default one
+ * for their channel count if unset. 0 if there is none.
+ */
+template <typename T> uint64_t getChannelMask(T const *owner) {
+#if AVUTIL_HAS_CH_LAYOUT
+  return getChannelMask(owner->ch_layout);
+#else
+  return owner->channel_layout
+             ? owner->channel_layout
+             : static_cast<uint64_t>(
+                   av_get_default_channel_layout(owner->channels));
+#endif
+}
+
+/**
+ * @return the channel count of a frame or codec parameters.
+ */
+template <typename T> int getChannelCount(T const *owner) {
+#if AVUTIL_HAS_CH_LAYOUT
+  return owner->ch_layout.nb_channels;
+#else
+  return owner->channels;
+#endif
+}
+
+/**
+ * @return the amount of channels of a mask.
+ */
+int getChannelCount(uint64_t mask);
+
+/**
+ * @return the channel (i.e. AV_CH_FRONT_LEFT) at an index of a mask. 0 if
+ * out of range.
+ */
+uint64_t getChannel(uint64_t mask, int index);
+
+/**
+ * @brief Sets the channel layout and count of a frame.
+ * @return FFmpeg API error code.
+ */
+int setChannelMask(AVFrame *frame, uint64_t mask);
+}; // namespace avutil
+}; // namespace libffmpegxx
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace libffmpegxx {
+namespace avutil {
+class IAVFrame;
+}
+
+namespace analysis {
+/**
+ * @brief The FrameAnalyzerConfig struct holds the frame analyzer settings.
+ */
+struct FrameAnalyzerConfig {
+  /**
+   * @brief Scene change score (0 to 100) from which a frame is reported as
+   * a scene change.
+   */
+  double sceneThreshold{10.0};
+};
+
+/**
+ * @brief The FrameAnalysis struct holds the luma statistics of a frame.
+ */
+struct FrameAnalysis {
+  /**
+   * @brief Luma histogram.
+   */
+  std::array<uint32_t, 256> histogram{};
+
+  /**
+   * @brief Luma mean.
+   */
+  double mean{0.0};
+
+  /**
+   * @brief Luma variance.
+   */
+  double variance{0.0};
+
+  /**
+   * @brief Whether the previous frame could be compared (there is one and
+   * it has the same size). The fields below are 0 otherwise.
+   */
+  bool hasPrevious{false};
+
+  /**
+   * @brief Sum of absolute luma differences with the previous frame of each
+   * 16x16 block, row by row. Blocks on the right and bottom edges may be
+   * smaller.
+   */
+  std::vector<uint32_t> blockSad;
+
+  /**
+   * @brief Amount of block columns in blockSad.
+   */
+  int blockColumns{0};
+
+  /**
+   * @brief Mean absolute luma difference with the previous frame, as a
+   * percentage of the sample range.
+   */
+  double meanAbsDiff{0.0};
+
+  /**
+   * @brief Scene change score, from 0 to 100. Computed like the FFmpeg scdet
+   * filter: the lowest of the mean absolute difference and its change since
+   * the previous frame, so steady motion does not score high.
+   */
+  double sceneScore{0.0};
+
+  /**
+   * @brief Whether the score reaches the configured threshold.
+   */
+  bool sceneChange{false};
+};
+
+/**
+ * @brief The IFrameAnalyzer class defines the API of a video frame analyzer.
+ *
+ * Analyzers compute luma statistics of consecutive frames of a stream, with
+ * the fastest kernels the CPU supports (AVX2, SSE2, NEON or plain C++). Only
+ * 8 bit formats with a planar luma (YUV and gray) are supported.
+ */
+class IFrameAnalyzer {
+public:
+  virtual ~IFrameAnalyzer() = default;
+
+  /**
+   * @brief Analyzes a frame, comparing it with the previous one.
+   * @param frame The frame to analyze. A reference to it is kept until the
+   * next call.
+   * @return the frame statistics.
+   * @throws if the frame format is not supported.
+   */
+  virtual FrameAnalysis analyze(avutil::IAVFrame *frame) = 0;
+
+  /**
+   * @brief Forgets the previous frame, as needed after seeking.
+   */
+  virtual void reset() = 0;
+
+  /**
+   * @return the name of the instruction set in use.
+   */
+  virtual std::string getKernelName() const = 0;
+};
+
+/**
+ * @brief The FrameAnalyzerFactory class creates frame analyzers.
+ */
+class FrameAnalyzerFactory {
+public:
+  /**
+   * @brief Creates a frame analyzer.
+   * @param config The analyzer settings.
+   * @return the new analyzer.
+   */
+  static IFrameAnalyzer *create(FrameAnalyzerConfig const &config = {});
+};
+}; // namespace analysis
+}; // namespace libffmpegxx
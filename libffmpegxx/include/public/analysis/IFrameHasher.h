@@ -0,0 +1,127 @@
+#pragma once
+
+#include "../time/time_defs.h"
+
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+namespace libffmpegxx {
+namespace avutil {
+class IAVFrame;
+}
+
+namespace analysis {
+/**
+ * @brief Perceptual hash of a frame. Similar pictures have hashes with few
+ * differing bits.
+ */
+using FrameHash = uint64_t;
+
+/**
+ * @return the amount of bits two hashes differ in, from 0 (same picture) to
+ * 64. Re-encodes and rescales usually stay under 10.
+ */
+inline int hammingDistance(FrameHash a, FrameHash b) {
+#if defined(__GNUC__)
+  return __builtin_popcountll(a ^ b);
+#else
+  return static_cast<int>(std::bitset<64>(a ^ b).count());
+#endif
+}
+
+/**
+ * @brief The Fingerprint struct holds the hashes of a stream, sampled at a
+ * fixed interval.
+ */
+struct Fingerprint {
+  /**
+   * @brief Time between hashed frames. 0 if every frame is hashed.
+   */
+  time::Seconds interval{0.};
+
+  /**
+   * @brief Hash of each sampled frame, in presentation order.
+   */
+  std::vector<FrameHash> hashes;
+};
+
+/**
+ * @brief Serializes a fingerprint: a 16 bytes header ("FXFP", version,
+ * interval in milliseconds, hash count) followed by the hashes as 64 bit
+ * little endian integers.
+ * @return the serialized fingerprint.
+ */
+std::vector<uint8_t> serializeFingerprint(Fingerprint const &fingerprint);
+
+/**
+ * @brief Parses a fingerprint serialized by serializeFingerprint().
+ * @return the fingerprint.
+ * @throws if the data is not a valid fingerprint.
+ */
+Fingerprint deserializeFingerprint(std::vector<uint8_t> const &data);
+
+/**
+ * @brief The FrameHasherConfig struct holds the frame hasher settings.
+ */
+struct FrameHasherConfig {
+  /**
+   * @brief Minimum time between the frames added to the fingerprint. 0 adds
+   * every frame.
+   */
+  time::Seconds interval{1.};
+};
+
+/**
+ * @brief The IFrameHasher class defines the API of a perceptual frame
+ * hasher.
+ *
+ * Hashes follow pHash: the luma is box filtered down to 32x32, transformed
+ * with a DCT and each of the 8x8 lowest frequencies (but the DC terms) sets
+ * a bit if it is above their median. They resist rescaling, re-encoding and
+ * small color or brightness changes. Only formats with an 8 bit planar luma
+ * (YUV and gray) are supported.
+ */
+class IFrameHasher {
+public:
+  virtual ~IFrameHasher() = default;
+
+  /**
+   * @return the hash of a frame.
+   * @throws if the frame format is not supported.
+   */
+  virtual FrameHash hash(avutil::IAVFrame *frame) = 0;
+
+  /**
+   * @brief Adds a frame of the stream to the fingerprint, if at least the
+   * configured interval passed since the last added one.
+   * @return whether the frame was added.
+   * @throws if the frame format is not supported.
+   */
+  virtual bool addFrame(avutil::IAVFrame *frame) = 0;
+
+  /**
+   * @return the fingerprint of the frames added so far.
+   */
+  virtual Fingerprint getFingerprint() const = 0;
+
+  /**
+   * @brief Clears the fingerprint.
+   */
+  virtual void reset() = 0;
+};
+
+/**
+ * @brief The FrameHasherFactory class creates frame hashers.
+ */
+class FrameHasherFactory {
+public:
+  /**
+   * @brief Creates a frame hasher.
+   * @param config The hasher settings.
+   * @return the new hasher.
+   */
+  static IFrameHasher *create(FrameHasherConfig const &config = {});
+};
+}; // namespace analysis
+}; // namespace libffmpegxx
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "IFrameHasher.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace libffmpegxx {
+namespace analysis {
+/**
+ * @brief The HashMatch struct holds a stored hash close to a searched one.
+ */
+struct HashMatch {
+  /**
+   * @brief Fingerprint id, as returned when adding it.
+   */
+  size_t fingerprint;
+
+  /**
+   * @brief Index of the hash in the fingerprint.
+   */
+  size_t index;
+
+  /**
+   * @brief Hamming distance to the searched hash.
+   */
+  int distance;
+};
+
+/**
+ * @brief The FingerprintMatch struct holds a stored fingerprint sharing
+ * frames with a searched one.
+ */
+struct FingerprintMatch {
+  /**
+   * @brief Fingerprint id, as returned when adding it.
+   */
+  size_t fingerprint;
+
+  /**
+   * @brief Amount of hashes of the searched fingerprint found in it.
+   */
+  size_t matchedHashes;
+
+  /**
+   * @brief Share of the hashes of the searched fingerprint found in it, from
+   * 0 to 1.
+   */
+  double ratio;
+};
+
+/**
+ * @brief The IHashMatcher class defines the API of a set of fingerprints
+ * searchable by Hamming distance.
+ *
+ * Hashes are stored contiguously. Searches within 3 bits use multi-index
+ * hashing: the 64 bits are split in four 16 bit parts and, as a hash within
+ * 3 bits of another equals it in at least one part, only the hashes sharing
+ * a part are compared. Wider searches scan every hash.
+ *
+ * Searches can run concurrently, but not while fingerprints are added.
+ */
+class IHashMatcher {
+public:
+  virtual ~IHashMatcher() = default;
+
+  /**
+   * @brief Adds a fingerprint.
+   * @return its id, counting from 0.
+   */
+  virtual size_t add(Fingerprint const &fingerprint) = 0;
+
+  /**
+   * @return the stored hashes within a distance of a hash, closest first.
+   */
+  virtual std::vector<HashMatch> find(FrameHash hash,
+                                      int maxDistance) const = 0;
+
+  /**
+   * @return the stored fingerprints sharing at least minRatio of the hashes
+   * of a fingerprint, within a distance, best first.
+   */
+  virtual std::vector<FingerprintMatch> match(Fingerprint const &fingerprint,
+                                              int maxDistance,
+                                              double minRatio = 0.) const = 0;
+
+  /**
+   * @return the amount of stored fingerprints.
+   */
+  virtual size_t getFingerprintCount() const = 0;
+
+  /**
+   * @return the amount of stored hashes.
+   */
+  virtual size_t getHashCount() const = 0;
+};
+
+/**
+ * @brief The HashMatcherFactory class creates hash matchers.
+ */
+class HashMatcherFactory {
+public:
+  /**
+   * @brief Creates an empty hash matcher.
+   * @return the new matcher.
+   */
+  static IHashMatcher *create();
+};
+}; // namespace analysis
+}; // namespace libffmpegxx
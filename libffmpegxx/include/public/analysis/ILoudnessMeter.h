@@ -0,0 +1,113 @@
+#pragma once
+
+namespace libffmpegxx {
+namespace avutil {
+class IAVFrame;
+}
+
+namespace analysis {
+/**
+ * @brief The LoudnessMeterConfig struct holds the loudness meter settings.
+ */
+struct LoudnessMeterConfig {
+  /**
+   * @brief Whether the true peak is measured. It needs oversampling, which
+   * costs more than the loudness itself.
+   */
+  bool truePeak{true};
+};
+
+/**
+ * @brief The Loudness struct holds the EBU R128 measurements of an audio
+ * stream. Loudness values are -infinity until there is enough audio to
+ * measure them or if it is all below the gates.
+ */
+struct Loudness {
+  /**
+   * @brief Momentary loudness (last 400 ms) in LUFS.
+   */
+  double momentary;
+
+  /**
+   * @brief Short-term loudness (last 3 s) in LUFS.
+   */
+  double shortTerm;
+
+  /**
+   * @brief Integrated loudness of the whole stream in LUFS.
+   */
+  double integrated;
+
+  /**
+   * @brief Loudness range of the whole stream in LU.
+   */
+  double range;
+
+  /**
+   * @brief Highest momentary loudness in LUFS.
+   */
+  double maxMomentary;
+
+  /**
+   * @brief Highest short-term loudness in LUFS.
+   */
+  double maxShortTerm;
+
+  /**
+   * @brief Highest sample peak of all channels in dBFS.
+   */
+  double samplePeak;
+
+  /**
+   * @brief Highest true peak of all channels in dBTP. Same as the sample
+   * peak if the true peak is not measured.
+   */
+  double truePeak;
+};
+
+/**
+ * @brief The ILoudnessMeter class defines the API of an EBU R128 loudness
+ * meter.
+ *
+ * The meter consumes the decoded frames of an audio stream as they come, in
+ * any sample format, so it can run in the same pass as transcoding. Memory
+ * use does not grow with the stream length: gated blocks are kept as
+ * histograms of 0.1 LU bins from -70 to +30 LUFS, which is also the
+ * precision of the integrated loudness and the range.
+ */
+class ILoudnessMeter {
+public:
+  virtual ~ILoudnessMeter() = default;
+
+  /**
+   * @brief Measures a frame.
+   * @param frame The frame. Sample rate or channel layout changes restart
+   * the filters but keep the stream measurements.
+   */
+  virtual void addFrame(avutil::IAVFrame *frame) = 0;
+
+  /**
+   * @return the measurements so far. Can be called from any thread.
+   */
+  virtual Loudness getLoudness() const = 0;
+
+  /**
+   * @brief Clears the measurements.
+   */
+  virtual void reset() = 0;
+};
+
+/**
+ * @brief The LoudnessMeterFactory class creates loudness meters.
+ */
+class LoudnessMeterFactory {
+public:
+  /**
+   * @brief Creates a loudness meter.
+   * @param config The meter settings.
+   * @return the new meter.
+   */
+  static ILoudnessMeter *create(LoudnessMeterConfig const &config = {});
+};
+}; // namespace analysis
+}; // namespace libffmpegxx
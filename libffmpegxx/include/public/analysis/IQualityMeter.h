@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace libffmpegxx {
+namespace avutil {
+class IAVFrame;
+}
+
+namespace analysis {
+/**
+ * @brief The QualityMeterConfig struct holds the quality meter settings.
+ */
+struct QualityMeterConfig {
+  /**
+   * @brief Threads comparing row bands of the frames, the calling one
+   * included. 0 uses one per core.
+   */
+  size_t threads{0};
+
+  /**
+   * @brief Whether SSIM is computed. PSNR alone is much cheaper.
+   */
+  bool ssim{true};
+};
+
+/**
+ * @brief The PlaneQuality struct holds the quality of a plane.
+ */
+struct PlaneQuality {
+  /**
+   * @brief Mean squared error.
+   */
+  double mse{0.0};
+
+  /**
+   * @brief PSNR in dB. Infinite if the planes are equal.
+   */
+  double psnr{0.0};
+
+  /**
+   * @brief SSIM, from 0 to 1, over 8x8 windows with a step of 4 samples.
+   * 1 for planes smaller than a window or if SSIM is disabled.
+   */
+  double ssim{1.0};
+};
+
+/**
+ * @brief The FrameQuality struct holds the quality of a frame.
+ */
+struct FrameQuality {
+  /**
+   * @brief Quality of each plane.
+   */
+  std::vector<PlaneQuality> planes;
+
+  /**
+   * @brief Mean squared error of all the samples of the frame.
+   */
+  double mse{0.0};
+
+  /**
+   * @brief PSNR of the whole frame, from its MSE.
+   */
+  double psnr{0.0};
+
+  /**
+   * @brief SSIM of the whole frame, weighting planes by their size.
+   */
+  double ssim{1.0};
+};
+
+/**
+ * @brief The StreamQuality struct holds the quality of the frames compared
+ * so far.
+ */
+struct StreamQuality {
+  /**
+   * @brief Amount of frames compared.
+   */
+  int64_t frameCount{0};
+
+  /**
+   * @brief Average quality of each plane. PSNR is computed from the average
+   * MSE, like the FFmpeg psnr filter does.
+   */
+  std::vector<PlaneQuality> planes;
+
+  /**
+   * @brief Average frame MSE.
+   */
+  double mse{0.0};
+
+  /**
+   * @brief PSNR of the whole stream, from the average frame MSE.
+   */
+  double psnr{0.0};
+
+  /**
+   * @brief Average frame SSIM.
+   */
+  double ssim{1.0};
+
+  /**
+   * @brief Lowest frame PSNR.
+   */
+  double minPsnr{0.0};
+
+  /**
+   * @brief Lowest frame SSIM.
+   */
+  double minSsim{1.0};
+};
+
+/**
+ * @brief The IQualityMeter class defines the API of an objective quality
+ * meter.
+ *
+ * A quality meter compares the frames of a stream with their reference (i.e.
+ * source and re-decoded frames) and accumulates the results. Planes are read
+ * in place and split into row bands compared on several threads, with the
+ * fastest kernels the CPU supports. Only 8 bit planar formats are supported.
+ */
+class IQualityMeter {
+public:
+  virtual ~IQualityMeter() = default;
+
+  /**
+   * @brief Compares a frame with its reference and adds the result to the
+   * stream quality.
+   * @param reference The reference frame.
+   * @param distorted The frame to measure.
+   * @return the frame quality.
+   * @throws if the frames differ in size or format or the format is not
+   * supported.
+   */
+  virtual FrameQuality compare(avutil::IAVFrame *reference,
+                               avutil::IAVFrame *distorted) = 0;
+
+  /**
+   * @return the quality of the frames compared so far. Can be called from
+   * any thread.
+   */
+  virtual StreamQuality getStreamQuality() const = 0;
+
+  /**
+   * @brief Clears the stream quality.
+   */
+  virtual void reset() = 0;
+
+  /**
+   * @return the name of the instruction set in use.
+   */
+  virtual std::string getKernelName() const = 0;
+};
+
+/**
+ * @brief The QualityMeterFactory class creates quality meters.
+ */
+class QualityMeterFactory {
+public:
+  /**
+   * @brief Creates a quality meter.
+   * @param config The meter settings.
+   * @return the new meter.
+   */
+  static IQualityMeter *create(QualityMeterConfig const &config = {});
+};
+}; // namespace analysis
+}; // namespace libffmpegxx
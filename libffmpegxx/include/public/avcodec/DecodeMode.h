@@ -0,0 +1,41 @@
+#pragma once
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace libffmpegxx {
+namespace avcodec {
+/**
+ * @brief The DecodeMode struct defines which work a decoder may skip to go
+ * faster when full quality output is not needed (thumbnails, scene indexing,
+ * quality sampling...).
+ *
+ * A keyframe-only scan uses skipFrame = AVDISCARD_NONKEY together with
+ * IDemuxer::setDiscard() so non-key packets are not even read.
+ */
+struct DecodeMode {
+  /**
+   * @brief Frames to skip decoding (i.e. AVDISCARD_NONREF, AVDISCARD_NONKEY).
+   */
+  AVDiscard skipFrame{AVDISCARD_DEFAULT};
+
+  /**
+   * @brief Frames to skip the loop (deblocking) filter for.
+   */
+  AVDiscard skipLoopFilter{AVDISCARD_DEFAULT};
+
+  /**
+   * @brief Frames to skip the inverse transform for.
+   */
+  AVDiscard skipIdct{AVDISCARD_DEFAULT};
+
+  /**
+   * @brief Decode at 1 / 2^lowres of the size (1 half, 2 quarter, 3 eighth).
+   * Only supported by some codecs (i.e. MJPEG, MPEG-2), limited to their
+   * maximum.
+   */
+  int lowres{0};
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
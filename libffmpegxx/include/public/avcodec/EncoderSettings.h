@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../time/Timebase.h"
+#include "ThreadingPolicy.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace libffmpegxx {
+namespace avcodec {
+/**
+ * @brief The EncoderSettings struct holds the most common encoder settings.
+ * Unset values keep the codec defaults.
+ */
+struct EncoderSettings {
+  /**
+   * @brief Speed/compression preset (i.e. "veryfast", "slow" for x264/x265,
+   * "p1" to "p7" for NVENC).
+   */
+  std::string preset;
+
+  /**
+   * @brief Content tuning (i.e. "film", "zerolatency").
+   */
+  std::string tune;
+
+  /**
+   * @brief Threading policy.
+   */
+  ThreadingPolicy threading;
+
+  /**
+   * @brief Slices per frame. 0 keeps the codec default.
+   */
+  int slices{0};
+
+  /**
+   * @brief Frames of rate control lookahead. -1 keeps the codec default.
+   */
+  int rcLookahead{-1};
+
+  /**
+   * @brief Maximum distance between keyframes, in frames. -1 keeps the codec
+   * default.
+   */
+  int gopSize{-1};
+
+  /**
+   * @brief Average bitrate in bits per second. 0 keeps the codec default.
+   */
+  int64_t bitrate{0};
+
+  /**
+   * @brief Maximum consecutive B-frames. -1 keeps the codec default.
+   */
+  int maxBFrames{-1};
+
+  /**
+   * @brief Places codec headers in extradata instead of every keyframe, as
+   * needed by MP4 and Matroska outputs.
+   */
+  bool globalHeader{false};
+
+  /**
+   * @brief Encoder timebase. By default 1 / framerate for video and
+   * 1 / sample rate for audio.
+   */
+  std::optional<time::Timebase> timebase;
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
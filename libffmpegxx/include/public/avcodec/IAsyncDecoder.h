@@ -0,0 +1,112 @@
+#pragma once
+
+#include "../utils/LatencyStatistics.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace libffmpegxx {
+namespace avutil {
+class IAVFrame;
+}
+
+namespace avcodec {
+class IAVPacket;
+class IDecoder;
+
+/**
+ * @brief The AsyncDecoderStatistics struct holds the progress and the
+ * latency of each stage of an asynchronous decoder.
+ */
+struct AsyncDecoderStatistics {
+  int64_t packets{0};
+  int64_t frames{0};
+
+  /**
+   * @brief Time packets wait in the input queue.
+   */
+  utils::LatencyStatistics inputQueue;
+
+  /**
+   * @brief Time spent decoding each packet, draining its frames included.
+   */
+  utils::LatencyStatistics decode;
+
+  /**
+   * @brief Time frames wait in the output queue until popped.
+   */
+  utils::LatencyStatistics outputQueue;
+};
+
+/**
+ * @brief The IAsyncDecoder class defines the API of an asynchronous decoder.
+ *
+ * Decoding runs on a dedicated thread between two bounded queues, so
+ * demuxing, decoding and consuming frames overlap. Full queues block the
+ * producer side (backpressure).
+ */
+class IAsyncDecoder {
+public:
+  virtual ~IAsyncDecoder() = default;
+
+  /**
+   * @brief Queues a packet to be decoded. Blocks while the input queue is
+   * full.
+   * @param packet The packet. Its data is referenced, not copied, so the
+   * caller may reuse it right away.
+   * @return false if the decoder was flushed or stopped due to an error.
+   */
+  virtual bool push(IAVPacket const *packet) = 0;
+
+  /**
+   * @brief Signals the end of the input. The remaining frames are drained
+   * from the decoder as done by IDecoder::flush(), then pop() returns false.
+   */
+  virtual void flush() = 0;
+
+  /**
+   * @brief Gets the next decoded frame. Blocks while the output queue is
+   * empty.
+   * @param frame Where the frame is stored.
+   * @return false once every frame has been popped after flushing, or if
+   * decoding stopped due to an error.
+   */
+  virtual bool pop(std::shared_ptr<avutil::IAVFrame> &frame) = 0;
+
+  /**
+   * @brief Gets the next decoded frame if any is available.
+   * @param frame Where the frame is stored.
+   * @return false if no frame is available right now.
+   */
+  virtual bool tryPop(std::shared_ptr<avutil::IAVFrame> &frame) = 0;
+
+  /**
+   * @return the FFmpeg API error code that stopped decoding. 0 if none.
+   */
+  virtual int getError() const = 0;
+
+  /**
+   * @return the decoding statistics.
+   */
+  virtual AsyncDecoderStatistics getStatistics() const = 0;
+};
+
+/**
+ * @brief The AsyncDecoderFactory class creates asynchronous decoders.
+ */
+class AsyncDecoderFactory {
+public:
+  /**
+   * @brief Creates an asynchronous decoder. Its thread starts right away.
+   * @param decoder The decoder to run. Owned by the caller, it must outlive
+   * the asynchronous decoder and not be used meanwhile.
+   * @param inputCapacity Maximum amount of queued packets.
+   * @param outputCapacity Maximum amount of queued frames.
+   * @return the new asynchronous decoder.
+   */
+  static IAsyncDecoder *create(IDecoder *decoder, size_t inputCapacity = 16,
+                               size_t outputCapacity = 16);
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
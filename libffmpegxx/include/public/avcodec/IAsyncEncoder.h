@@ -0,0 +1,145 @@
+#pragma once
+
+#include "../utils/LatencyStatistics.h"
+#include "IEncoder.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace libffmpegxx {
+namespace avutil {
+class IAVFrame;
+}
+
+namespace avcodec {
+class IAVPacket;
+
+/**
+ * @brief The AsyncEncoderStatistics struct holds the progress and the
+ * latency of each stage of an asynchronous encoder.
+ */
+struct AsyncEncoderStatistics {
+  int64_t frames{0};
+  int64_t packets{0};
+
+  /**
+   * @brief Time frames wait in the input queue.
+   */
+  utils::LatencyStatistics inputQueue;
+
+  /**
+   * @brief Time spent encoding each frame, draining its packets included.
+   */
+  utils::LatencyStatistics encode;
+
+  /**
+   * @brief Time packets wait in the output queue until popped. Empty when
+   * packets are delivered to a sink.
+   */
+  utils::LatencyStatistics outputQueue;
+};
+
+/**
+ * @brief The IAsyncEncoder class defines the API of an asynchronous encoder.
+ *
+ * Encoding runs on a dedicated thread fed by a bounded frame queue, so
+ * decoding and filtering can run ahead of slow encoder presets. Packets are
+ * either queued for the caller to pop or handed to a sink from the encoding
+ * thread. Full queues block the producer side (backpressure).
+ */
+class IAsyncEncoder {
+public:
+  virtual ~IAsyncEncoder() = default;
+
+  /**
+   * @brief Queues a frame to be encoded. Blocks while the input queue is
+   * full.
+   * @param frame The frame. Its data is referenced, not copied, so the
+   * caller may reuse it right away.
+   * @return false if the encoder was flushed or stopped due to an error.
+   */
+  virtual bool push(avutil::IAVFrame const *frame) = 0;
+
+  /**
+   * @brief Queues a frame to be encoded if there is room for it.
+   * @param frame The frame. Its data is referenced, not copied.
+   * @return false if the input queue is full, the encoder was flushed or it
+   * stopped due to an error.
+   */
+  virtual bool tryPush(avutil::IAVFrame const *frame) = 0;
+
+  /**
+   * @brief Signals the end of the input. The remaining packets are drained
+   * from the encoder as done by IEncoder::flush(), then pop() returns false.
+   */
+  virtual void flush() = 0;
+
+  /**
+   * @brief Waits until the encoding thread is done.
+   * @note With an output queue, call pop() until it returns false first,
+   * even after flush(): the encoding thread blocks while the queue is full,
+   * so waiting earlier may never return. With a packet sink, call it after
+   * flush().
+   * @return the FFmpeg API error code that stopped encoding. 0 if none.
+   */
+  virtual int wait() = 0;
+
+  /**
+   * @brief Gets the next encoded packet. Blocks while the output queue is
+   * empty.
+   * @param packet Where the packet is stored.
+   * @return false once every packet has been popped after flushing, if
+   * encoding stopped due to an error or if packets go to a sink.
+   */
+  virtual bool pop(std::shared_ptr<IAVPacket> &packet) = 0;
+
+  /**
+   * @brief Gets the next encoded packet if any is available.
+   * @param packet Where the packet is stored.
+   * @return false if no packet is available right now.
+   */
+  virtual bool tryPop(std::shared_ptr<IAVPacket> &packet) = 0;
+
+  /**
+   * @return the FFmpeg API error code that stopped encoding. 0 if none.
+   */
+  virtual int getError() const = 0;
+
+  /**
+   * @return the encoding statistics.
+   */
+  virtual AsyncEncoderStatistics getStatistics() const = 0;
+};
+
+/**
+ * @brief The AsyncEncoderFactory class creates asynchronous encoders.
+ */
+class AsyncEncoderFactory {
+public:
+  /**
+   * @brief Creates an asynchronous encoder delivering packets through an
+   * output queue. Its thread starts right away.
+   * @param encoder The encoder to run. Owned by the caller, it must outlive
+   * the asynchronous encoder and not be used meanwhile.
+   * @param inputCapacity Maximum amount of queued frames.
+   * @param outputCapacity Maximum amount of queued packets.
+   * @return the new asynchronous encoder.
+   */
+  static IAsyncEncoder *create(IEncoder *encoder, size_t inputCapacity = 8,
+                               size_t outputCapacity = 64);
+
+  /**
+   * @brief Creates an asynchronous encoder delivering packets to a sink.
+   * Its thread starts right away.
+   * @param encoder The encoder to run. Owned by the caller, it must outlive
+   * the asynchronous encoder and not be used meanwhile.
+   * @param sink Called from the encoding thread for every packet.
+   * @param inputCapacity Maximum amount of queued frames.
+   * @return the new asynchronous encoder.
+   */
+  static IAsyncEncoder *create(IEncoder *encoder, PacketSink const &sink,
+                               size_t inputCapacity = 8);
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "../avformat/MediaInfo.h"
+#include "../time/time_defs.h"
+#include "../utils/AVOptions.h"
+#include "EncoderSettings.h"
+#include "IEncoder.h"
+#include "ThreadingPolicy.h"
+
+#include <cstddef>
+#include <string>
+
+namespace libffmpegxx {
+namespace avcodec {
+/**
+ * @brief The ChunkedEncodeConfig struct holds the settings of a chunked
+ * encoder.
+ */
+struct ChunkedEncodeConfig {
+  /**
+   * @brief Output codec.
+   */
+  AVCodecID codecId{AV_CODEC_ID_H264};
+
+  /**
+   * @brief Output width. 0 keeps the source aspect ratio from the height,
+   * or the source width if both are 0.
+   */
+  int width{0};
+
+  /**
+   * @brief Output height. 0 keeps the source aspect ratio from the width,
+   * or the source height if both are 0.
+   */
+  int height{0};
+
+  /**
+   * @brief Output pixel format. By default the source one if the encoder
+   * supports it, the first format supported by the encoder otherwise.
+   */
+  AVPixelFormat pixelFormat{AV_PIX_FMT_NONE};
+
+  /**
+   * @brief Settings of every chunk encoder. Parallelism already comes from
+   * the chunks, so a low encoder thread count is usually best.
+   */
+  EncoderSettings settings;
+
+  /**
+   * @brief Free-form options of every chunk encoder.
+   */
+  utils::AVOptions encoderOptions;
+
+  /**
+   * @brief Amount of workers, each one with its own demuxer, decoder and
+   * encoder. 0 uses one per core.
+   */
+  int workers{0};
+
+  /**
+   * @brief Minimum duration of a chunk. Chunks span whole source GOPs, so
+   * they may be longer.
+   */
+  time::Seconds minChunkDuration{10.};
+
+  /**
+   * @brief Maximum amount of chunks encoded ahead of the one being
+   * delivered. 0 uses twice the amount of workers.
+   */
+  size_t reorderWindow{0};
+
+  /**
+   * @brief Demuxer open options.
+   */
+  utils::AVOptions demuxerOptions;
+
+  /**
+   * @brief Decoder options.
+   */
+  utils::AVOptions decoderOptions;
+
+  /**
+   * @brief Threading policy of each worker decoder.
+   */
+  ThreadingPolicy decoderThreading{ThreadingMode::NONE, 0, {}};
+};
+
+/**
+ * @brief The IChunkedEncoder class defines the API of a chunked encoder.
+ *
+ * The input timeline is split at source keyframes into chunks, which are
+ * encoded with closed GOPs by independent encoders with the same settings.
+ * The packets are then stitched into a single stream in order, keeping the
+ * decoding timestamps strictly increasing across chunk boundaries. It suits
+ * slow encoder presets that leave most cores idle even when threaded.
+ */
+class IChunkedEncoder {
+public:
+  virtual ~IChunkedEncoder() = default;
+
+  /**
+   * @return the info of the encoded stream, as needed to create a muxer for
+   * it.
+   */
+  virtual avformat::StreamInfo getStreamInfo() const = 0;
+
+  /**
+   * @brief Encodes the whole stream. Blocks until done or stopped.
+   * @param sink Called from the calling thread for every packet, in decoding
+   * order.
+   * @return FFmpeg API error code. 0 if the whole stream was encoded,
+   * AVERROR_INVALIDDATA if a chunk after the first one has packets without
+   * timestamps, as its DTS could not follow the previous chunk ones.
+   * @throws if the input cannot be opened or the sink throws.
+   */
+  virtual int encode(PacketSink const &sink) = 0;
+
+  /**
+   * @brief Requests encoding to stop. Can be called from any thread.
+   */
+  virtual void stop() = 0;
+};
+
+/**
+ * @brief The ChunkedEncoderFactory class creates chunked encoders.
+ */
+class ChunkedEncoderFactory {
+public:
+  /**
+   * @brief Creates a chunked encoder.
+   * @param uri The input URI. It is opened once per worker, so it must be a
+   * seekable input (i.e. a file).
+   * @param streamIdx The video stream to encode.
+   * @param config The encoding settings.
+   * @return the new chunked encoder.
+   * @throws if the stream is not a video stream or the encoder cannot be
+   * opened.
+   */
+  static IChunkedEncoder *create(std::string const &uri, int streamIdx,
+                                 ChunkedEncodeConfig const &config = {});
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
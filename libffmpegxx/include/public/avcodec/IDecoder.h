@@ -1,6 +1,12 @@
 #pragma once
 
 #include "../avformat/MediaInfo.h"
+#include "../utils/AVOptions.h"
+#include "DecodeMode.h"
+#include "ThreadingPolicy.h"
+
+#include <functional>
+#include <memory>
 
 namespace libffmpegxx {
 namespace avutil {
@@ -9,6 +15,13 @@ class IAVFrame;
 namespace avcodec {
 class IAVPacket;
 
+/**
+ * @brief Receives the frames produced by a decoder. Frames come from an
+ * internal pool and go back to it once all their references are dropped.
+ */
+using FrameSink =
+    std::function<void(std::shared_ptr<avutil::IAVFrame> const &frame)>;
+
 /**
  * @brief The IDecoder class defines the decoder features.
  */
@@ -23,15 +36,56 @@ public:
    * @return FFmpeg API error code.
    * @note Some decoders may need several packets before start producing
    * decoded data.
+   * @note Only one frame is received per packet. Use the FrameSink overload
+   * to get every frame a packet produces.
    */
   virtual int decode(IAVPacket *packet, avutil::IAVFrame *frame) = 0;
 
+  /**
+   * @brief Decodes an encoded data packet and hands every frame available
+   * afterwards to the sink. If the decoder cannot take the packet yet, its
+   * pending frames are drained first and the packet is sent again.
+   * @param packet The packet to decode. nullptr flushes the decoder, draining
+   * all the remaining frames.
+   * @param sink Called once per decoded frame, in output order.
+   * @return FFmpeg API error code. 0 if the packet was decoded,
+   * AVERROR_EOF once the decoder is fully flushed.
+   */
+  virtual int decode(IAVPacket *packet, FrameSink const &sink) = 0;
+
   /**
    * @brief Flushes the decoder getting out any remaining frames.
    * @param flushedFrames List of frames flushed from the decoder.
    * @return FFmpeg API error code.
    */
   virtual int flush(std::vector<avutil::IAVFrame *> &flushedFrames) = 0;
+
+  /**
+   * @brief Discards any buffered packet or frame so decoding can restart
+   * from another position (i.e. after seeking) or after flushing.
+   */
+  virtual void reset() = 0;
+
+  /**
+   * @return the threading configuration actually used by the decoder, which
+   * may differ from the requested one (i.e. codecs without frame threading).
+   */
+  virtual ThreadingPolicy getThreading() const = 0;
+
+  /**
+   * @brief Changes the decoding mode. Skipping settings apply from the next
+   * packet on.
+   * @param mode The new decoding mode.
+   * @note Changing lowres reopens the decoder, dropping any buffered frame.
+   * Do it after flushing or seeking.
+   * @throws if the decoder cannot be reopened.
+   */
+  virtual void setDecodeMode(DecodeMode const &mode) = 0;
+
+  /**
+   * @return the decoding mode in use. Lowres is the one actually applied.
+   */
+  virtual DecodeMode getDecodeMode() const = 0;
 };
 
 /**
@@ -45,6 +99,22 @@ public:
    * @return a new decoder for the given stream.
    */
   static IDecoder *create(avformat::StreamInfo const &streamInfo);
+
+  /**
+   * @brief Creates a decoder for a given stream.
+   * @param streamInfo The info about the stream to decode.
+   * @param options Decoder options. Options not accepted by the decoder are
+   * logged and ignored.
+   * @param threading The threading policy, applied before opening the
+   * decoder. A "threads" option overrides its thread count.
+   * @param mode The decoding mode.
+   * @return a new decoder for the given stream.
+   * @throws if the decoder cannot be opened or pinned to the given cores.
+   */
+  static IDecoder *create(avformat::StreamInfo const &streamInfo,
+                          utils::AVOptions const &options,
+                          ThreadingPolicy const &threading = {},
+                          DecodeMode const &mode = {});
 };
 }; // namespace avcodec
 }; // namespace libffmpegxx
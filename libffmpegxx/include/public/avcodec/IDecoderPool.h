@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../time/time_defs.h"
+#include "../utils/AVOptions.h"
+#include "DecodeMode.h"
+#include "IDecoder.h"
+#include "ThreadingPolicy.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace libffmpegxx {
+namespace avcodec {
+/**
+ * @brief The DecoderPoolStatistics struct holds the usage of a decoder pool.
+ */
+struct DecoderPoolStatistics {
+  /**
+   * @brief Acquisitions served with an idle decoder.
+   */
+  int64_t hits{0};
+
+  /**
+   * @brief Acquisitions that had to open a new decoder.
+   */
+  int64_t misses{0};
+
+  /**
+   * @brief Idle decoders closed to honour the pool limits.
+   */
+  int64_t evictions{0};
+
+  /**
+   * @brief Decoders currently idle in the pool.
+   */
+  size_t idle{0};
+
+  /**
+   * @return the ratio of acquisitions served with an idle decoder.
+   */
+  double getHitRate() const {
+    auto const total = hits + misses;
+    return total > 0 ? static_cast<double>(hits) / total : 0.;
+  }
+};
+
+/**
+ * @brief The DecoderPoolConfig struct holds the settings of a decoder pool.
+ */
+struct DecoderPoolConfig {
+  /**
+   * @brief Maximum amount of idle decoders. The least recently used ones are
+   * closed first.
+   */
+  size_t maxIdle{16};
+
+  /**
+   * @brief Idle decoders unused for longer than this are closed.
+   */
+  time::Seconds maxIdleTime{30.};
+
+  /**
+   * @brief Options of the opened decoders.
+   */
+  utils::AVOptions options;
+
+  /**
+   * @brief Threading policy of the opened decoders.
+   */
+  ThreadingPolicy threading;
+
+  /**
+   * @brief Decoding mode of the acquired decoders. Restored when a decoder
+   * returns to the pool.
+   */
+  DecodeMode mode;
+};
+
+/**
+ * @brief The IDecoderPool class defines the API of a decoder pool.
+ *
+ * Opening a decoder (finding the codec, allocating and opening its context)
+ * is expensive compared to decoding a short clip. A pool keeps released
+ * decoders opened and hands them out again for streams with the same codec,
+ * extradata, dimensions and format, after flushing their buffers.
+ */
+class IDecoderPool {
+public:
+  virtual ~IDecoderPool() = default;
+
+  /**
+   * @brief Gets a decoder for a stream, reusing an idle one if possible.
+   * @param streamInfo The info about the stream to decode.
+   * @return the decoder. It returns to the pool once released. It may outlive
+   * the pool.
+   * @throws if a new decoder cannot be opened.
+   */
+  virtual std::shared_ptr<IDecoder>
+  acquire(avformat::StreamInfo const &streamInfo) = 0;
+
+  /**
+   * @brief Closes the idle decoders exceeding the pool limits.
+   */
+  virtual void evict() = 0;
+
+  /**
+   * @brief Closes every idle decoder.
+   */
+  virtual void clear() = 0;
+
+  /**
+   * @return the pool statistics.
+   */
+  virtual DecoderPoolStatistics getStatistics() const = 0;
+};
+
+/**
+ * @brief The DecoderPoolFactory class creates decoder pools.
+ */
+class DecoderPoolFactory {
+public:
+  /**
+   * @brief Creates a decoder pool. It can be used from several threads.
+   * @param config The pool settings.
+   * @return the new pool.
+   */
+  static IDecoderPool *create(DecoderPoolConfig const &config = {});
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
@@ -1,6 +1,12 @@
 #pragma once
 
 #include "../avformat/MediaInfo.h"
+#include "../utils/AVOptions.h"
+#include "EncoderSettings.h"
+#include "ThreadingPolicy.h"
+
+#include <functional>
+#include <memory>
 
 namespace libffmpegxx {
 namespace avutil {
@@ -9,6 +15,13 @@ class IAVFrame;
 namespace avcodec {
 class IAVPacket;
 
+/**
+ * @brief Receives the packets produced by an encoder. Packets come from an
+ * internal pool and go back to it once all their references are dropped.
+ */
+using PacketSink =
+    std::function<void(std::shared_ptr<avcodec::IAVPacket> const &packet)>;
+
 /**
  * @brief The IEncoder class defines the encoder features.
  */
@@ -18,22 +31,62 @@ public:
 
   /**
    * @brief Tries to encode a frame.
-   * @param frame The frame to encode.
+   * @param frame The frame to encode. Its timestamp is converted from the
+   * frame timebase to the encoder one.
    * @param packet The packet to store the encoded data.
-   * @return FFmpeg API error code.
+   * @return FFmpeg API error code. AVERROR(EAGAIN) if the encoder did not
+   * take the frame: send it again. The packet may still hold encoded data,
+   * check its size.
    * @note Some encoders may need several frames before start producing
    * encoded data.
    * @note To flush the encoder simply feed empty IAVFrames till
    * the returned error code is not 0.
+   * @note Only one packet is received per frame. Use the PacketSink overload
+   * to get every packet a frame produces.
    */
   virtual int encode(avutil::IAVFrame *frame, IAVPacket *packet) = 0;
 
+  /**
+   * @brief Encodes a frame and hands every packet available afterwards to
+   * the sink. If the encoder cannot take the frame yet, its pending packets
+   * are drained first and the frame is sent again.
+   * @param frame The frame to encode. Its timestamp is converted from the
+   * frame timebase to the encoder one. nullptr flushes the encoder, draining
+   * all the remaining packets.
+   * @param sink Called once per encoded packet, in output order.
+   * @return FFmpeg API error code. 0 if the frame was encoded,
+   * AVERROR_EOF once the encoder is fully flushed.
+   */
+  virtual int encode(avutil::IAVFrame *frame, PacketSink const &sink) = 0;
+
   /**
    * @brief Flushes the encoder getting out any remaining packets.
    * @param flushedPackets List of packets flushed from the encoder.
    * @return FFmpeg API error code.
    */
   virtual int flush(std::vector<avcodec::IAVPacket *> &flushedPackets) = 0;
+
+  /**
+   * @return the options given when creating the encoder that it did not
+   * accept.
+   */
+  virtual utils::AVOptions getRejectedOptions() const = 0;
+
+  /**
+   * @return the threading configuration actually used by the encoder.
+   */
+  virtual ThreadingPolicy getThreading() const = 0;
+
+  /**
+   * @return the timebase of the encoded packets.
+   */
+  virtual time::Timebase getTimebase() const = 0;
+
+  /**
+   * @return the info of the encoded stream (codec parameters, timebase, ...)
+   * as needed to create a muxer for it.
+   */
+  virtual avformat::StreamInfo getStreamInfo() const = 0;
 };
 
 /**
@@ -42,10 +95,25 @@ public:
 class EncoderFactory {
 public:
   /**
-   * @brief
+   * @brief Creates an encoder with the codec default settings.
+   * @param streamInfo The info about the stream to encode.
    * @return a new encoder.
    */
   static IEncoder *create(avformat::StreamInfo const &streamInfo);
+
+  /**
+   * @brief Creates an encoder.
+   * @param streamInfo The info about the stream to encode.
+   * @param settings Typed encoder settings.
+   * @param options Free-form encoder options. They take precedence over the
+   * typed settings. Options not accepted are logged and reported by
+   * IEncoder::getRejectedOptions().
+   * @return a new encoder.
+   * @throws if the encoder cannot be opened.
+   */
+  static IEncoder *create(avformat::StreamInfo const &streamInfo,
+                          EncoderSettings const &settings,
+                          utils::AVOptions const &options = {});
 };
 }; // namespace avcodec
 }; // namespace libffmpegxx
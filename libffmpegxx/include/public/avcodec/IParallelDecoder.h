@@ -0,0 +1,105 @@
+#pragma once
+
+#include "../utils/AVOptions.h"
+#include "DecodeMode.h"
+#include "IDecoder.h"
+#include "ThreadingPolicy.h"
+
+#include <cstddef>
+#include <string>
+
+namespace libffmpegxx {
+namespace avcodec {
+/**
+ * @brief The ParallelDecodeConfig struct holds the settings of a parallel
+ * decoder.
+ */
+struct ParallelDecodeConfig {
+  /**
+   * @brief Amount of workers, each one with its own demuxer and decoder. 0
+   * uses one per core.
+   */
+  int workers{0};
+
+  /**
+   * @brief Amount of GOPs decoded by a worker in a row. Bigger segments mean
+   * fewer seeks but a coarser work split.
+   */
+  int gopsPerSegment{1};
+
+  /**
+   * @brief Maximum amount of segments decoded ahead of the one being
+   * delivered. Bounds the memory used by the reorder buffer. 0 uses twice the
+   * amount of workers.
+   */
+  size_t reorderWindow{0};
+
+  /**
+   * @brief Demuxer open options.
+   */
+  utils::AVOptions demuxerOptions;
+
+  /**
+   * @brief Decoder options.
+   */
+  utils::AVOptions decoderOptions;
+
+  /**
+   * @brief Threading policy of each worker decoder. Parallelism already
+   * comes from the workers, so single threaded by default.
+   */
+  ThreadingPolicy threading{ThreadingMode::NONE, 0, {}};
+
+  /**
+   * @brief Decoding mode of each worker decoder.
+   */
+  DecodeMode mode;
+};
+
+/**
+ * @brief The IParallelDecoder class defines the API of a GOP parallel
+ * decoder.
+ *
+ * The input is split at keyframes into segments, which are decoded by
+ * independent workers and delivered in presentation order. It suits batch
+ * analysis of codecs without efficient frame threading (i.e. intra heavy
+ * codecs). Open GOPs are handled by decoding the leading pictures of the next
+ * keyframe within the segment they are displayed in.
+ */
+class IParallelDecoder {
+public:
+  virtual ~IParallelDecoder() = default;
+
+  /**
+   * @brief Decodes the whole stream. Blocks until done or stopped.
+   * @param sink Called from the calling thread for every frame, in
+   * presentation order.
+   * @return FFmpeg API error code. 0 if the whole stream was decoded.
+   * @throws if the input cannot be opened or the sink throws.
+   */
+  virtual int decode(FrameSink const &sink) = 0;
+
+  /**
+   * @brief Requests decoding to stop. Can be called from any thread.
+   */
+  virtual void stop() = 0;
+};
+
+/**
+ * @brief The ParallelDecoderFactory class creates parallel decoders.
+ */
+class ParallelDecoderFactory {
+public:
+  /**
+   * @brief Creates a parallel decoder.
+   * @param uri The input URI. It is opened once per worker, so it must be a
+   * seekable input (i.e. a file).
+   * @param streamIdx The stream to decode.
+   * @param config The decoding settings.
+   * @return the new parallel decoder.
+   */
+  static IParallelDecoder *create(std::string const &uri, int streamIdx,
+                                  ParallelDecodeConfig const &config = {});
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../utils/AVOptions.h"
+#include "ThreadingPolicy.h"
+
+#include <memory>
+
+namespace libffmpegxx {
+namespace avformat {
+class IDemuxer;
+};
+
+namespace avutil {
+class IAVFrame;
+}
+
+namespace time {
+class Timestamp;
+};
+
+namespace avcodec {
+/**
+ * @brief The ISeekingDecoder class defines the API of a decoder fetching
+ * single frames at arbitrary times (i.e. editor previews).
+ *
+ * Fetching seeks to the preceding keyframe and decodes the pre-roll skipping
+ * the non-reference frames displayed entirely before the requested time,
+ * which cannot be the requested frame nor be needed to decode it. Pre-roll
+ * frames go straight back to the frame pool.
+ */
+class ISeekingDecoder {
+public:
+  virtual ~ISeekingDecoder() = default;
+
+  /**
+   * @brief Decodes the frame displayed at the given time: the one with the
+   * largest PTS not after it.
+   * @param ts The time to fetch, in any timebase.
+   * @return the frame. If the time precedes the first frame, the first frame.
+   * nullptr if no frame could be decoded.
+   * @throws if seeking fails.
+   */
+  virtual std::shared_ptr<avutil::IAVFrame>
+  decodeAt(time::Timestamp const &ts) = 0;
+};
+
+/**
+ * @brief The SeekingDecoderFactory class creates seeking decoders.
+ */
+class SeekingDecoderFactory {
+public:
+  /**
+   * @brief Creates a seeking decoder.
+   * @param demuxer An opened demuxer. Owned by the caller, it must outlive
+   * the seeking decoder and not be read meanwhile. Discarding the other
+   * streams (IDemuxer::setDiscard()) avoids reading them.
+   * @param streamIdx The stream to decode.
+   * @param options Decoder options.
+   * @param threading Decoder threading policy. Slice threading adds no
+   * latency and suits single frame fetching best.
+   * @return the new seeking decoder.
+   * @throws if the stream does not exist or the decoder cannot be opened.
+   */
+  static ISeekingDecoder *
+  create(avformat::IDemuxer *demuxer, int streamIdx,
+         utils::AVOptions const &options = {},
+         ThreadingPolicy const &threading = {ThreadingMode::SLICE});
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
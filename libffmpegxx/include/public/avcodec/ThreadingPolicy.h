@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+namespace libffmpegxx {
+namespace avcodec {
+/**
+ * @brief The ThreadingMode enum defines how a codec splits its work among
+ * threads.
+ */
+enum class ThreadingMode {
+  /**
+   * @brief Frame threading if supported by the codec, slice threading
+   * otherwise.
+   */
+  AUTO = 0,
+  /**
+   * @brief Several frames are processed at once. Best throughput but adds one
+   * frame of latency per thread.
+   */
+  FRAME,
+  /**
+   * @brief Slices of the same frame are processed at once. No added latency
+   * but the speedup depends on the amount of slices in the stream.
+   */
+  SLICE,
+  /**
+   * @brief Single threaded.
+   */
+  NONE
+};
+
+/**
+ * @brief The ThreadingPolicy struct defines the threads used by a codec.
+ */
+struct ThreadingPolicy {
+  /**
+   * @brief Threading mode.
+   */
+  ThreadingMode mode{ThreadingMode::AUTO};
+
+  /**
+   * @brief Amount of threads. 0 chooses one per available core (the cores
+   * given in cpus if any).
+   */
+  int threadCount{0};
+
+  /**
+   * @brief Cores the codec threads are pinned to. Empty means no pinning.
+   * Only supported on Linux.
+   */
+  std::vector<int> cpus;
+};
+}; // namespace avcodec
+}; // namespace libffmpegxx
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../avcodec/IDecoder.h"
+#include "../time/Timebase.h"
+
+#include <cstddef>
+#include <string>
+
+extern "C" {
+#include <libavutil/rational.h>
+}
+
+namespace libffmpegxx {
+namespace avutil {
+class IAVFrame;
+}
+
+namespace avfilter {
+/**
+ * @brief The FilterGraphConfig struct holds the settings of a filter graph.
+ */
+struct FilterGraphConfig {
+  /**
+   * @brief FFmpeg filter chain with a single input and output, i.e.
+   * "yadif,hqdn3d" or "loudnorm". Empty passes frames through.
+   */
+  std::string filters;
+
+  /**
+   * @brief Amount of threads running the filter slices. 0 uses one per core.
+   */
+  size_t threads{0};
+
+  /**
+   * @brief Whether the chain outputs every frame as soon as it gets it and
+   * keeps no state between frames, i.e. "scale=640:-2,format=yuv420p" but not
+   * "yadif" or "fps=30". Graphs of stateless chains are not sent the end of
+   * the input when flushed, so they are reused by later streams and
+   * parameter switches. Other graphs are configured for every stream, as
+   * libavfilter graphs cannot restart once ended.
+   */
+  bool stateless{false};
+
+  /**
+   * @brief Maximum amount of idle configured graphs kept for reuse. The least
+   * recently released ones are freed first.
+   */
+  size_t maxIdleGraphs{4};
+
+  /**
+   * @brief Input frame rate, for filters that need it (i.e. fps or
+   * framerate). {0, 1} if unknown. Ignored for audio.
+   */
+  AVRational frameRate{0, 1};
+};
+
+/**
+ * @brief The IFilterGraph class defines the API of a libavfilter graph
+ * stage, which runs an FFmpeg filter chain over the decoded frames of a
+ * stream.
+ *
+ * Graphs are parsed and configured for the input parameters (media type,
+ * size or sample rate, format, aspect ratio, channel layout and timebase)
+ * of the frames. When they change within the stream, the graph configured
+ * for the previous ones is flushed to the sink before the frame is filtered,
+ * so frames are output in order.
+ *
+ * Output frames carry the timebase of the graph output, which filters like
+ * fps or setpts may change.
+ *
+ * Filter slices run on a thread pool shared by the graphs of a pool, not on
+ * libavfilter threads.
+ *
+ * A filter graph is not thread safe. Use one per stream.
+ */
+class IFilterGraph {
+public:
+  virtual ~IFilterGraph() = default;
+
+  /**
+   * @brief Filters a frame and hands every frame the graph outputs to the
+   * sink.
+   * @param frame The frame to filter. It is not modified. nullptr flushes
+   * the graph, handing out its remaining frames. Frames filtered afterwards
+   * start a new stream.
+   * @param sink Called once per output frame, in order.
+   * @return FFmpeg API error code. 0 if the frame was filtered, AVERROR_EOF
+   * once flushed.
+   * @throws if the graph cannot be configured for the frame.
+   */
+  virtual int filter(avutil::IAVFrame *frame,
+                     avcodec::FrameSink const &sink) = 0;
+
+  /**
+   * @return the timebase of the frames output by the last used graph.
+   * @throws if no frame was filtered yet.
+   */
+  virtual time::Timebase getTimebase() const = 0;
+};
+
+/**
+ * @brief The FilterGraphFactory class creates filter graphs.
+ */
+class FilterGraphFactory {
+public:
+  /**
+   * @brief Creates a filter graph with its own thread pool. Use a filter
+   * graph pool to filter several streams.
+   * @param config The filter graph settings.
+   * @return the new filter graph.
+   */
+  static IFilterGraph *create(FilterGraphConfig const &config);
+};
+}; // namespace avfilter
+}; // namespace libffmpegxx
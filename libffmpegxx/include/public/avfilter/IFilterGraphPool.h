@@ -0,0 +1,55 @@
+#pragma once
+
+#include "IFilterGraph.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace libffmpegxx {
+namespace avfilter {
+/**
+ * @brief The IFilterGraphPool class defines the API of a filter graph pool.
+ *
+ * Each stream gets its own filter graph, so filters keeping frames or state
+ * (i.e. yadif or hqdn3d) never mix streams. Graphs of stateless chains (see
+ * FilterGraphConfig::stateless) are kept configured once released and
+ * handed out again for streams with the same input parameters. Every graph
+ * runs its filter slices on the thread pool of the pool.
+ */
+class IFilterGraphPool {
+public:
+  virtual ~IFilterGraphPool() = default;
+
+  /**
+   * @brief Gets a filter graph for a new stream. Releasing it without
+   * flushing drops the frames it still holds.
+   * @return the filter graph. Its configured graphs return to the pool once
+   * released if they can be reused. It may outlive the pool.
+   */
+  virtual std::shared_ptr<IFilterGraph> acquire() = 0;
+
+  /**
+   * @brief Frees every idle configured graph.
+   */
+  virtual void clear() = 0;
+
+  /**
+   * @return the amount of idle configured graphs ready for reuse.
+   */
+  virtual size_t getIdleCount() const = 0;
+};
+
+/**
+ * @brief The FilterGraphPoolFactory class creates filter graph pools.
+ */
+class FilterGraphPoolFactory {
+public:
+  /**
+   * @brief Creates a filter graph pool. It can be used from several threads.
+   * @param config The settings of the filter graphs.
+   * @return the new pool.
+   */
+  static IFilterGraphPool *create(FilterGraphConfig const &config);
+};
+}; // namespace avfilter
+}; // namespace libffmpegxx
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "../avcodec/EncoderSettings.h"
+#include "../avcodec/ThreadingPolicy.h"
+#include "../swscale/IScaler.h"
+#include "../time/time_defs.h"
+#include "../utils/AVOptions.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace libffmpegxx {
+namespace avformat {
+class IDemuxer;
+
+/**
+ * @brief The Rendition struct describes one output of an ABR ladder.
+ */
+struct Rendition {
+  /**
+   * @brief Output URI.
+   */
+  std::string uri;
+
+  /**
+   * @brief Output format short name. Guessed from the URI if empty.
+   */
+  std::string format;
+
+  /**
+   * @brief Output width. 0 keeps the source aspect ratio from the height,
+   * or the source width if both are 0.
+   */
+  int width{0};
+
+  /**
+   * @brief Output height. 0 keeps the source aspect ratio from the width,
+   * or the source height if both are 0.
+   */
+  int height{0};
+
+  /**
+   * @brief Output codec.
+   */
+  AVCodecID codecId{AV_CODEC_ID_H264};
+
+  /**
+   * @brief Output pixel format. By default the source one if the encoder
+   * supports it, the first format supported by the encoder otherwise.
+   */
+  AVPixelFormat pixelFormat{AV_PIX_FMT_NONE};
+
+  /**
+   * @brief Encoder settings. The GOP size defaults to the ladder keyframe
+   * interval and the timebase to the source framerate.
+   */
+  avcodec::EncoderSettings settings;
+
+  /**
+   * @brief Free-form encoder options.
+   */
+  utils::AVOptions options;
+};
+
+/**
+ * @brief The AbrLadderConfig struct configures an ABR ladder.
+ */
+struct AbrLadderConfig {
+  /**
+   * @brief The outputs to produce.
+   */
+  std::vector<Rendition> renditions;
+
+  /**
+   * @brief Distance between keyframes in frames, the same for every
+   * rendition. 0 uses two seconds worth of frames.
+   */
+  int keyframeInterval{0};
+
+  /**
+   * @brief Maximum amount of frames waiting to be encoded per rendition.
+   */
+  size_t queueCapacity{8};
+
+  /**
+   * @brief Scaler settings. Every size is scaled on the decoding thread.
+   */
+  swscale::ScalerConfig scaling;
+
+  /**
+   * @brief Decoder options.
+   */
+  utils::AVOptions decoderOptions;
+
+  /**
+   * @brief Decoder threading policy.
+   */
+  avcodec::ThreadingPolicy decoderThreading;
+};
+
+/**
+ * @brief The RenditionStatistics struct holds the progress of a rendition.
+ */
+struct RenditionStatistics {
+  /**
+   * @brief Amount of frames encoded.
+   */
+  int64_t frames{0};
+
+  /**
+   * @brief Amount of packets written to the output.
+   */
+  int64_t packets{0};
+
+  /**
+   * @brief Amount of bytes written to the output.
+   */
+  int64_t bytes{0};
+};
+
+/**
+ * @brief The AbrLadderStatistics struct holds the progress of an ABR ladder.
+ */
+struct AbrLadderStatistics {
+  /**
+   * @brief Amount of frames decoded.
+   */
+  int64_t decodedFrames{0};
+
+  /**
+   * @brief Time spent so far.
+   */
+  time::Seconds elapsed{0.};
+
+  /**
+   * @brief Statistics of each rendition, in configuration order.
+   */
+  std::vector<RenditionStatistics> renditions;
+};
+
+/**
+ * @brief The IAbrLadder class defines the API of an ABR ladder.
+ *
+ * An ABR ladder produces several renditions of a video stream decoding it
+ * only once. Each distinct output size is scaled once and the frames are
+ * shared by reference with the encoders, which run on their own threads and
+ * write to their own muxer. Keyframes are forced at the same frames in every
+ * rendition so the outputs can be switched at segment boundaries.
+ */
+class IAbrLadder {
+public:
+  virtual ~IAbrLadder() = default;
+
+  /**
+   * @brief Opens the muxers and starts the decoding and encoding threads.
+   * @param options Muxer open options. Optional
+   * @throws if the ladder is already running or an output cannot be opened.
+   */
+  virtual void start(utils::AVOptions const &options = {}) = 0;
+
+  /**
+   * @brief Requests the ladder to stop. Frames already queued are dropped.
+   */
+  virtual void stop() = 0;
+
+  /**
+   * @brief Waits until every rendition is finished and closes the muxers.
+   * @return FFmpeg API error code. 0 if the whole input was encoded.
+   */
+  virtual int wait() = 0;
+
+  /**
+   * @return true if the ladder is running.
+   */
+  virtual bool isRunning() const = 0;
+
+  /**
+   * @return the statistics of the ladder. It can be called while running.
+   */
+  virtual AbrLadderStatistics getStatistics() const = 0;
+};
+
+/**
+ * @brief The AbrLadderFactory class creates ABR ladders.
+ */
+class AbrLadderFactory {
+public:
+  /**
+   * @brief Creates an ABR ladder.
+   * @param demuxer An opened demuxer to read from. Owned by the caller, it
+   * must not be used while the ladder is running.
+   * @param streamIdx The video stream to encode. Other streams are ignored.
+   * @param config The ladder configuration.
+   * @return the new ABR ladder.
+   * @throws if the stream is not a video stream, there are no renditions or
+   * any encoder cannot be opened.
+   */
+  static IAbrLadder *create(IDemuxer *demuxer, int streamIdx,
+                            AbrLadderConfig const &config);
+};
+}; // namespace avformat
+}; // namespace libffmpegxx
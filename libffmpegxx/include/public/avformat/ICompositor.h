@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../utils/AVOptions.h"
+#include "IRemuxer.h"
+#include "MediaInfo.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace libffmpegxx {
+namespace avformat {
+class IDemuxer;
+
+/**
+ * @brief The StreamSource struct selects an input stream to be carried by a
+ * compositor output stream.
+ */
+struct StreamSource {
+  /**
+   * @brief An opened demuxer. Owned by the caller.
+   */
+  IDemuxer *demuxer{nullptr};
+
+  /**
+   * @brief The stream index within the demuxer MediaInfo.
+   */
+  int streamIdx{0};
+
+  /**
+   * @brief Metadata added to the output stream (i.e. {"language", "spa"}).
+   * Optional.
+   */
+  utils::AVOptions metadata;
+};
+
+/**
+ * @brief The ICompositor class defines the API of a compositor.
+ *
+ * A compositor builds one output from streams of several demuxers (i.e. the
+ * video of a file and audio tracks in several languages from others). Each
+ * demuxer is read ahead on its own thread into a bounded queue while packets
+ * are written to the output in DTS order across all the inputs.
+ */
+class ICompositor : public IRemuxer {
+public:
+  /**
+   * @return the output media info. Stream N carries the Nth stream source.
+   */
+  virtual MediaInfo getMediaInfo() const = 0;
+};
+
+/**
+ * @brief The CompositorFactory class creates compositors.
+ */
+class CompositorFactory {
+public:
+  /**
+   * @brief Creates a compositor.
+   * @param sources The input streams, in output stream order.
+   * @param uri The output URI.
+   * @param format The output format short name. Guessed from the URI if
+   * empty.
+   * @param queueCapacity Maximum amount of packets read ahead per demuxer.
+   * @note Demuxers must not be used by the caller while the compositor is
+   * running.
+   * @return the new compositor.
+   * @throws if there are no sources or any of them is not valid.
+   */
+  static ICompositor *create(std::vector<StreamSource> const &sources,
+                             std::string const &uri,
+                             std::string const &format = "",
+                             size_t queueCapacity = 64);
+};
+}; // namespace avformat
+}; // namespace libffmpegxx
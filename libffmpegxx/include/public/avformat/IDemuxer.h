@@ -11,6 +11,10 @@ namespace avcodec {
 class IAVPacket;
 };
 
+namespace time {
+class Timestamp;
+};
+
 namespace avformat {
 /**
  * @brief The IDemuxer class demuxer the API of a demuxer.
@@ -51,6 +55,26 @@ public:
    * @throws if the input has not been opened before.
    */
   virtual MediaInfo getMediaInfo() const = 0;
+
+  /**
+   * @brief Sets which packets of a stream are discarded. AVDISCARD_ALL drops
+   * the whole stream and AVDISCARD_NONKEY every non-key packet, before they
+   * reach any decoder. Other values are only passed to the underlying
+   * demuxer.
+   * @param streamIdx The stream index.
+   * @param discard The discard level. AVDISCARD_DEFAULT keeps every packet.
+   * @throws if the demuxer is not opened or the stream does not exist.
+   */
+  virtual void setDiscard(int streamIdx, AVDiscard discard) = 0;
+
+  /**
+   * @brief Seeks to the keyframe at or before the given timestamp.
+   * @param streamIdx The stream the timestamp refers to.
+   * @param ts The timestamp to seek to, in any timebase.
+   * @return FFmpeg API error code.
+   * @throws if the demuxer is not opened or the stream does not exist.
+   */
+  virtual int seek(int streamIdx, time::Timestamp const &ts) = 0;
 };
 
 class DemuxerFactory {
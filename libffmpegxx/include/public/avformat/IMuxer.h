@@ -1,14 +1,81 @@
 #pragma once
 
+#include "../time/time_defs.h"
 #include "../utils/AVOptions.h"
+#include "IOutputSink.h"
 #include "MediaInfo.h"
 
+#include <functional>
+#include <vector>
+
 namespace libffmpegxx {
 namespace avcodec {
 class IAVPacket;
 };
 
 namespace avformat {
+/**
+ * @brief The FragmentInfo struct describes a piece of fragmented output that
+ * has been completely flushed to the output.
+ */
+struct FragmentInfo {
+  /**
+   * @brief Fragment sequence number. When the moov box is written empty, the
+   * initialization segment (ftyp + moov) is reported with index 0.
+   */
+  int index;
+
+  /**
+   * @brief Byte offset of the fragment from the beginning of the output.
+   */
+  int64_t offset;
+
+  /**
+   * @brief Fragment size in bytes.
+   */
+  int64_t size;
+
+  /**
+   * @brief Presentation time of the first sample of the fragment.
+   */
+  time::Seconds startTime;
+
+  /**
+   * @brief Duration of the fragment.
+   */
+  time::Seconds duration;
+};
+
+/**
+ * @brief The FragmentationConfig struct configures the fragmented MP4 (CMAF
+ * style) output mode of a muxer.
+ */
+struct FragmentationConfig {
+  /**
+   * @brief Minimum duration of each fragment.
+   */
+  time::Seconds fragmentDuration{1.};
+
+  /**
+   * @brief Start fragments only on keyframes of the reference stream (first
+   * video stream or first stream). Equivalent to movflags frag_keyframe.
+   */
+  bool keyframeAligned{true};
+
+  /**
+   * @brief Write an initial moov box without samples so the header can be
+   * delivered before any media. Equivalent to movflags empty_moov.
+   */
+  bool emptyMoov{true};
+
+  /**
+   * @brief Called once a fragment has been flushed to the output.
+   * @note It is called from the thread calling IMuxer::write() or
+   * IMuxer::close().
+   */
+  std::function<void(FragmentInfo const &)> onFragment;
+};
+
 /**
  * @brief The IMuxer class muxer the API of a muxer.
  *
@@ -38,11 +105,50 @@ public:
    * @param packet The AVPacket to write.
    */
   virtual void write(avcodec::IAVPacket *packet) = 0;
+
+  /**
+   * @brief Writes a batch of packets into the output, in the given order.
+   * @note Timestamps are transformed into the timebases of the output
+   * streams in bulk, stream by stream, before writing.
+   * @param packets The AVPackets to write.
+   */
+  virtual void write(std::vector<avcodec::IAVPacket *> const &packets) = 0;
 };
 
 class MuxerFactory {
 public:
   static IMuxer *create(MediaInfo const &mediaInfo);
+
+  /**
+   * @brief Creates a muxer producing fragmented MP4 output. Each fragment is
+   * flushed to the output as soon as it is complete.
+   * @param mediaInfo The output media info. Format must be MP4 based (mp4,
+   * mov, ismv).
+   * @param fragmentation The fragmentation settings.
+   * @return the new muxer.
+   */
+  static IMuxer *create(MediaInfo const &mediaInfo,
+                        FragmentationConfig const &fragmentation);
+
+  /**
+   * @brief Creates a muxer writing to an output sink instead of the media
+   * info URI, which is only used for logging.
+   * @param mediaInfo The output media info. Format must be given.
+   * @param sink The output sink. Not owned, must outlive the muxer.
+   * @return the new muxer.
+   */
+  static IMuxer *create(MediaInfo const &mediaInfo, IOutputSink *sink);
+
+  /**
+   * @brief Creates a muxer producing fragmented MP4 output to an output sink.
+   * Fragment offsets are given in sink positions.
+   * @param mediaInfo The output media info. Format must be MP4 based.
+   * @param sink The output sink. Not owned, must outlive the muxer.
+   * @param fragmentation The fragmentation settings.
+   * @return the new muxer.
+   */
+  static IMuxer *create(MediaInfo const &mediaInfo, IOutputSink *sink,
+                        FragmentationConfig const &fragmentation);
 };
 }; // namespace avformat
 }; // namespace libffmpegxx
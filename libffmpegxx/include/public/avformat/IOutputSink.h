@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace libffmpegxx {
+namespace avformat {
+/**
+ * @brief The IOutputSink class defines a destination for the bytes produced
+ * by a muxer other than a URI.
+ *
+ * The muxer hands its I/O buffer to the sink every time it is flushed, so no
+ * copy is made besides the one the sink itself may need to store the data.
+ */
+class IOutputSink {
+public:
+  virtual ~IOutputSink() = default;
+
+  /**
+   * @brief Writes data at the current position.
+   * @param data The data to write. Only valid during the call.
+   * @param size The size of the data in bytes.
+   * @return the amount of bytes written or a negative FFmpeg API error code.
+   */
+  virtual int write(uint8_t const *data, int size) = 0;
+
+  /**
+   * @brief Changes the current position.
+   * @param offset The new position, relative to whence.
+   * @param whence SEEK_SET, SEEK_CUR or SEEK_END. AVSEEK_SIZE asks for the
+   * total size without moving.
+   * @return the new position (or the size) or a negative FFmpeg API error
+   * code.
+   */
+  virtual int64_t seek(int64_t offset, int whence) = 0;
+
+  /**
+   * @return true if the sink supports seeking. Muxers writing to
+   * non-seekable sinks cannot rewrite headers (i.e. MP4 needs fragmented
+   * mode).
+   */
+  virtual bool isSeekable() const = 0;
+};
+
+/**
+ * @brief The IMemoryOutputSink class is a sink storing the output in a
+ * growable memory buffer.
+ */
+class IMemoryOutputSink : public IOutputSink {
+public:
+  /**
+   * @return pointer to the stored data. Invalidated by further writes.
+   */
+  virtual uint8_t const *getData() const = 0;
+
+  /**
+   * @return the amount of bytes stored.
+   */
+  virtual size_t getSize() const = 0;
+
+  /**
+   * @return the absolute output offset of the first stored byte. It is not
+   * zero after releasing data.
+   */
+  virtual int64_t getOffset() const = 0;
+
+  /**
+   * @brief Moves the stored data out of the sink without copying it. Later
+   * writes keep using absolute output offsets, but seeking back into the
+   * released data is no longer possible.
+   * @return the stored data.
+   */
+  virtual std::vector<uint8_t> release() = 0;
+};
+
+/**
+ * @brief The OutputChunk struct describes a chunk of a chunk chain sink.
+ */
+struct OutputChunk {
+  /**
+   * @brief Chunk memory.
+   */
+  uint8_t const *data;
+
+  /**
+   * @brief Amount of bytes used in the chunk.
+   */
+  size_t size;
+};
+
+/**
+ * @brief The IChunkChainOutputSink class is a sink storing the output in a
+ * chain of fixed size chunks. Chunks are preallocated and stored data is
+ * never moved, so chunk pointers remain valid while writing.
+ */
+class IChunkChainOutputSink : public IOutputSink {
+public:
+  /**
+   * @return the chunks holding the stored data, in output order.
+   */
+  virtual std::vector<OutputChunk> getChunks() const = 0;
+
+  /**
+   * @return the amount of bytes stored.
+   */
+  virtual size_t getSize() const = 0;
+
+  /**
+   * @brief Discards the stored data keeping the chunks for reuse.
+   */
+  virtual void reset() = 0;
+};
+
+/**
+ * @brief The OutputSinkFactory class creates output sinks.
+ */
+class OutputSinkFactory {
+public:
+  using WriteCallback = std::function<int(uint8_t const *data, int size)>;
+  using SeekCallback = std::function<int64_t(int64_t offset, int whence)>;
+
+  /**
+   * @brief Creates a sink storing the output in a growable memory buffer.
+   * @param initialCapacity Bytes to reserve up front.
+   * @return the new sink.
+   */
+  static IMemoryOutputSink *createMemorySink(size_t initialCapacity = 0);
+
+  /**
+   * @brief Creates a sink forwarding the output to user callbacks.
+   * @param write Called with the muxer I/O buffer every time it is flushed.
+   * @param seek Optional. If not given the sink is not seekable.
+   * @return the new sink.
+   * @throws if the write callback is empty.
+   */
+  static IOutputSink *createCallbackSink(WriteCallback const &write,
+                                         SeekCallback const &seek = nullptr);
+
+  /**
+   * @brief Creates a sink storing the output in a chain of chunks.
+   * @param chunkSize Size of each chunk in bytes.
+   * @param chunkCount Chunks allocated up front. More are allocated if needed.
+   * @return the new sink.
+   * @throws if chunkSize is zero.
+   */
+  static IChunkChainOutputSink *createChunkChainSink(size_t chunkSize,
+                                                     size_t chunkCount);
+};
+}; // namespace avformat
+}; // namespace libffmpegxx
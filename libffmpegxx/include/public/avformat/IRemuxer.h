@@ -0,0 +1,96 @@
+#pragma once
+
+#include "../time/time_defs.h"
+#include "../utils/AVOptions.h"
+
+#include <cstdint>
+
+namespace libffmpegxx {
+namespace avformat {
+class IDemuxer;
+class IMuxer;
+
+/**
+ * @brief The RemuxStatistics struct holds the progress of a remuxing job.
+ */
+struct RemuxStatistics {
+  /**
+   * @brief Amount of packets written to the output.
+   */
+  int64_t packets{0};
+
+  /**
+   * @brief Amount of bytes written to the output.
+   */
+  int64_t bytes{0};
+
+  /**
+   * @brief Time spent remuxing so far.
+   */
+  time::Seconds elapsed{0.};
+
+  /**
+   * @brief Average throughput in megabytes (10^6 bytes) per second.
+   */
+  double throughput{0.};
+};
+
+/**
+ * @brief The IRemuxer class defines the API of a remuxer.
+ *
+ * A remuxer copies the packets read by a demuxer into a muxer without decoding
+ * them. The bitstream filters needed by the codec/container pair (i.e.
+ * h264_mp4toannexb for MP4 to MPEG-TS) are inserted automatically.
+ */
+class IRemuxer {
+public:
+  virtual ~IRemuxer() = default;
+
+  /**
+   * @brief Opens the muxer and starts remuxing on a dedicated I/O thread.
+   * @param options Muxer open options. Optional
+   * @throws if the remuxer is already running or the output cannot be opened.
+   */
+  virtual void start(utils::AVOptions const &options = {}) = 0;
+
+  /**
+   * @brief Requests the remuxing thread to stop after the current packet.
+   */
+  virtual void stop() = 0;
+
+  /**
+   * @brief Waits until remuxing is finished and closes the muxer.
+   * @return FFmpeg API error code. 0 if the whole input was remuxed.
+   */
+  virtual int wait() = 0;
+
+  /**
+   * @return true if the remuxing thread is running.
+   */
+  virtual bool isRunning() const = 0;
+
+  /**
+   * @return the statistics of the remuxing job. It can be called while
+   * running.
+   */
+  virtual RemuxStatistics getStatistics() const = 0;
+};
+
+/**
+ * @brief The RemuxerFactory class creates remuxers.
+ */
+class RemuxerFactory {
+public:
+  /**
+   * @brief Creates a remuxer.
+   * @param demuxer An opened demuxer to read from.
+   * @param muxer A not yet opened muxer to write to. Only the streams
+   * present in its MediaInfo are remuxed, matched by stream index.
+   * @note Both demuxer and muxer are still owned by the caller and must
+   * outlive the remuxer.
+   * @return the new remuxer.
+   */
+  static IRemuxer *create(IDemuxer *demuxer, IMuxer *muxer);
+};
+}; // namespace avformat
+}; // namespace libffmpegxx
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "../swscale/IScaler.h"
+#include "../time/time_defs.h"
+#include "../utils/AVOptions.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace libffmpegxx {
+namespace avformat {
+/**
+ * @brief The ThumbnailerConfig struct holds the settings of a thumbnailer.
+ */
+struct ThumbnailerConfig {
+  /**
+   * @brief Amount of thumbnails, evenly spaced over the stream duration.
+   */
+  size_t count{10};
+
+  /**
+   * @brief Thumbnail width. 0 keeps the source aspect ratio from the height,
+   * or the source width if both are 0.
+   */
+  int width{160};
+
+  /**
+   * @brief Thumbnail height. 0 keeps the source aspect ratio from the width,
+   * or the source height if both are 0.
+   */
+  int height{0};
+
+  /**
+   * @brief Sprite sheet columns. 0 makes the sheet as square as possible.
+   */
+  int columns{0};
+
+  /**
+   * @brief Image codec, i.e. AV_CODEC_ID_MJPEG (JPEG) or AV_CODEC_ID_WEBP.
+   */
+  AVCodecID codecId{AV_CODEC_ID_MJPEG};
+
+  /**
+   * @brief Image encoder options (i.e. "qscale", "quality").
+   */
+  utils::AVOptions encoderOptions;
+
+  /**
+   * @brief Threads extracting thumbnails, the calling one included. 0 uses
+   * one per core.
+   */
+  size_t threads{0};
+
+  /**
+   * @brief Whether decoding skips the loop filter and uses lowres decoding
+   * when the codec supports it and the thumbnails are small enough.
+   */
+  bool fastDecode{true};
+
+  /**
+   * @brief Demuxer options.
+   */
+  utils::AVOptions demuxerOptions;
+
+  /**
+   * @brief Decoder options.
+   */
+  utils::AVOptions decoderOptions;
+
+  /**
+   * @brief Scaling settings.
+   */
+  swscale::ScalerConfig scaling;
+};
+
+/**
+ * @brief The Thumbnail struct holds a thumbnail.
+ */
+struct Thumbnail {
+  /**
+   * @brief Requested time.
+   */
+  time::Seconds requestedTime;
+
+  /**
+   * @brief Time of the keyframe shown.
+   */
+  time::Seconds time;
+
+  /**
+   * @brief Encoded image. Empty for sprite sheet tiles.
+   */
+  std::vector<uint8_t> image;
+
+  /**
+   * @brief Position in the sprite sheet, in pixels.
+   */
+  int x{0};
+  int y{0};
+};
+
+/**
+ * @brief The SpriteSheet struct holds thumbnails tiled into one image.
+ */
+struct SpriteSheet {
+  /**
+   * @brief Encoded image.
+   */
+  std::vector<uint8_t> image;
+
+  int width{0};
+  int height{0};
+  int tileWidth{0};
+  int tileHeight{0};
+  int columns{0};
+  int rows{0};
+
+  /**
+   * @brief The tiles, in time order. Tiles whose keyframe could not be
+   * decoded are left out and stay black.
+   */
+  std::vector<Thumbnail> tiles;
+};
+
+/**
+ * @brief The IThumbnailer class defines the API of a thumbnailer.
+ *
+ * A thumbnailer picks evenly spaced times of a video stream, the middle of
+ * each of count equal parts, and shows the keyframe at or before each of
+ * them. Only keyframes are read and decoded, so the cost does not depend on
+ * the GOP length. Thumbnails are extracted in parallel, each thread with its
+ * own demuxer and decoders taken from a decoder pool.
+ */
+class IThumbnailer {
+public:
+  virtual ~IThumbnailer() = default;
+
+  /**
+   * @return a thumbnail image per time, in time order. Times whose keyframe
+   * could not be decoded are left out.
+   * @throws if the stream duration is unknown or on encoding errors.
+   */
+  virtual std::vector<Thumbnail> createThumbnails() = 0;
+
+  /**
+   * @return the thumbnails tiled into a sprite sheet, row by row.
+   * @throws if the stream duration is unknown or on encoding errors.
+   */
+  virtual SpriteSheet createSpriteSheet() = 0;
+};
+
+/**
+ * @brief The ThumbnailerFactory class creates thumbnailers.
+ */
+class ThumbnailerFactory {
+public:
+  /**
+   * @brief Creates a thumbnailer.
+   * @param uri The media URI.
+   * @param streamIdx The video stream.
+   * @param config The thumbnailer settings.
+   * @return the new thumbnailer.
+   * @throws if the media cannot be opened or has no such video stream.
+   */
+  static IThumbnailer *create(std::string const &uri, int streamIdx,
+                              ThumbnailerConfig const &config = {});
+};
+}; // namespace avformat
+}; // namespace libffmpegxx
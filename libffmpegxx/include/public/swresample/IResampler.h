@@ -0,0 +1,105 @@
+#pragma once
+
+#include "../avcodec/IDecoder.h"
+#include "../avformat/MediaInfo.h"
+#include "../time/Timebase.h"
+
+#include <cstdint>
+
+extern "C" {
+#include <libavutil/samplefmt.h>
+}
+
+namespace libffmpegxx {
+namespace avutil {
+class IAVFrame;
+}
+
+namespace swresample {
+/**
+ * @brief The AudioFormat struct describes raw audio samples. Unset values
+ * keep the input ones.
+ */
+struct AudioFormat {
+  /**
+   * @brief Samples per second. 0 keeps the input one.
+   */
+  int sampleRate{0};
+
+  /**
+   * @brief Sample format. AV_SAMPLE_FMT_NONE keeps the input one.
+   */
+  AVSampleFormat sampleFormat{AV_SAMPLE_FMT_NONE};
+
+  /**
+   * @brief Channel layout (AV_CH_LAYOUT_*). 0 keeps the input one.
+   */
+  uint64_t channelLayout{0};
+};
+
+/**
+ * @brief The IResampler class defines the API of an audio resampler.
+ *
+ * A resampler converts the sample format, rate and channel layout of audio
+ * frames and cuts the result into frames of a fixed amount of samples, as
+ * needed by encoders like AAC. Output timestamps start at the first input
+ * timestamp and then follow the amount of samples produced, so they are
+ * continuous.
+ *
+ * The resampling context is kept between frames and only rebuilt if the
+ * input format changes. Output frames come from a pool.
+ */
+class IResampler {
+public:
+  virtual ~IResampler() = default;
+
+  /**
+   * @brief Converts a frame and hands every complete output frame to the
+   * sink.
+   * @param frame The frame to convert. nullptr flushes the resampler,
+   * handing out the remaining samples as a last, shorter frame.
+   * @param sink Called once per output frame, in order.
+   * @return FFmpeg API error code. 0 if the frame was converted, AVERROR_EOF
+   * once flushed.
+   */
+  virtual int resample(avutil::IAVFrame *frame,
+                       avcodec::FrameSink const &sink) = 0;
+
+  /**
+   * @brief Drops the buffered samples, as needed after seeking. Output
+   * timestamps restart from the next input frame.
+   */
+  virtual void reset() = 0;
+
+  /**
+   * @return the timebase of the output frames, 1 / output sample rate.
+   * @throws if the output sample rate is not known yet (it keeps the input
+   * one and no frame was given yet).
+   */
+  virtual time::Timebase getTimebase() const = 0;
+};
+
+/**
+ * @brief The ResamplerFactory class creates resamplers.
+ */
+class ResamplerFactory {
+public:
+  /**
+   * @brief Creates a resampler.
+   * @param output The output format.
+   * @param frameSize Amount of samples of each output frame. 0 hands out
+   * whatever each input frame produces.
+   * @return the new resampler.
+   */
+  static IResampler *create(AudioFormat const &output, int frameSize = 0);
+
+  /**
+   * @brief Creates a resampler producing the frames an encoder expects.
+   * @param encodedStream The encoder stream info, as given by
+   * IEncoder::getStreamInfo().
+   * @return the new resampler.
+   */
+  static IResampler *create(avformat::StreamInfo const &encodedStream);
+};
+}; // namespace swresample
+}; // namespace libffmpegxx
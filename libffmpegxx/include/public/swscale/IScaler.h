@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+#include <libswscale/swscale.h>
+}
+
+namespace libffmpegxx {
+namespace avutil {
+class IAVFrame;
+}
+
+namespace swscale {
+/**
+ * @brief The ScalerConfig struct holds the settings of a scaler.
+ */
+struct ScalerConfig {
+  /**
+   * @brief Scaling algorithm (SWS_* flags).
+   */
+  int flags{SWS_BICUBIC};
+
+  /**
+   * @brief Amount of threads scaling each frame. 0 uses one per core.
+   */
+  size_t threads{1};
+
+  /**
+   * @brief Maximum amount of scaling setups (source and destination
+   * geometry) kept ready for reuse.
+   */
+  size_t maxCachedContexts{16};
+};
+
+/**
+ * @brief The IScaler class defines the API of a scaler, which resizes and
+ * converts the pixel format of video frames.
+ *
+ * Scaling contexts are cached by source and destination size and format, so
+ * switching between outputs (i.e. the sizes of an ABR ladder) does not
+ * rebuild them. Scaled frames come from a pool and their buffers go back to
+ * it once all their references are dropped.
+ *
+ * With FFmpeg 5.0 or later each frame is scaled by the swscale slice threads.
+ * Older versions split frames into bands scaled on a thread pool, as long as
+ * the conversion has no vertical scaling (i.e. pixel format conversions and
+ * horizontal resizing). Other conversions run on the calling thread.
+ *
+ * A scaler is not thread safe. Use one per thread.
+ */
+class IScaler {
+public:
+  virtual ~IScaler() = default;
+
+  /**
+   * @brief Scales a frame. Timestamps and other properties are copied from
+   * the source.
+   * @param src The frame to scale.
+   * @param width Output width.
+   * @param height Output height.
+   * @param format Output pixel format.
+   * @return the scaled frame.
+   * @throws if the conversion is not supported.
+   */
+  virtual std::shared_ptr<avutil::IAVFrame>
+  scale(avutil::IAVFrame *src, int width, int height,
+        AVPixelFormat format) = 0;
+
+  /**
+   * @return the amount of scaling contexts cached.
+   */
+  virtual size_t getCachedContextCount() const = 0;
+};
+
+/**
+ * @brief The ScalerFactory class creates scalers.
+ */
+class ScalerFactory {
+public:
+  /**
+   * @brief Creates a scaler.
+   * @param config The scaler settings.
+   * @return the new scaler.
+   */
+  static IScaler *create(ScalerConfig const &config = {});
+};
+}; // namespace swscale
+}; // namespace libffmpegxx
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "../time/time_defs.h"
+
+#include <cstdint>
+
+namespace libffmpegxx {
+namespace utils {
+/**
+ * @brief The LatencyStatistics struct summarizes the latency of a processing
+ * stage. Percentiles are computed over the most recent samples.
+ */
+struct LatencyStatistics {
+  /**
+   * @brief Amount of measured samples.
+   */
+  int64_t count{0};
+
+  time::Seconds mean{0.};
+  time::Seconds p50{0.};
+  time::Seconds p95{0.};
+  time::Seconds p99{0.};
+  time::Seconds max{0.};
+};
+}; // namespace utils
+}; // namespace libffmpegxx
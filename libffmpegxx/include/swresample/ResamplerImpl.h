@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../public/swresample/IResampler.h"
+#include "avutil/AVFramePool.h"
+
+extern "C" {
+#include <libavutil/audio_fifo.h>
+#include <libavutil/buffer.h>
+}
+
+struct SwrContext;
+
+namespace libffmpegxx {
+namespace swresample {
+class ResamplerImpl : public IResampler {
+public:
+  ResamplerImpl(AudioFormat const &output, int frameSize);
+  ~ResamplerImpl() override;
+
+  ResamplerImpl(ResamplerImpl const &) = delete;
+  ResamplerImpl &operator=(ResamplerImpl const &) = delete;
+
+  int resample(avutil::IAVFrame *frame,
+               avcodec::FrameSink const &sink) override;
+  void reset() override;
+  time::Timebase getTimebase() const override;
+
+private:
+  /**
+   * @brief Builds the resampling context and the FIFO for the input format,
+   * unless they already match it.
+   */
+  void configure(AVFrame const *input);
+
+  /**
+   * @brief Converts samples into the FIFO.
+   * @param input The samples to convert. nullptr drains the resampler.
+   * @param inputSamples Amount of input samples.
+   */
+  void convert(uint8_t const **input, int inputSamples);
+
+  /**
+   * @brief Reads samples from the FIFO into a new frame.
+   */
+  std::shared_ptr<avutil::AVFrameImpl> readFrame(int samples);
+
+  /**
+   * @brief Frees the FIFO and the buffers sized for the output format.
+   */
+  void freeBuffers();
+
+  AudioFormat m_requested;
+  int m_frameSize;
+
+  // Input format the context was built for
+  int m_inRate{0};
+  int m_inFormat{AV_SAMPLE_FMT_NONE};
+  uint64_t m_inLayout{0};
+
+  // Resolved output format
+  AudioFormat m_output;
+  int m_outChannels{0};
+
+  SwrContext *m_swrCtx{nullptr};
+  AVAudioFifo *m_fifo{nullptr};
+
+  /**
+   * @brief Conversion scratch buffer, grown when needed.
+   */
+  uint8_t **m_convertData{nullptr};
+  int m_convertCapacity{0};
+
+  AVBufferPool *m_bufferPool{nullptr};
+  avutil::AVFramePool m_framePool;
+
+  int64_t m_nextPts{AV_NOPTS_VALUE};
+};
+}; // namespace swresample
+}; // namespace libffmpegxx
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "../public/swscale/IScaler.h"
+#include "avutil/AVFramePool.h"
+#include "utils/ThreadPool.h"
+
+#include <list>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+extern "C" {
+#include <libavutil/buffer.h>
+}
+
+namespace libffmpegxx {
+namespace swscale {
+class ScalerImpl : public IScaler {
+public:
+  explicit ScalerImpl(ScalerConfig const &config = {});
+  ~ScalerImpl() override;
+
+  std::shared_ptr<avutil::IAVFrame> scale(avutil::IAVFrame *src, int width,
+                                          int height,
+                                          AVPixelFormat format) override;
+  size_t getCachedContextCount() const override;
+
+  /**
+   * @brief Same as scale(), for library internal use.
+   */
+  std::shared_ptr<avutil::AVFrameImpl> scaleFrame(avutil::AVFrameImpl *src,
+                                                  int width, int height,
+                                                  AVPixelFormat format);
+
+private:
+  /**
+   * @brief Source width, height and format, then destination ones.
+   */
+  using Key = std::tuple<int, int, int, int, int, int>;
+
+  /**
+   * @brief Rows of the frame scaled by one context. A single band covers the
+   * whole frame unless it is split for threading.
+   */
+  struct Band {
+    int y{0};
+    int height{0};
+    SwsContext *ctx{nullptr};
+  };
+
+  struct Entry {
+    Key key;
+    std::vector<Band> bands;
+    /**
+     * @brief Destination buffers. Freed once the entry is evicted and all
+     * its buffers are released.
+     */
+    AVBufferPool *bufferPool{nullptr};
+  };
+
+  Entry &getEntry(Key const &key);
+  void createBands(Entry &entry) const;
+  int getBandCount(Key const &key) const;
+  static void freeEntry(Entry &entry);
+  void scaleBand(Band const &band, AVFrame const *src, AVFrame *dst) const;
+
+  ScalerConfig m_config;
+  size_t m_threads{1};
+
+  /**
+   * @brief Most recently used first.
+   */
+  std::list<Entry> m_entries;
+  std::map<Key, std::list<Entry>::iterator> m_index;
+
+  std::unique_ptr<utils::ThreadPool> m_threadPool;
+  avutil::AVFramePool m_framePool;
+};
+}; // namespace swscale
+}; // namespace libffmpegxx
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../public/time/Timebase.h"
+
+#include <cstddef>
+#include <cstdint>
+
+struct AVPacket;
+
+namespace libffmpegxx {
+namespace time {
+/**
+ * @brief The TimestampRescaler class converts timestamps between two fixed
+ * timebases.
+ *
+ * The conversion plan is computed once at construction. When one timebase is
+ * an integer multiple of the other the conversion is a single integer
+ * multiplication or division instead of the generic 128-bit rescaling done by
+ * av_rescale_q(). Results match av_rescale_q() rounding (nearest, halfway
+ * cases away from zero). AV_NOPTS_VALUE is preserved.
+ */
+class TimestampRescaler {
+public:
+  /**
+   * @brief Identity rescaler.
+   */
+  TimestampRescaler() = default;
+
+  /**
+   * @brief TimestampRescaler constructor.
+   * @param from The timebase of the timestamps to convert.
+   * @param to The timebase to convert to.
+   */
+  TimestampRescaler(Timebase const &from, Timebase const &to);
+
+  /**
+   * @return the source timebase.
+   */
+  Timebase const &from() const;
+
+  /**
+   * @return the destination timebase.
+   */
+  Timebase const &to() const;
+
+  /**
+   * @return true if timestamps are left untouched.
+   */
+  bool isIdentity() const;
+
+  /**
+   * @brief Converts a single timestamp.
+   * @param ts The timestamp in source timebase units.
+   * @return the timestamp in destination timebase units.
+   */
+  int64_t rescale(int64_t ts) const;
+
+  /**
+   * @brief Converts a set of timestamps in place.
+   * @param ts Pointer to the first timestamp.
+   * @param count Amount of timestamps.
+   */
+  void rescale(int64_t *ts, size_t count) const;
+
+  /**
+   * @brief Converts PTS, DTS and duration of a packet in place.
+   * @param packet The packet to convert.
+   */
+  void rescale(AVPacket *packet) const;
+
+private:
+  enum class Mode { IDENTITY, MULTIPLY, DIVIDE, GENERIC };
+
+  int64_t rescaleGeneric(int64_t ts) const;
+
+  Timebase m_from;
+  Timebase m_to;
+  Mode m_mode{Mode::IDENTITY};
+  int64_t m_factor{1};
+  int64_t m_overflowLimit{INT64_MAX};
+};
+}; // namespace time
+}; // namespace libffmpegxx
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "public/utils/LatencyStatistics.h"
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace libffmpegxx {
+namespace utils {
+/**
+ * @brief The LatencyStats class accumulates latency samples of a processing
+ * stage. Memory is constant: mean and maximum cover every sample while
+ * percentiles are computed over a ring of the most recent ones.
+ */
+class LatencyStats {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief LatencyStats constructor.
+   * @param window Amount of recent samples kept for percentiles.
+   */
+  explicit LatencyStats(size_t window = 1024);
+
+  /**
+   * @brief Adds a sample.
+   * @param latency The measured latency.
+   */
+  void add(Clock::duration const &latency);
+
+  /**
+   * @brief Adds the time elapsed since the given time point as a sample.
+   * @param since The start of the measured interval.
+   */
+  void addSince(Clock::time_point const &since);
+
+  /**
+   * @return the statistics of the samples added so far.
+   */
+  LatencyStatistics get() const;
+
+  /**
+   * @brief Discards every sample.
+   */
+  void reset();
+
+private:
+  mutable std::mutex m_mutex;
+  size_t const m_window;
+  std::vector<int64_t> m_samplesNs;
+  size_t m_next{0};
+  int64_t m_count{0};
+  double m_sumNs{0.};
+  int64_t m_maxNs{0};
+};
+}; // namespace utils
+}; // namespace libffmpegxx
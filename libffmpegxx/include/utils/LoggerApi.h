@@ -3,6 +3,10 @@
 #include "../public/utils/Logger.h"
 #include "LoggerImpl.h"
 
+#define LOG_DEBUG_ENABLED                                                      \
+  (dynamic_cast<utils::LoggerImpl *>(utils::Logger::getLogger())               \
+       ->isLevelEnabled(utils::LogLevel::DEBUG))
+
 #define LOG_DEBUG(x)                                                           \
   dynamic_cast<utils::LoggerImpl *>(utils::Logger::getLogger())                \
       ->logMessage(utils::LogLevel::DEBUG, x);
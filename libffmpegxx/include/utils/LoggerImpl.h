@@ -16,6 +16,7 @@ public:
   void logMessage(LogLevel const &level, std::string const &message);
 
   LogLevel getLogLevel() const;
+  bool isLevelEnabled(LogLevel const &level) const;
   std::ostream *getOutputStream() const;
 
 private:
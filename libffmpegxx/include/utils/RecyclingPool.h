@@ -0,0 +1,214 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace libffmpegxx {
+namespace utils {
+/**
+ * @brief The RecyclingPool class keeps released objects ready for reuse.
+ *
+ * Objects are handed out as shared pointers. When the last reference is
+ * dropped the object is recycled (i.e. its data unreferenced) and kept idle
+ * under the key it was handed out with. The deleter only keeps a weak
+ * reference to the pool, so objects may outlive it; they are then simply
+ * freed. Idle objects exceeding the limits are freed least recently released
+ * first, outside of the pool lock.
+ *
+ * @tparam T The pooled type.
+ * @tparam Key What an object must match to be reused.
+ */
+template <typename T, typename Key = int> class RecyclingPool {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Prepares a released object for reuse.
+   * @return false to free the object instead.
+   */
+  using Recycler = std::function<bool(T &object)>;
+
+  struct Statistics {
+    /**
+     * @brief Takes served with an idle object.
+     */
+    int64_t hits{0};
+
+    /**
+     * @brief Takes that found no idle object.
+     */
+    int64_t misses{0};
+
+    /**
+     * @brief Idle objects freed to honour the limits.
+     */
+    int64_t evictions{0};
+
+    /**
+     * @brief Objects currently idle.
+     */
+    size_t idle{0};
+  };
+
+  /**
+   * @brief RecyclingPool constructor.
+   * @param maxIdle Maximum amount of idle objects.
+   * @param recycler Called on every released object.
+   * @param maxIdleTime Idle objects unused for longer than this are freed.
+   */
+  RecyclingPool(size_t maxIdle, Recycler recycler,
+                Clock::duration maxIdleTime = Clock::duration::max())
+      : m_state(std::make_shared<State>()) {
+    m_state->maxIdle = maxIdle;
+    m_state->maxIdleTime = maxIdleTime;
+    m_state->recycler = std::move(recycler);
+  }
+
+  /**
+   * @return the most recently released idle object matching the key, which
+   * is the most likely to be warm. nullptr if there is none.
+   */
+  std::unique_ptr<T> take(Key const &key = {}) {
+    std::unique_ptr<T> object;
+    std::vector<std::unique_ptr<T>> evicted;
+
+    std::lock_guard<std::mutex> l(m_state->mutex);
+    evicted = m_state->takeEvicted();
+
+    auto &idle = m_state->idle;
+    for (auto it = idle.rbegin(); it != idle.rend(); ++it) {
+      if (it->key == key) {
+        object = std::move(it->object);
+        idle.erase(std::next(it).base());
+        break;
+      }
+    }
+
+    if (object) {
+      ++m_state->stats.hits;
+    } else {
+      ++m_state->stats.misses;
+    }
+    m_state->stats.idle = idle.size();
+    return object;
+  }
+
+  /**
+   * @brief Hands out an object, which returns to the pool once its last
+   * reference is dropped.
+   * @tparam Base The type handed out, T or one of its bases.
+   * @param object The object, taken from the pool or new.
+   * @param key Key it is kept under once released.
+   */
+  template <typename Base = T>
+  std::shared_ptr<Base> share(std::unique_ptr<T> object,
+                              Key const &key = {}) {
+    std::weak_ptr<State> const weakState = m_state;
+    return std::shared_ptr<Base>(
+        object.release(), [weakState, key](Base *released) {
+          std::unique_ptr<T> recycled(static_cast<T *>(released));
+          if (auto const state = weakState.lock()) {
+            state->release(key, std::move(recycled));
+          }
+        });
+  }
+
+  /**
+   * @brief Frees the idle objects exceeding the limits.
+   */
+  void evict() {
+    std::vector<std::unique_ptr<T>> evicted;
+    std::lock_guard<std::mutex> l(m_state->mutex);
+    evicted = m_state->takeEvicted();
+    m_state->stats.idle = m_state->idle.size();
+  }
+
+  /**
+   * @brief Frees every idle object.
+   */
+  void clear() {
+    std::list<Idle> idle;
+    std::lock_guard<std::mutex> l(m_state->mutex);
+    m_state->stats.evictions += m_state->idle.size();
+    idle.swap(m_state->idle);
+    m_state->stats.idle = 0;
+  }
+
+  /**
+   * @return the pool usage.
+   */
+  Statistics getStatistics() const {
+    std::lock_guard<std::mutex> l(m_state->mutex);
+    return m_state->stats;
+  }
+
+  /**
+   * @return the amount of idle objects ready for reuse.
+   */
+  size_t getIdleCount() const {
+    std::lock_guard<std::mutex> l(m_state->mutex);
+    return m_state->idle.size();
+  }
+
+private:
+  struct Idle {
+    Key key;
+    std::unique_ptr<T> object;
+    Clock::time_point releaseTime;
+  };
+
+  struct State {
+    size_t maxIdle;
+    Clock::duration maxIdleTime;
+    Recycler recycler;
+
+    mutable std::mutex mutex;
+    /**
+     * @brief Least recently released first.
+     */
+    std::list<Idle> idle;
+    Statistics stats;
+
+    void release(Key const &key, std::unique_ptr<T> object) {
+      // Outside of the lock, recycling may be slow (i.e. flushing decoders)
+      if (recycler && !recycler(*object)) {
+        return;
+      }
+
+      std::vector<std::unique_ptr<T>> evicted;
+      std::lock_guard<std::mutex> l(mutex);
+      idle.push_back({key, std::move(object), Clock::now()});
+      evicted = takeEvicted();
+      stats.idle = idle.size();
+    }
+
+    /**
+     * @brief Takes out the idle objects exceeding the limits. They are freed
+     * by the caller once the lock is released.
+     */
+    std::vector<std::unique_ptr<T>> takeEvicted() {
+      std::vector<std::unique_ptr<T>> evicted;
+      auto const now = Clock::now();
+
+      while (!idle.empty() && (idle.size() > maxIdle ||
+                               now - idle.front().releaseTime > maxIdleTime)) {
+        evicted.push_back(std::move(idle.front().object));
+        idle.pop_front();
+      }
+
+      stats.evictions += evicted.size();
+      return evicted;
+    }
+  };
+
+  std::shared_ptr<State> m_state;
+};
+}; // namespace utils
+}; // namespace libffmpegxx
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace libffmpegxx {
+namespace utils {
+/**
+ * @brief The SpscQueue class is a bounded single producer, single consumer
+ * queue.
+ *
+ * Pushing and popping are lock-free ring buffer operations. The blocking
+ * variants only take a lock when they actually have to wait, so a producer
+ * and a consumer running at the same pace never contend. Closing the queue
+ * wakes up any waiter; elements already queued can still be popped.
+ */
+template <typename T> class SpscQueue {
+public:
+  /**
+   * @brief SpscQueue constructor.
+   * @param capacity Maximum amount of queued elements. At least 1.
+   */
+  explicit SpscQueue(size_t capacity)
+      : m_capacity(capacity > 0 ? capacity : 1) {
+    size_t slots = 1;
+    while (slots < m_capacity) {
+      slots <<= 1;
+    }
+    m_slots.resize(slots);
+    m_mask = slots - 1;
+  }
+
+  SpscQueue(SpscQueue const &) = delete;
+  SpscQueue &operator=(SpscQueue const &) = delete;
+
+  /**
+   * @brief Queues an element if there is room for it. Producer side only.
+   * @return false if the queue is full or closed.
+   */
+  bool tryPush(T value) { return tryMoveIn(value); }
+
+  /**
+   * @brief Dequeues an element if there is any. Consumer side only.
+   * @return false if the queue is empty.
+   */
+  bool tryPop(T &value) {
+    auto const head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    value = std::move(m_slots[head & m_mask]);
+    m_head.store(head + 1, std::memory_order_release);
+    wakeUp();
+    return true;
+  }
+
+  /**
+   * @brief Queues an element, waiting for room if the queue is full.
+   * @return false if the queue was closed.
+   */
+  bool push(T value) {
+    for (int spins = 0; !tryMoveIn(value); ++spins) {
+      if (isClosed()) {
+        return false;
+      }
+      if (spins < SPIN_COUNT) {
+        std::this_thread::yield();
+        continue;
+      }
+      wait([this] {
+        return isClosed() || m_tail.load() - m_head.load() < m_capacity;
+      });
+    }
+    return true;
+  }
+
+  /**
+   * @brief Dequeues an element, waiting for one if the queue is empty.
+   * @return false if the queue is closed and empty.
+   */
+  bool pop(T &value) {
+    for (int spins = 0; !tryPop(value); ++spins) {
+      if (isClosed()) {
+        // An element may have been pushed right before closing
+        return tryPop(value);
+      }
+      if (spins < SPIN_COUNT) {
+        std::this_thread::yield();
+        continue;
+      }
+      wait([this] { return isClosed() || m_tail.load() != m_head.load(); });
+    }
+    return true;
+  }
+
+  /**
+   * @brief Closes the queue. Further pushes fail and waiters are woken up.
+   */
+  void close() {
+    m_closed.store(true, std::memory_order_release);
+    std::lock_guard<std::mutex> l(m_mutex);
+    m_cv.notify_all();
+  }
+
+  /**
+   * @return true if the queue has been closed.
+   */
+  bool isClosed() const { return m_closed.load(std::memory_order_acquire); }
+
+  /**
+   * @return the amount of queued elements. Only a hint while both sides are
+   * running.
+   */
+  size_t size() const { return m_tail.load() - m_head.load(); }
+
+  /**
+   * @return the maximum amount of queued elements.
+   */
+  size_t capacity() const { return m_capacity; }
+
+private:
+  /**
+   * @brief Attempts made before going to sleep. The other side is usually
+   * about to make progress, so yielding is cheaper than a wait/notify pair.
+   */
+  static constexpr int SPIN_COUNT = 64;
+
+  /**
+   * @brief Moves the value into the queue only if there is room, so failed
+   * attempts can be retried with the same value.
+   */
+  bool tryMoveIn(T &value) {
+    if (m_closed.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    auto const tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) >= m_capacity) {
+      return false;
+    }
+
+    m_slots[tail & m_mask] = std::move(value);
+    m_tail.store(tail + 1, std::memory_order_release);
+    wakeUp();
+    return true;
+  }
+
+  template <typename Predicate> void wait(Predicate ready) {
+    std::unique_lock<std::mutex> l(m_mutex);
+    m_waiters.fetch_add(1);
+    // Pairs with the fence in wakeUp(): either the waker sees the waiter or
+    // the waiter sees the new state
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    m_cv.wait(l, ready);
+    m_waiters.fetch_sub(1);
+  }
+
+  void wakeUp() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiters.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> l(m_mutex);
+      m_cv.notify_all();
+    }
+  }
+
+  size_t const m_capacity;
+  size_t m_mask{0};
+  std::vector<T> m_slots;
+
+  alignas(64) std::atomic<size_t> m_head{0};
+  alignas(64) std::atomic<size_t> m_tail{0};
+  std::atomic<bool> m_closed{false};
+
+  std::atomic<int> m_waiters{0};
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+};
+}; // namespace utils
+}; // namespace libffmpegxx
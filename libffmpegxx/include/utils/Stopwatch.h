@@ -0,0 +1,58 @@
+#pragma once
+
+#include "public/time/time_defs.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace libffmpegxx {
+namespace utils {
+/**
+ * @brief The Stopwatch class measures the run time of a background job, for
+ * its statistics. It may be read from any thread while the job runs.
+ */
+class Stopwatch {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Starts measuring, discarding any previous run.
+   */
+  void start();
+
+  /**
+   * @brief Stops measuring. The elapsed time is kept until the next start.
+   */
+  void stop();
+
+  /**
+   * @return true between start() and stop().
+   */
+  bool isRunning() const;
+
+  /**
+   * @return the time elapsed since starting, up to stopping. 0 if never
+   * started.
+   */
+  time::Seconds getElapsed() const;
+
+  /**
+   * @return the average throughput in megabytes (10^6 bytes) per second
+   * over the elapsed time. 0 if no time elapsed.
+   * @param bytes Amount of bytes processed.
+   */
+  double getThroughput(int64_t bytes) const;
+
+private:
+  static int64_t nowUs();
+
+  std::atomic<bool> m_running{false};
+  std::atomic<int64_t> m_startUs{0};
+  /**
+   * @brief Run time once stopped. -1 while running or never started.
+   */
+  std::atomic<int64_t> m_elapsedUs{-1};
+};
+}; // namespace utils
+}; // namespace libffmpegxx
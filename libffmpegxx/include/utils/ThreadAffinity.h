@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+
+namespace libffmpegxx {
+namespace utils {
+/**
+ * @brief The ScopedThreadAffinity class pins the calling thread to a set of
+ * cores while alive and restores the previous affinity when destroyed.
+ *
+ * Threads created meanwhile inherit the affinity, which is how codec worker
+ * threads spawned by FFmpeg are pinned.
+ */
+class ScopedThreadAffinity {
+public:
+  /**
+   * @brief ScopedThreadAffinity constructor.
+   * @param cpus The cores to pin to. Nothing is done if empty, or with a
+   * warning if the current affinity cannot be read to restore it.
+   * @throws if the affinity cannot be set.
+   */
+  explicit ScopedThreadAffinity(std::vector<int> const &cpus);
+  ~ScopedThreadAffinity();
+
+  ScopedThreadAffinity(ScopedThreadAffinity const &) = delete;
+  ScopedThreadAffinity &operator=(ScopedThreadAffinity const &) = delete;
+
+private:
+  bool m_pinned{false};
+  std::vector<int> m_previous;
+};
+}; // namespace utils
+}; // namespace libffmpegxx
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace libffmpegxx {
+namespace utils {
+/**
+ * @brief The ThreadPool class runs tasks on a fixed set of worker threads.
+ */
+class ThreadPool {
+public:
+  /**
+   * @brief ThreadPool constructor. Workers start right away.
+   * @param threads Amount of workers. 0 uses one per core.
+   */
+  explicit ThreadPool(size_t threads = 0);
+
+  /**
+   * @brief Waits for the queued tasks and stops the workers.
+   */
+  ~ThreadPool();
+
+  ThreadPool(ThreadPool const &) = delete;
+  ThreadPool &operator=(ThreadPool const &) = delete;
+
+  /**
+   * @brief Queues a task.
+   * @param task The task to run.
+   * @return a future set once the task is done, holding the exception it
+   * threw if any.
+   */
+  std::future<void> submit(std::function<void()> task);
+
+  /**
+   * @brief Runs task(0) to task(count - 1) on the workers and the calling
+   * thread, returning once all of them are done.
+   * @param count Amount of tasks.
+   * @param task The task, given its index.
+   * @throws the first exception thrown by a task.
+   */
+  void parallelFor(size_t count, std::function<void(size_t)> const &task);
+
+  /**
+   * @return the amount of workers.
+   */
+  size_t getSize() const;
+
+  /**
+   * @param threads Amount of threads. 0 uses one per core.
+   * @return the amount of threads to use.
+   */
+  static size_t resolveThreads(size_t threads);
+
+  /**
+   * @brief Creates a pool for parallelFor calls, whose calling thread takes
+   * its share of the tasks.
+   * @param threads Amount of threads, the calling one included. 0 uses one
+   * per core.
+   * @return the pool, with one worker less than the amount of threads.
+   * nullptr if the calling thread is the only one.
+   */
+  static std::unique_ptr<ThreadPool> createForCaller(size_t threads);
+
+private:
+  void work();
+
+  std::vector<std::thread> m_workers;
+  std::queue<std::packaged_task<void()>> m_tasks;
+  bool m_stopping{false};
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+};
+}; // namespace utils
+}; // namespace libffmpegxx
@@ -0,0 +1,308 @@
+#include "swresample/ResamplerImpl.h"
+
+#include "avutil/ChannelLayout.h"
+#include "utils/LoggerApi.h"
+#include "utils/exception.h"
+
+#include <algorithm>
+#include <string>
+
+extern "C" {
+#include <libavutil/mathematics.h>
+#include <libswresample/swresample.h>
+}
+
+namespace libffmpegxx {
+namespace swresample {
+IResampler *ResamplerFactory::create(AudioFormat const &output,
+                                     int frameSize) {
+  return new ResamplerImpl(output, frameSize);
+}
+
+IResampler *
+ResamplerFactory::create(avformat::StreamInfo const &encodedStream) {
+  auto const par = *encodedStream.codecPar;
+  if (par->codec_type != AVMEDIA_TYPE_AUDIO) {
+    LOG_FATAL("Resamplers need an audio stream");
+  }
+
+  AudioFormat output;
+  output.sampleRate = par->sample_rate;
+  output.sampleFormat = static_cast<AVSampleFormat>(par->format);
+  output.channelLayout = avutil::getChannelMask(par);
+
+  // 0 for encoders accepting any amount of samples
+  return new ResamplerImpl(output, par->frame_size);
+}
+
+ResamplerImpl::ResamplerImpl(AudioFormat const &output, int frameSize)
+    : m_requested(output), m_frameSize(frameSize), m_framePool(8) {
+  if (m_frameSize < 0) {
+    LOG_FATAL("Invalid resampler frame size " + std::to_string(frameSize));
+  }
+}
+
+ResamplerImpl::~ResamplerImpl() {
+  freeBuffers();
+  swr_free(&m_swrCtx);
+}
+
+int ResamplerImpl::resample(avutil::IAVFrame *frame,
+                            avcodec::FrameSink const &sink) {
+  if (frame) {
+    auto const impl = dynamic_cast<avutil::AVFrameImpl *>(frame);
+    if (!impl) {
+      LOG_FATAL("Error handling frame while resampling");
+    }
+
+    auto const input = impl->getWrappedFrame();
+    configure(input);
+
+    if (m_nextPts == AV_NOPTS_VALUE && input->pts != AV_NOPTS_VALUE) {
+      // Samples still buffered were produced before this frame
+      auto const buffered = av_audio_fifo_size(m_fifo) +
+                            swr_get_delay(m_swrCtx, m_output.sampleRate);
+      auto const tb = frame->getTimebase();
+      m_nextPts = av_rescale_q(input->pts, {tb.num(), tb.den()},
+                               {1, m_output.sampleRate}) -
+                  buffered;
+    }
+
+    convert(const_cast<uint8_t const **>(input->extended_data),
+            input->nb_samples);
+  } else if (m_swrCtx) {
+    convert(nullptr, 0);
+  }
+
+  if (!m_fifo) {
+    return frame ? 0 : AVERROR_EOF;
+  }
+
+  auto const frameSize =
+      m_frameSize > 0 ? m_frameSize : av_audio_fifo_size(m_fifo);
+  while (frameSize > 0 && av_audio_fifo_size(m_fifo) >= frameSize) {
+    sink(readFrame(frameSize));
+  }
+
+  if (!frame) {
+    if (auto const remaining = av_audio_fifo_size(m_fifo); remaining > 0) {
+      sink(readFrame(remaining));
+    }
+    return AVERROR_EOF;
+  }
+
+  return 0;
+}
+
+void ResamplerImpl::reset() {
+  if (m_fifo) {
+    av_audio_fifo_reset(m_fifo);
+  }
+  if (m_swrCtx) {
+    // Drops the samples buffered by the resampler
+    swr_init(m_swrCtx);
+  }
+  m_nextPts = AV_NOPTS_VALUE;
+}
+
+time::Timebase ResamplerImpl::getTimebase() const {
+  auto const rate = m_output.sampleRate ? m_output.sampleRate
+                                        : m_requested.sampleRate;
+  if (rate <= 0) {
+    LOG_FATAL("The resampler output sample rate is not known yet");
+  }
+  return time::Timebase(1, rate);
+}
+
+void ResamplerImpl::configure(AVFrame const *input) {
+  auto const inLayout = avutil::getChannelMask(input);
+  if (m_swrCtx && input->sample_rate == m_inRate &&
+      input->format == m_inFormat && inLayout == m_inLayout) {
+    return;
+  }
+
+  AudioFormat output;
+  output.sampleRate =
+      m_requested.sampleRate ? m_requested.sampleRate : input->sample_rate;
+  output.sampleFormat = m_requested.sampleFormat != AV_SAMPLE_FMT_NONE
+                            ? m_requested.sampleFormat
+                            : static_cast<AVSampleFormat>(input->format);
+  output.channelLayout =
+      m_requested.channelLayout ? m_requested.channelLayout : inLayout;
+
+  if (m_swrCtx) {
+    LOG_DEBUG("Audio input format changed, rebuilding the resampler");
+    swr_free(&m_swrCtx);
+  }
+
+#if AVUTIL_HAS_CH_LAYOUT
+  {
+    // Layouts built from masks own no memory
+    AVChannelLayout outChLayout{};
+    AVChannelLayout inChLayout{};
+    av_channel_layout_from_mask(&outChLayout, output.channelLayout);
+    av_channel_layout_from_mask(&inChLayout, inLayout);
+
+    int const error = swr_alloc_set_opts2(
+        &m_swrCtx, &outChLayout, output.sampleFormat, output.sampleRate,
+        &inChLayout, static_cast<AVSampleFormat>(input->format),
+        input->sample_rate, 0, nullptr);
+    if (error < 0) {
+      LOG_FATAL_FFMPEG_ERR("Could not allocate the resampler", error);
+    }
+  }
+#else
+  m_swrCtx = swr_alloc_set_opts(
+      nullptr, static_cast<int64_t>(output.channelLayout),
+      output.sampleFormat, output.sampleRate,
+      static_cast<int64_t>(inLayout),
+      static_cast<AVSampleFormat>(input->format), input->sample_rate, 0,
+      nullptr);
+  if (!m_swrCtx) {
+    LOG_FATAL("Could not allocate the resampler");
+  }
+#endif
+
+  if (auto const err = swr_init(m_swrCtx); err < 0) {
+    swr_free(&m_swrCtx);
+    LOG_FATAL_FFMPEG_ERR("Could not initialize the resampler", err);
+  }
+
+  m_inRate = input->sample_rate;
+  m_inFormat = input->format;
+  m_inLayout = inLayout;
+
+  auto const outputChanged = !m_fifo ||
+                             output.sampleRate != m_output.sampleRate ||
+                             output.sampleFormat != m_output.sampleFormat ||
+                             output.channelLayout != m_output.channelLayout;
+  if (!outputChanged) {
+    // Buffered samples are still valid
+    return;
+  }
+
+  freeBuffers();
+  m_output = output;
+  m_outChannels = avutil::getChannelCount(output.channelLayout);
+  m_nextPts = AV_NOPTS_VALUE;
+
+  m_fifo = av_audio_fifo_alloc(output.sampleFormat, m_outChannels,
+                               std::max(m_frameSize, 1024));
+  if (!m_fifo) {
+    LOG_FATAL("Could not allocate the audio FIFO");
+  }
+
+  // Pooled buffers need fixed sized frames with a data pointer per plane
+  auto const planes =
+      av_sample_fmt_is_planar(output.sampleFormat) ? m_outChannels : 1;
+  if (m_frameSize > 0 && planes <= AV_NUM_DATA_POINTERS) {
+    auto const size = av_samples_get_buffer_size(
+        nullptr, m_outChannels, m_frameSize, output.sampleFormat, 0);
+    if (size > 0) {
+      m_bufferPool = av_buffer_pool_init(size, nullptr);
+    }
+  }
+}
+
+void ResamplerImpl::convert(uint8_t const **input, int inputSamples) {
+  auto const maxSamples = swr_get_out_samples(m_swrCtx, inputSamples);
+  if (maxSamples <= 0) {
+    return;
+  }
+
+  if (maxSamples > m_convertCapacity) {
+    if (m_convertData) {
+      av_freep(&m_convertData[0]);
+      av_freep(&m_convertData);
+    }
+    m_convertCapacity = 0;
+
+    m_convertData = static_cast<uint8_t **>(
+        av_calloc(m_outChannels, sizeof(*m_convertData)));
+    if (!m_convertData) {
+      LOG_FATAL("Could not allocate the resampling buffer");
+    }
+
+    if (auto const err =
+            av_samples_alloc(m_convertData, nullptr, m_outChannels,
+                             maxSamples, m_output.sampleFormat, 0);
+        err < 0) {
+      av_freep(&m_convertData);
+      LOG_FATAL_FFMPEG_ERR("Could not allocate the resampling buffer", err);
+    }
+    m_convertCapacity = maxSamples;
+  }
+
+  auto const converted = swr_convert(m_swrCtx, m_convertData,
+                                     m_convertCapacity, input, inputSamples);
+  if (converted < 0) {
+    LOG_FATAL_FFMPEG_ERR("Could not resample audio", converted);
+  }
+
+  if (converted > 0 &&
+      av_audio_fifo_write(m_fifo, reinterpret_cast<void **>(m_convertData),
+                          converted) < converted) {
+    LOG_FATAL("Could not buffer the resampled audio");
+  }
+}
+
+std::shared_ptr<avutil::AVFrameImpl> ResamplerImpl::readFrame(int samples) {
+  auto out = m_framePool.acquire();
+  auto const frame = out->getWrappedFrame();
+
+  frame->format = m_output.sampleFormat;
+  frame->sample_rate = m_output.sampleRate;
+  if (auto const err = avutil::setChannelMask(frame, m_output.channelLayout);
+      err < 0) {
+    LOG_FATAL_FFMPEG_ERR("Could not set the audio channel layout", err);
+  }
+
+  if (m_bufferPool && samples <= m_frameSize) {
+    frame->buf[0] = av_buffer_pool_get(m_bufferPool);
+    if (!frame->buf[0]) {
+      LOG_FATAL("Could not get an audio buffer");
+    }
+
+    // The last frame of a flush may be shorter than the buffer
+    av_samples_fill_arrays(frame->data, frame->linesize, frame->buf[0]->data,
+                           m_outChannels, m_frameSize, m_output.sampleFormat,
+                           0);
+    frame->extended_data = frame->data;
+    frame->nb_samples = samples;
+  } else {
+    frame->nb_samples = samples;
+    if (auto const err = av_frame_get_buffer(frame, 0); err < 0) {
+      LOG_FATAL_FFMPEG_ERR("Could not allocate an audio frame", err);
+    }
+  }
+
+  if (av_audio_fifo_read(m_fifo,
+                         reinterpret_cast<void **>(frame->extended_data),
+                         samples) < samples) {
+    LOG_FATAL("Could not read the buffered audio");
+  }
+
+  frame->pts = m_nextPts;
+  if (m_nextPts != AV_NOPTS_VALUE) {
+    m_nextPts += samples;
+  }
+  out->setTimebase(time::Timebase(1, m_output.sampleRate));
+
+  return out;
+}
+
+void ResamplerImpl::freeBuffers() {
+  if (m_convertData) {
+    av_freep(&m_convertData[0]);
+    av_freep(&m_convertData);
+  }
+  m_convertCapacity = 0;
+
+  if (m_fifo) {
+    av_audio_fifo_free(m_fifo);
+    m_fifo = nullptr;
+  }
+  av_buffer_pool_uninit(&m_bufferPool);
+}
+}; // namespace swresample
+}; // namespace libffmpegxx
@@ -0,0 +1,280 @@
+#include "swscale/ScalerImpl.h"
+
+#include "utils/LoggerApi.h"
+#include "utils/exception.h"
+
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/opt.h>
+#include <libavutil/pixdesc.h>
+}
+
+// Slice threading is built into swscale since FFmpeg 5.0
+#define SWS_HAS_THREADS (LIBSWSCALE_VERSION_MAJOR >= 6)
+
+namespace libffmpegxx {
+namespace swscale {
+namespace {
+constexpr int BUFFER_ALIGN = 32;
+
+/**
+ * @return the vertical subsampling of a plane.
+ */
+int planeShift(AVPixFmtDescriptor const *desc, int plane) {
+  return plane == 1 || plane == 2 ? desc->log2_chroma_h : 0;
+}
+} // namespace
+
+IScaler *ScalerFactory::create(ScalerConfig const &config) {
+  return new ScalerImpl(config);
+}
+
+ScalerImpl::ScalerImpl(ScalerConfig const &config)
+    : m_config(config),
+      m_threads(utils::ThreadPool::resolveThreads(config.threads)) {
+  m_config.maxCachedContexts = std::max<size_t>(m_config.maxCachedContexts, 1);
+
+#if !SWS_HAS_THREADS
+  m_threadPool = utils::ThreadPool::createForCaller(m_threads);
+#endif
+}
+
+ScalerImpl::~ScalerImpl() {
+  for (auto &&entry : m_entries) {
+    freeEntry(entry);
+  }
+}
+
+std::shared_ptr<avutil::IAVFrame> ScalerImpl::scale(avutil::IAVFrame *src,
+                                                    int width, int height,
+                                                    AVPixelFormat format) {
+  auto const srcImpl = dynamic_cast<avutil::AVFrameImpl *>(src);
+  if (!srcImpl) {
+    LOG_FATAL("Error handling frame while scaling");
+  }
+
+  return scaleFrame(srcImpl, width, height, format);
+}
+
+size_t ScalerImpl::getCachedContextCount() const { return m_entries.size(); }
+
+std::shared_ptr<avutil::AVFrameImpl>
+ScalerImpl::scaleFrame(avutil::AVFrameImpl *src, int width, int height,
+                       AVPixelFormat format) {
+  if (width <= 0 || height <= 0) {
+    LOG_FATAL("Invalid scaling size " + std::to_string(width) + "x" +
+              std::to_string(height));
+  }
+
+  auto const srcFrame = src->getWrappedFrame();
+  auto &entry = getEntry({srcFrame->width, srcFrame->height, srcFrame->format,
+                          width, height, format});
+
+  auto dst = m_framePool.acquire();
+  auto const dstFrame = dst->getWrappedFrame();
+  dstFrame->width = width;
+  dstFrame->height = height;
+  dstFrame->format = format;
+
+  dstFrame->buf[0] = av_buffer_pool_get(entry.bufferPool);
+  if (!dstFrame->buf[0]) {
+    LOG_FATAL("Could not allocate a " + std::to_string(width) + "x" +
+              std::to_string(height) + " scaled frame");
+  }
+  av_image_fill_arrays(dstFrame->data, dstFrame->linesize,
+                       dstFrame->buf[0]->data, format, width, height,
+                       BUFFER_ALIGN);
+  dstFrame->extended_data = dstFrame->data;
+
+  {
+    int const error = av_frame_copy_props(dstFrame, srcFrame);
+    if (error < 0) {
+      LOG_FATAL_FFMPEG_ERR("Could not copy frame properties", error);
+    }
+  }
+
+#if SWS_HAS_THREADS
+  {
+    int const error = sws_scale_frame(entry.bands.front().ctx, dstFrame,
+                                      srcFrame);
+    if (error < 0) {
+      LOG_FATAL_FFMPEG_ERR("Could not scale frame", error);
+    }
+  }
+#else
+  if (entry.bands.size() == 1) {
+    scaleBand(entry.bands.front(), srcFrame, dstFrame);
+  } else {
+    m_threadPool->parallelFor(entry.bands.size(), [&](size_t i) {
+      scaleBand(entry.bands[i], srcFrame, dstFrame);
+    });
+  }
+#endif
+
+  dst->setTimebase(src->getTimebase());
+  return dst;
+}
+
+ScalerImpl::Entry &ScalerImpl::getEntry(Key const &key) {
+  auto const it = m_index.find(key);
+  if (it != m_index.end()) {
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return m_entries.front();
+  }
+
+  if (m_entries.size() >= m_config.maxCachedContexts) {
+    freeEntry(m_entries.back());
+    m_index.erase(m_entries.back().key);
+    m_entries.pop_back();
+  }
+
+  Entry entry;
+  entry.key = key;
+
+  auto const [srcW, srcH, srcFmt, dstW, dstH, dstFmt] = key;
+  int const size = av_image_get_buffer_size(static_cast<AVPixelFormat>(dstFmt),
+                                            dstW, dstH, BUFFER_ALIGN);
+  if (size < 0) {
+    LOG_FATAL("Pixel format " + std::to_string(dstFmt) +
+              " not supported as scaling output");
+  }
+  entry.bufferPool = av_buffer_pool_init(size, av_buffer_alloc);
+
+  try {
+    createBands(entry);
+  } catch (std::runtime_error const &) {
+    freeEntry(entry);
+    throw;
+  }
+
+  m_entries.push_front(std::move(entry));
+  m_index[key] = m_entries.begin();
+
+  return m_entries.front();
+}
+
+int ScalerImpl::getBandCount(Key const &key) const {
+  auto const [srcW, srcH, srcFmt, dstW, dstH, dstFmt] = key;
+  if (m_threads <= 1 || srcH != dstH) {
+    return 1;
+  }
+
+  auto const srcDesc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(srcFmt));
+  auto const dstDesc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(dstFmt));
+  if (!srcDesc || !dstDesc) {
+    return 1;
+  }
+
+  // Bands are only exact with no vertical filtering: same height and same
+  // vertical chroma subsampling
+  auto const flags = srcDesc->flags | dstDesc->flags;
+  if ((flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_HWACCEL)) ||
+      srcDesc->log2_chroma_h != dstDesc->log2_chroma_h) {
+    return 1;
+  }
+
+  int const align = 1 << srcDesc->log2_chroma_h;
+  return static_cast<int>(
+      std::clamp<size_t>(dstH / (16 * align), 1, m_threads));
+}
+
+void ScalerImpl::createBands(Entry &entry) const {
+  auto const [srcW, srcH, srcFmt, dstW, dstH, dstFmt] = entry.key;
+
+#if SWS_HAS_THREADS
+  auto ctx = sws_alloc_context();
+  if (!ctx) {
+    LOG_FATAL("Could not allocate scaling context");
+  }
+  entry.bands.push_back({0, dstH, ctx});
+
+  av_opt_set_int(ctx, "srcw", srcW, 0);
+  av_opt_set_int(ctx, "srch", srcH, 0);
+  av_opt_set_int(ctx, "src_format", srcFmt, 0);
+  av_opt_set_int(ctx, "dstw", dstW, 0);
+  av_opt_set_int(ctx, "dsth", dstH, 0);
+  av_opt_set_int(ctx, "dst_format", dstFmt, 0);
+  av_opt_set_int(ctx, "sws_flags", m_config.flags, 0);
+  av_opt_set_int(ctx, "threads", static_cast<int64_t>(m_threads), 0);
+
+  int const error = sws_init_context(ctx, nullptr, nullptr);
+  if (error < 0) {
+    LOG_FATAL_FFMPEG_ERR("Cannot scale from " + std::to_string(srcW) + "x" +
+                             std::to_string(srcH) + " format " +
+                             std::to_string(srcFmt),
+                         error);
+  }
+#else
+  int const count = getBandCount(entry.key);
+  int const align =
+      1 << av_pix_fmt_desc_get(static_cast<AVPixelFormat>(srcFmt))
+               ->log2_chroma_h;
+  int const rows = dstH / count / align * align;
+
+  for (int i = 0; i < count; ++i) {
+    Band band;
+    band.y = i * rows;
+    band.height = i + 1 < count ? rows : dstH - band.y;
+
+    // Bands of the same height could share a context, but contexts keep
+    // scratch buffers and bands run concurrently
+    band.ctx = sws_getContext(srcW, count > 1 ? band.height : srcH,
+                              static_cast<AVPixelFormat>(srcFmt), dstW,
+                              band.height, static_cast<AVPixelFormat>(dstFmt),
+                              m_config.flags, nullptr, nullptr, nullptr);
+    if (!band.ctx) {
+      LOG_FATAL("Cannot scale from " + std::to_string(srcW) + "x" +
+                std::to_string(srcH) + " format " + std::to_string(srcFmt) +
+                " to " + std::to_string(dstW) + "x" + std::to_string(dstH) +
+                " format " + std::to_string(dstFmt));
+    }
+    entry.bands.push_back(band);
+  }
+#endif
+}
+
+void ScalerImpl::freeEntry(Entry &entry) {
+  for (auto &&band : entry.bands) {
+    sws_freeContext(band.ctx);
+  }
+  entry.bands.clear();
+
+  // Buffers still referenced keep the pool alive until released
+  av_buffer_pool_uninit(&entry.bufferPool);
+}
+
+void ScalerImpl::scaleBand(Band const &band, AVFrame const *src,
+                           AVFrame *dst) const {
+  if (band.y == 0 && band.height == dst->height) {
+    sws_scale(band.ctx, src->data, src->linesize, 0, src->height, dst->data,
+              dst->linesize);
+    return;
+  }
+
+  auto const srcDesc =
+      av_pix_fmt_desc_get(static_cast<AVPixelFormat>(src->format));
+  auto const dstDesc =
+      av_pix_fmt_desc_get(static_cast<AVPixelFormat>(dst->format));
+
+  uint8_t const *srcData[4] = {nullptr};
+  uint8_t *dstData[4] = {nullptr};
+  for (int plane = 0; plane < 4; ++plane) {
+    if (src->data[plane]) {
+      srcData[plane] = src->data[plane] +
+                       (band.y >> planeShift(srcDesc, plane)) *
+                           static_cast<ptrdiff_t>(src->linesize[plane]);
+    }
+    if (dst->data[plane]) {
+      dstData[plane] = dst->data[plane] +
+                       (band.y >> planeShift(dstDesc, plane)) *
+                           static_cast<ptrdiff_t>(dst->linesize[plane]);
+    }
+  }
+
+  sws_scale(band.ctx, srcData, src->linesize, 0, band.height, dstData,
+            dst->linesize);
+}
+}; // namespace swscale
+}; // namespace libffmpegxx
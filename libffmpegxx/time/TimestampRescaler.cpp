@@ -0,0 +1,104 @@
+#include "time/TimestampRescaler.h"
+
+#include <numeric>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/mathematics.h>
+}
+
+namespace libffmpegxx {
+namespace time {
+TimestampRescaler::TimestampRescaler(Timebase const &from, Timebase const &to)
+    : m_from(from), m_to(to) {
+  // ts * (from.num / from.den) / (to.num / to.den)
+  int64_t num = static_cast<int64_t>(from.num()) * to.den();
+  int64_t den = static_cast<int64_t>(from.den()) * to.num();
+  auto const gcd = std::gcd(num, den);
+  num /= gcd;
+  den /= gcd;
+
+  if (num == 1 && den == 1) {
+    m_mode = Mode::IDENTITY;
+  } else if (den == 1) {
+    m_mode = Mode::MULTIPLY;
+    m_factor = num;
+    m_overflowLimit = INT64_MAX / num;
+  } else if (num == 1) {
+    m_mode = Mode::DIVIDE;
+    m_factor = den;
+    m_overflowLimit = INT64_MAX - den / 2;
+  } else {
+    m_mode = Mode::GENERIC;
+  }
+}
+
+Timebase const &TimestampRescaler::from() const { return m_from; }
+
+Timebase const &TimestampRescaler::to() const { return m_to; }
+
+bool TimestampRescaler::isIdentity() const { return m_mode == Mode::IDENTITY; }
+
+int64_t TimestampRescaler::rescale(int64_t ts) const {
+  if (ts == AV_NOPTS_VALUE) {
+    return ts;
+  }
+
+  switch (m_mode) {
+  case Mode::IDENTITY:
+    return ts;
+  case Mode::MULTIPLY:
+    if (ts <= m_overflowLimit && ts >= -m_overflowLimit) {
+      return ts * m_factor;
+    }
+    break;
+  case Mode::DIVIDE:
+    if (ts <= m_overflowLimit && ts >= -m_overflowLimit) {
+      // Round to nearest, halfway cases away from zero
+      return ts >= 0 ? (ts + m_factor / 2) / m_factor
+                     : -((-ts + m_factor / 2) / m_factor);
+    }
+    break;
+  case Mode::GENERIC:
+    break;
+  }
+
+  return rescaleGeneric(ts);
+}
+
+void TimestampRescaler::rescale(int64_t *ts, size_t count) const {
+  switch (m_mode) {
+  case Mode::IDENTITY:
+    return;
+  case Mode::GENERIC:
+    for (size_t i = 0; i < count; ++i) {
+      ts[i] = ts[i] == AV_NOPTS_VALUE ? ts[i] : rescaleGeneric(ts[i]);
+    }
+    return;
+  case Mode::MULTIPLY:
+  case Mode::DIVIDE:
+    for (size_t i = 0; i < count; ++i) {
+      ts[i] = rescale(ts[i]);
+    }
+    return;
+  }
+}
+
+void TimestampRescaler::rescale(AVPacket *packet) const {
+  if (m_mode == Mode::IDENTITY) {
+    return;
+  }
+
+  packet->pts = rescale(packet->pts);
+  packet->dts = rescale(packet->dts);
+  if (packet->duration > 0) {
+    packet->duration = rescale(packet->duration);
+  }
+}
+
+int64_t TimestampRescaler::rescaleGeneric(int64_t ts) const {
+  return av_rescale_q(ts, {m_from.num(), m_from.den()},
+                      {m_to.num(), m_to.den()});
+}
+}; // namespace time
+}; // namespace libffmpegxx
@@ -0,0 +1,73 @@
+#include "utils/LatencyStats.h"
+
+#include <algorithm>
+
+namespace libffmpegxx {
+namespace utils {
+namespace {
+time::Seconds toSeconds(int64_t ns) { return time::Seconds{ns / 1e9}; }
+} // namespace
+
+LatencyStats::LatencyStats(size_t window)
+    : m_window(std::max<size_t>(window, 1)) {
+  m_samplesNs.reserve(m_window);
+}
+
+void LatencyStats::add(Clock::duration const &latency) {
+  auto const ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+
+  std::lock_guard<std::mutex> l(m_mutex);
+  if (m_samplesNs.size() < m_window) {
+    m_samplesNs.push_back(ns);
+  } else {
+    m_samplesNs[m_next] = ns;
+    m_next = (m_next + 1) % m_samplesNs.size();
+  }
+
+  ++m_count;
+  m_sumNs += ns;
+  m_maxNs = std::max(m_maxNs, ns);
+}
+
+void LatencyStats::addSince(Clock::time_point const &since) {
+  add(Clock::now() - since);
+}
+
+LatencyStatistics LatencyStats::get() const {
+  std::vector<int64_t> samples;
+  LatencyStatistics stats;
+  {
+    std::lock_guard<std::mutex> l(m_mutex);
+    if (m_count == 0) {
+      return stats;
+    }
+    samples = m_samplesNs;
+    stats.count = m_count;
+    stats.mean = toSeconds(static_cast<int64_t>(m_sumNs / m_count));
+    stats.max = toSeconds(m_maxNs);
+  }
+
+  // Nearest rank percentiles, partially sorting the same copy each time
+  auto const percentile = [&samples](double p) {
+    auto const rank = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return toSeconds(samples[rank]);
+  };
+  stats.p50 = percentile(0.50);
+  stats.p95 = percentile(0.95);
+  stats.p99 = percentile(0.99);
+
+  return stats;
+}
+
+void LatencyStats::reset() {
+  std::lock_guard<std::mutex> l(m_mutex);
+  m_samplesNs.clear();
+  m_next = 0;
+  m_count = 0;
+  m_sumNs = 0.;
+  m_maxNs = 0;
+}
+}; // namespace utils
+}; // namespace libffmpegxx
@@ -133,6 +133,12 @@ void LoggerImpl::logMessage(LogLevel const &level, std::string const &message) {
 
 LogLevel LoggerImpl::getLogLevel() const { return m_log_level; }
 
+bool LoggerImpl::isLevelEnabled(LogLevel const &) const {
+  // Library messages of every level are written to the output stream
+  std::lock_guard<std::mutex> l(g_ostreamMutex);
+  return m_output_stream != nullptr;
+}
+
 std::ostream *LoggerImpl::getOutputStream() const { return m_output_stream; }
 
 ILogger *Logger::getLogger() { return &g_logger; }
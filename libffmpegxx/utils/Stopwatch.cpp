@@ -0,0 +1,37 @@
+#include "utils/Stopwatch.h"
+
+namespace libffmpegxx {
+namespace utils {
+void Stopwatch::start() {
+  m_elapsedUs = -1;
+  m_startUs = nowUs();
+  m_running = true;
+}
+
+void Stopwatch::stop() {
+  m_elapsedUs = nowUs() - m_startUs;
+  m_running = false;
+}
+
+bool Stopwatch::isRunning() const { return m_running; }
+
+time::Seconds Stopwatch::getElapsed() const {
+  int64_t elapsedUs = m_elapsedUs;
+  if (elapsedUs < 0 && m_running) {
+    elapsedUs = nowUs() - m_startUs;
+  }
+  return time::Seconds{elapsedUs > 0 ? elapsedUs / 1e6 : 0.};
+}
+
+double Stopwatch::getThroughput(int64_t bytes) const {
+  auto const elapsed = getElapsed();
+  return elapsed.count() > 0. ? bytes / 1e6 / elapsed.count() : 0.;
+}
+
+int64_t Stopwatch::nowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             Clock::now().time_since_epoch())
+      .count();
+}
+}; // namespace utils
+}; // namespace libffmpegxx
@@ -0,0 +1,75 @@
+#include "utils/ThreadAffinity.h"
+
+#include "utils/LoggerApi.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace libffmpegxx {
+namespace utils {
+ScopedThreadAffinity::ScopedThreadAffinity(std::vector<int> const &cpus) {
+  if (cpus.empty()) {
+    return;
+  }
+
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int const cpu : cpus) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+      LOG_FATAL("Invalid core " + std::to_string(cpu) + " to pin threads to");
+    }
+    CPU_SET(cpu, &set);
+  }
+
+  cpu_set_t previous;
+  CPU_ZERO(&previous);
+  {
+    int const error =
+        pthread_getaffinity_np(pthread_self(), sizeof(previous), &previous);
+    if (error != 0) {
+      // The thread would stay pinned once out of scope
+      LOG_WARN("Could not get the thread affinity, threads are not pinned. "
+               "Error " +
+               std::to_string(error));
+      return;
+    }
+  }
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &previous)) {
+      m_previous.push_back(cpu);
+    }
+  }
+
+  int const error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (error != 0) {
+    LOG_FATAL("Could not pin threads to the given cores. Error " +
+              std::to_string(error));
+  }
+  m_pinned = true;
+#else
+  LOG_WARN("Thread pinning is not supported on this platform");
+#endif
+}
+
+ScopedThreadAffinity::~ScopedThreadAffinity() {
+#ifdef __linux__
+  if (!m_pinned) {
+    return;
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int const cpu : m_previous) {
+    CPU_SET(cpu, &set);
+  }
+
+  if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+    LOG_ERROR("Could not restore thread affinity");
+  }
+#endif
+}
+}; // namespace utils
+}; // namespace libffmpegxx
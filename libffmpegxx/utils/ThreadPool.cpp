@@ -0,0 +1,107 @@
+#include "utils/ThreadPool.h"
+
+#include <algorithm>
+
+namespace libffmpegxx {
+namespace utils {
+ThreadPool::ThreadPool(size_t threads) {
+  threads = resolveThreads(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    m_workers.emplace_back(&ThreadPool::work, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> l(m_mutex);
+    m_stopping = true;
+  }
+  m_cv.notify_all();
+
+  for (auto &&worker : m_workers) {
+    worker.join();
+  }
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> task) {
+  std::packaged_task<void()> packaged(std::move(task));
+  auto future = packaged.get_future();
+  {
+    std::lock_guard<std::mutex> l(m_mutex);
+    m_tasks.push(std::move(packaged));
+  }
+  m_cv.notify_one();
+
+  return future;
+}
+
+void ThreadPool::parallelFor(size_t count,
+                             std::function<void(size_t)> const &task) {
+  if (count == 0) {
+    return;
+  }
+
+  std::vector<std::future<void>> pending;
+  pending.reserve(count - 1);
+  for (size_t i = 1; i < count; ++i) {
+    pending.push_back(submit([&task, i] { task(i); }));
+  }
+
+  // The calling thread takes its share instead of just waiting
+  std::exception_ptr error;
+  try {
+    task(0);
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  // Every task must be done before returning, as they reference the caller
+  for (auto &&future : pending) {
+    try {
+      future.get();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+size_t ThreadPool::getSize() const { return m_workers.size(); }
+
+size_t ThreadPool::resolveThreads(size_t threads) {
+  return threads > 0 ? threads
+                     : std::max(1u, std::thread::hardware_concurrency());
+}
+
+std::unique_ptr<ThreadPool> ThreadPool::createForCaller(size_t threads) {
+  threads = resolveThreads(threads);
+  if (threads <= 1) {
+    return nullptr;
+  }
+  return std::make_unique<ThreadPool>(threads - 1);
+}
+
+void ThreadPool::work() {
+  while (true) {
+    std::packaged_task<void()> task;
+    {
+      std::unique_lock<std::mutex> l(m_mutex);
+      m_cv.wait(l, [this] { return m_stopping || !m_tasks.empty(); });
+      if (m_tasks.empty()) {
+        return;
+      }
+
+      task = std::move(m_tasks.front());
+      m_tasks.pop();
+    }
+
+    task();
+  }
+}
+}; // namespace utils
+}; // namespace libffmpegxx